@@ -0,0 +1,4 @@
+gcc -O2 -c rtree.c
+gcc rtree.o -lm -pthread
+./a.out --max-entries 16 --bench-workloads --workload-size 100000 --bench-format json --bench-out benchresults.json
+./a.out --max-entries 16 --dims 3 --bench-workloads --workload-size 100000 --bench-format csv --bench-out benchresults3d.csv
@@ -1,3 +1,3 @@
 gcc -c rtree.c
-gcc rtree.o
+gcc rtree.o -lm -pthread
 ./a.out data.txt >finaloutput.txt
\ No newline at end of file
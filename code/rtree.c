@@ -5,6 +5,21 @@
 #include <math.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 struct BoundDefiner // defines limits for each dimension
 {
@@ -23,6 +38,14 @@ int min(int x, int y) // returns lesser of x or y
 }
 
 typedef struct BoundDefiner *Bounds;
+struct Aggregate // summary of the tuples of a subtree, or of those found in a window, see the aggregates section.
+{
+    long int count; // number of tuples.
+    long long sum;  // sum of their values, 0 when the tree aggregates no value.
+    int min;        // smallest of their values, INT_MAX when there is none.
+    int max;        // largest of their values, INT_MIN when there is none.
+};
+
 struct Node // represents a node in a tree data structure.
 {
     int num_of_children_or_tuples;      // if leaf node, then num of tuples, else num of children.
@@ -30,45 +53,328 @@ struct Node // represents a node in a tree data structure.
     struct Node *parent;                // pointer to the parent node of the current node, If the current node is the root of the tree, this member will be set to NULL.
     struct Node **child_nodes;          // pointer to an array of pointers to child nodes. If the current node is a leaf node, this member will be set to NULL.
     int **list_of_tuples;               // pointer to an array of integer arrays that represent tuples stored in the leaf node. If the current node is not a leaf node, this member will be set to NULL.
+    int *entry_mins;                    // SoA layout only, NULL otherwise: for each dimension in turn, the lower bounds of the MBRs of all children, or the coordinates of all tuples of a leaf.
+    int *entry_maxs;                    // SoA layout only: for each dimension in turn, the upper bounds of the MBRs of all children. Leaves share entry_mins.
+    int entry_stride;                   // number of slots per dimension in entry_mins and entry_maxs.
+    struct Node *right_link;            // concurrent mode: the sibling last split off this node, NULL otherwise.
+    unsigned long split_stamp;          // concurrent mode: value of the split sequence of the tree when this node was last split.
+    pthread_rwlock_t *latch;            // concurrent mode only, NULL otherwise: latch held shared by readers and exclusively by the writer changing the node.
+    int **pending_tuples;               // buffered mode only, NULL otherwise: tuples waiting in this internal node to be flushed to its children. The MBR of the node covers them.
+    int num_of_pending_tuples;          // number of tuples waiting in pending_tuples.
+    bool extent_entries;                // leaves of an extent tree only: each tuple points to an extent record instead of a point, see the extent entries section.
+    struct Aggregate aggregate;         // aggregate trees only: summary of the tuples of the subtree of the node.
+};
+
+#define NODES_PER_SLAB 1024    // number of node blocks carved out of each slab of the node arena.
+#define TUPLES_PER_CHUNK 65536 // number of tuples stored in each chunk of the tuple pool.
+#define PAGE_SIZE_BYTES 4096   // node size used by --page.
+#define CACHE_LINE_BYTES 64    // cache line size used by --cache-lines.
+#define SOA_BLOCK 8            // the SoA arrays of a node are padded to a multiple of this many entries, the widest SIMD block, so that kernels never read past them.
+
+#if defined(__AVX2__)
+#define SIMD_KERNEL_NAME "AVX2"
+#elif defined(__SSE2__)
+#define SIMD_KERNEL_NAME "SSE2"
+#else
+#define SIMD_KERNEL_NAME "scalar"
+#endif
+
+#if defined(RTREE_NO_STATS) // compiles the insert and query counters out, for a build with no instrumentation overhead.
+#define RTREE_STATS_ENABLED false
+#define COUNT_STAT(counter, amount) ((void)0)
+#define COUNT_QUERY_STAT(stats, field, amount) ((void)0)
+#else
+#define RTREE_STATS_ENABLED true
+#define COUNT_STAT(counter, amount) ((counter) += (amount))
+#define COUNT_QUERY_STAT(stats, field, amount) \
+    do                                         \
+    {                                          \
+        if ((stats) != NULL)                   \
+            (stats)->field += (amount);        \
+    } while (0)
+#endif
+
+#if defined(__GNUC__)
+#define ALWAYS_INLINE static inline __attribute__((always_inline)) // forces a loop body to be inlined into each dimension-specialised caller.
+#else
+#define ALWAYS_INLINE static inline
+#endif
+
+struct NodeArena // pool allocator handing out fixed-size node blocks carved out of large slabs. Each block holds the node, its MBR and its entry array inline.
+{
+    char **slabs;           // pointer to the array of slabs allocated so far.
+    int num_of_slabs;       // number of slabs allocated so far.
+    int used_in_last_slab;  // number of blocks already handed out from the last slab.
+    size_t block_size;      // size in bytes of one node block.
+    struct Node *free_list; // released nodes available for reuse, chained through their parent pointer.
+};
+
+struct TuplePool // contiguous storage for the coordinates of every tuple in the tree, so that a tuple never needs its own allocation.
+{
+    int **chunks;            // pointer to the array of coordinate chunks allocated so far.
+    int num_of_chunks;       // number of chunks allocated so far.
+    int used_in_last_chunk;  // number of tuples already stored in the last chunk.
+    int last_chunk_capacity; // number of tuples the last chunk can hold.
+    int **free_tuples;       // slots of deleted tuples available for reuse.
+    int num_of_free_tuples;  // number of slots available for reuse.
+    int free_capacity;       // number of slots the free_tuples array can hold.
+};
+
+struct SplitArray; // scratch space used while splitting a node, defined with the split code.
+
+enum SplitPolicy // how an overflowing node distributes its entries between itself and a new sibling.
+{
+    SPLIT_QUADRATIC, // Guttman's quadratic split.
+    SPLIT_LINEAR,    // Guttman's linear split.
+    SPLIT_RSTAR      // R*-tree split, choosing the axis by margin and the distribution by overlap.
+};
+
+enum DimensionKernel // variant of the hot insert and search loops, chosen once when the tree is created.
+{
+    KERNEL_GENERIC, // loops over numofdimensions at run time.
+    KERNEL_2D,      // MBR loops fixed to 2 dimensions, so the compiler unrolls them.
+    KERNEL_3D       // MBR loops fixed to 3 dimensions, so the compiler unrolls them.
+};
+
+enum NodeLayout // how the entries of a node are stored, chosen when the tree is created.
+{
+    LAYOUT_POINTERS, // entries are only reached through their pointers.
+    LAYOUT_SOA       // the child MBRs, or the tuple coordinates, are also mirrored per dimension inside the node, so SIMD kernels test all entries at once.
+};
+
+enum InsertPolicy // how an insertion chooses its leaf and treats an overflowing node.
+{
+    INSERT_GUTTMAN, // least area enlargement, and every overflow splits the node.
+    INSERT_RSTAR    // R*-tree ChooseSubtree minimising overlap enlargement, and forced reinsertion on the first overflow of each level.
+};
+
+struct InsertCounters // structural changes made by the insert path since the tree was created. They stay 0 when compiled with -DRTREE_NO_STATS.
+{
+    unsigned long long leaf_splits;        // leaves split, one per new leaf.
+    unsigned long long internal_splits;    // internal nodes split, one per new internal node.
+    unsigned long long root_splits;        // times the tree grew a level.
+    unsigned long long forced_reinserts;   // overflows treated by R*-tree forced reinsertion instead of a split.
+    unsigned long long reinserted_entries; // entries moved out of a node and inserted again by forced reinsertion.
+    unsigned long long buffer_flushes;     // buffered mode: node buffers flushed to their children.
 };
 
 struct Rtree // struct definition for an R-Tree data structure.
 {
-    int max_entries;     // determine the maximum number of entries that can be stored in a node of the R-Tree.
-    int min_entries;     // determine the minimum number of entries that can be stored in a node of the R-Tree.
-    struct Node *root;   // pointer to the root node of the R-Tree.
-    int numofdimensions; // specifies the number of dimensions of the spatial data being indexed.
+    int max_entries;                       // determine the maximum number of entries that can be stored in a node of the R-Tree.
+    int min_entries;                       // determine the minimum number of entries that can be stored in a node of the R-Tree.
+    struct Node *root;                     // pointer to the root node of the R-Tree.
+    int numofdimensions;                   // specifies the number of dimensions of the spatial data being indexed.
+    struct NodeArena node_arena;           // arena from which every node of the R-Tree is allocated.
+    struct TuplePool tuple_pool;           // pool holding the coordinates of every tuple in the R-Tree.
+    struct SplitArray *splitArray;         // scratch space reused by every node split.
+    enum SplitPolicy split_policy;         // split algorithm used when a node overflows.
+    enum InsertPolicy insert_policy;       // leaf choice and overflow treatment used by insertions.
+    enum DimensionKernel dimension_kernel; // variant of the hot loops matching numofdimensions.
+    enum NodeLayout node_layout;           // storage of the entries of every node.
+    bool concurrent;                       // whether readers may search while writers insert, see the concurrent access section.
+    pthread_mutex_t writer_lock;           // concurrent mode: serialises the writers.
+    pthread_rwlock_t root_latch;           // concurrent mode: guards the root pointer, standing in for the latch of the parent of the root.
+    atomic_ulong split_sequence;           // concurrent mode: number of node splits so far, used to stamp split nodes.
+    int buffer_capacity;                   // buffered mode: number of tuples an internal node holds before flushing them to its children, 0 when insertions go straight to the leaves.
+    long int num_of_pending_tuples;        // buffered mode: number of tuples waiting in the buffers of all nodes.
+    struct InsertCounters insert_counters; // splits and reinsertions so far, see the statistics section.
+    bool extent_entries;                   // whether the leaves hold extent records, an MBR and a payload, instead of points. See the extent entries section.
+    bool aggregates;                       // whether every node keeps the aggregate of its subtree, see the aggregates section.
+    int aggregate_value;                   // aggregate trees: index, within each stored tuple, of the int whose sum, min and max are kept. -1 keeps only the count.
+    struct QueryCache *query_cache;        // cached range query results, NULL unless set_query_cache gave the tree a cache. See the query cache section.
 };
 
 struct Node *nodeSplit(struct Rtree *rtree, struct Node *parent_node, struct Node *child_node);   // used to split a non-leaf node of the R-Tree when it becomes too full.
 struct Node *adjust_tree(struct Rtree *rtree, struct Node *node1, struct Node *node2);            // used to adjust the R-Tree after a split has occurred.
 struct Node *nodeSplit_leaf(struct Rtree *rtree, struct Node *leaf_node, int *tuple);             // similar to nodeSplit, but is used to split a leaf node of the R-Tree.
 void addChildNode2Parent(struct Node *parent_node, struct Node *child_node, int numofdimensions); // used to add a child node to a parent node in the R-Tree.
+struct SplitArray *newSplitArray(int max_entries, int numofdimensions);                          // allocates the scratch space used by node splits.
+void freeSplitArray(struct SplitArray *splitArray);                                               // releases the scratch space used by node splits.
+void insertRstar(struct Rtree *rtree, int *tuple);                                                // inserts a stored tuple with R*-tree ChooseSubtree and forced reinsertion.
+void concurrentInsertStoredTuple(struct Rtree *rtree, int *tuple);                                // inserts a stored tuple while readers may be searching.
+void bufferedInsert(struct Rtree *rtree, int *tuple);                                             // inserts a stored tuple into the buffer of the root, flushing buffers that fill up.
+void flush_buffers(struct Rtree *rtree);                                                          // pushes every tuple waiting in a node buffer down to the leaves.
+void free_rtree(struct Rtree *rtree);                                                             // releases the R-tree together with all of its nodes and tuples.
+void invalidateQueryCache(struct Rtree *rtree, Bounds bounddefiners);                             // drops the cached windows that overlap the MBR of an update.
+void invalidateQueryCacheAtTuple(struct Rtree *rtree, int *tuple);                                // drops the cached windows containing a point that is inserted, deleted or moved.
+void clearQueryCache(struct Rtree *rtree);                                                        // drops every cached window.
+void freeQueryCache(struct QueryCache *cache);                                                    // releases a query cache with its entries.
+double getTimeInSeconds();                                                                        // returns a monotonic timestamp used by the benchmarks.
 
-struct Node *new_node(int numofdimensions) // creates a new node for an R-Tree data structure.
+struct Node *allocNodeFromArena(struct NodeArena *arena) // returns an uninitialised node block, reusing a released one when available.
 {
-    struct Node *node = malloc(sizeof(struct Node));                             // allocates memory for a new struct Node object using the malloc function.
-    node->num_of_children_or_tuples = 0;                                         // sets the initial number of children (or tuples) in the new node to 0.
-    node->bounddefiners = malloc(sizeof(struct BoundDefiner) * numofdimensions); // allocates memory for an array of struct BoundDefiner objects that will be used to define the bounds of the new node in each dimension of the space being indexed.
-    for (int i = 0; i < numofdimensions; i++)
+    if (arena->free_list != NULL)
+    {
+        struct Node *node = arena->free_list;
+        arena->free_list = node->parent;
+        return node;
+    }
+    if (arena->num_of_slabs == 0 || arena->used_in_last_slab == NODES_PER_SLAB) // the last slab is exhausted, so a new one is allocated.
+    {
+        arena->slabs = realloc(arena->slabs, sizeof(char *) * (arena->num_of_slabs + 1));
+        arena->slabs[arena->num_of_slabs++] = malloc(arena->block_size * NODES_PER_SLAB);
+        arena->used_in_last_slab = 0;
+    }
+    return (struct Node *)(arena->slabs[arena->num_of_slabs - 1] + arena->block_size * arena->used_in_last_slab++);
+}
+
+int *reserveTuples(struct TuplePool *pool, int num_of_tuples, int numofdimensions) // reserves contiguous storage for num_of_tuples tuples in the tuple pool.
+{
+    if (pool->num_of_chunks == 0 || pool->used_in_last_chunk + num_of_tuples > pool->last_chunk_capacity) // the last chunk cannot hold them, so a new one is allocated.
+    {
+        int capacity = max(num_of_tuples, TUPLES_PER_CHUNK);
+        pool->chunks = realloc(pool->chunks, sizeof(int *) * (pool->num_of_chunks + 1));
+        pool->chunks[pool->num_of_chunks++] = malloc(sizeof(int) * numofdimensions * (size_t)capacity);
+        pool->used_in_last_chunk = 0;
+        pool->last_chunk_capacity = capacity;
+    }
+    int *tuples = pool->chunks[pool->num_of_chunks - 1] + (size_t)pool->used_in_last_chunk * numofdimensions;
+    pool->used_in_last_chunk += num_of_tuples;
+    return tuples;
+}
+
+int *storeTuple(struct Rtree *rtree, int *tuple) // copies a tuple into the tuple pool of the R-Tree and returns the stored copy.
+{
+    struct TuplePool *pool = &rtree->tuple_pool;
+    int *stored_tuple = (pool->num_of_free_tuples > 0) ? pool->free_tuples[--pool->num_of_free_tuples] : reserveTuples(pool, 1, rtree->numofdimensions); // reuses the slot of a deleted tuple when there is one.
+    memcpy(stored_tuple, tuple, sizeof(int) * rtree->numofdimensions);
+    return stored_tuple;
+}
+
+void releaseTuple(struct TuplePool *pool, int *tuple) // hands the slot of a deleted tuple back to the tuple pool for reuse.
+{
+    if (pool->num_of_free_tuples == pool->free_capacity)
+    {
+        pool->free_capacity = (pool->free_capacity == 0) ? 64 : pool->free_capacity * 2;
+        pool->free_tuples = realloc(pool->free_tuples, sizeof(int *) * pool->free_capacity);
+    }
+    pool->free_tuples[pool->num_of_free_tuples++] = tuple;
+}
+
+struct Node *new_node(struct Rtree *rtree, bool leaf) // creates a new node for an R-Tree data structure.
+{
+    struct Node *node = allocNodeFromArena(&rtree->node_arena); // takes a block for the new node from the node arena.
+    node->num_of_children_or_tuples = 0;                        // sets the initial number of children (or tuples) in the new node to 0.
+    node->bounddefiners = (struct BoundDefiner *)(node + 1);    // the MBR of the node is stored inline right after the node.
+    for (int i = 0; i < rtree->numofdimensions; i++)
     {
         node->bounddefiners[i].dmax = INT_MIN;
         node->bounddefiners[i].dmin = INT_MAX;
     }
-    node->child_nodes = NULL;    // sets the initial pointer to the child nodes of the new node to NULL.
-    node->parent = NULL;         // sets the initial pointer to the parent node of the new node to NULL.
-    node->list_of_tuples = NULL; // sets the initial pointer to the list of tuples in the new node to NULL.
-    return node;                 // returns a pointer to the new node.
+    void **entries = (void **)(node->bounddefiners + rtree->numofdimensions); // the max_entries entry slots are stored inline right after the MBR.
+    node->child_nodes = leaf ? NULL : (struct Node **)entries;                // only internal nodes use the entry slots for child nodes.
+    node->parent = NULL;                                                      // sets the initial pointer to the parent node of the new node to NULL.
+    node->list_of_tuples = leaf ? (int **)entries : NULL;                     // only leaf nodes use the entry slots for tuples.
+    node->entry_mins = node->entry_maxs = NULL;
+    node->entry_stride = 0;
+    if (rtree->node_layout == LAYOUT_SOA) // the per-dimension arrays follow the entry slots.
+    {
+        node->entry_stride = (rtree->max_entries + SOA_BLOCK - 1) / SOA_BLOCK * SOA_BLOCK;
+        node->entry_mins = (int *)(entries + rtree->max_entries);
+        node->entry_maxs = leaf ? node->entry_mins : node->entry_mins + rtree->numofdimensions * node->entry_stride;
+    }
+    node->right_link = NULL;
+    node->split_stamp = 0;
+    node->latch = NULL;
+    if (rtree->concurrent) // the latch follows the entry slots, concurrent trees always using the pointer layout.
+    {
+        node->latch = (pthread_rwlock_t *)(entries + rtree->max_entries);
+        pthread_rwlock_init(node->latch, NULL);
+    }
+    node->pending_tuples = NULL; // buffered mode allocates the buffer of an internal node when a tuple first waits in it.
+    node->num_of_pending_tuples = 0;
+    node->extent_entries = leaf && rtree->extent_entries;
+    node->aggregate = (struct Aggregate){0, 0, INT_MAX, INT_MIN};
+    return node; // returns a pointer to the new node.
 }
 
-struct Rtree *new_rtree(int max_entries, int min_entries, int numofdimensions) // creates a new R-Tree data structure.
+void free_node(struct Rtree *rtree, struct Node *node) // returns a node to the node arena so that its block can be reused.
+{
+    free(node->pending_tuples);
+    node->parent = rtree->node_arena.free_list;
+    rtree->node_arena.free_list = node;
+}
+
+void syncEntry(struct Node *node, int index, int numofdimensions) // SoA layout: copies the coordinates of the tuple, or the MBR of the child node, at index into the per-dimension arrays of the node.
+{
+    if (node->entry_mins == NULL)
+        return;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        if (node->list_of_tuples != NULL)
+        {
+            node->entry_mins[i * node->entry_stride + index] = node->list_of_tuples[index][i];
+        }
+        else
+        {
+            node->entry_mins[i * node->entry_stride + index] = node->child_nodes[index]->bounddefiners[i].dmin;
+            node->entry_maxs[i * node->entry_stride + index] = node->child_nodes[index]->bounddefiners[i].dmax;
+        }
+    }
+}
+
+void syncBoundsToParent(struct Node *node, int numofdimensions) // SoA layout: refreshes the copy of the MBR of a node held by its parent, after the MBR changed.
+{
+    struct Node *parent_node = node->parent;
+    if (node->entry_mins == NULL || parent_node == NULL || parent_node->child_nodes == NULL)
+        return;
+    for (int j = 0; j < parent_node->num_of_children_or_tuples; j++)
+    {
+        if (parent_node->child_nodes[j] == node)
+        {
+            syncEntry(parent_node, j, numofdimensions);
+            return;
+        }
+    }
+}
+
+struct Rtree *new_rtree_with_layout(int max_entries, int min_entries, int numofdimensions, enum NodeLayout node_layout) // creates a new R-Tree data structure whose nodes use the given layout.
 {
     struct Rtree *rtree = malloc(sizeof(struct Rtree)); // allocates memory for a new struct Rtree object using the malloc function.
     rtree->max_entries = max_entries;                   // sets the maximum number of entries that a node in the R-Tree can hold to the value passed as an argument.
     rtree->min_entries = min_entries;                   // sets the minimum number of entries that a node in the R-Tree must have before it can be split to the value passed as an argument.
     rtree->numofdimensions = numofdimensions;           // sets the number of dimensions in the space being indexed by the R-Tree to the value passed as an argument.
     rtree->root = NULL;                                 // sets the initial pointer to the root node of the R-Tree to NULL.
-    return rtree;                                       // returns a pointer to the new R-Tree.
+
+    size_t block_size = sizeof(struct Node) + sizeof(struct BoundDefiner) * numofdimensions + sizeof(void *) * max_entries;
+    if (node_layout == LAYOUT_SOA) // room for the lower and upper bound arrays.
+        block_size += sizeof(int) * 2 * numofdimensions * ((max_entries + SOA_BLOCK - 1) / SOA_BLOCK * SOA_BLOCK);
+    rtree->node_arena = (struct NodeArena){NULL, 0, 0, (block_size + 7) & ~(size_t)7, NULL}; // node blocks are kept 8-byte aligned.
+    rtree->tuple_pool = (struct TuplePool){NULL, 0, 0, 0, NULL, 0, 0};
+    rtree->splitArray = newSplitArray(max_entries, numofdimensions);
+    rtree->split_policy = SPLIT_QUADRATIC;
+    rtree->insert_policy = INSERT_GUTTMAN;
+    rtree->dimension_kernel = (numofdimensions == 2) ? KERNEL_2D : (numofdimensions == 3) ? KERNEL_3D : KERNEL_GENERIC;
+    rtree->node_layout = node_layout;
+    rtree->concurrent = false;
+    rtree->buffer_capacity = 0;
+    rtree->num_of_pending_tuples = 0;
+    rtree->insert_counters = (struct InsertCounters){0, 0, 0, 0, 0, 0};
+    rtree->extent_entries = false;
+    rtree->aggregates = false;
+    rtree->aggregate_value = -1;
+    rtree->query_cache = NULL;
+    return rtree; // returns a pointer to the new R-Tree.
+}
+
+struct Rtree *new_rtree(int max_entries, int min_entries, int numofdimensions) // creates a new R-Tree data structure.
+{
+    return new_rtree_with_layout(max_entries, min_entries, numofdimensions, LAYOUT_POINTERS);
+}
+
+int getFanoutForNodeBytes(size_t node_bytes, int numofdimensions) // largest fan-out whose entries, an MBR and a pointer each, fit in a node of the given size together with the node header and its own MBR.
+{
+    size_t header_size = sizeof(struct Node) + sizeof(struct BoundDefiner) * numofdimensions;
+    size_t entry_size = sizeof(struct BoundDefiner) * numofdimensions + sizeof(void *);
+    if (node_bytes < header_size + 4 * entry_size) // nodes are never made smaller than the original fan-out of 4.
+        return 4;
+    return (int)((node_bytes - header_size) / entry_size);
+}
+
+int getDefaultMinEntries(int max_entries) // minimum fill used when only the fan-out is given: 40% of it, which the R*-tree paper found to work best, but at least 2 where the fan-out allows.
+{
+    int min_entries = max_entries * 2 / 5;
+    return (min_entries >= 2) ? min_entries : max(1, min(2, max_entries / 2));
 }
 
 long int getArea(int numofdimensions, Bounds bounddefiners) // calculates the area of an MBR (minimum bounding rectangle) in a multi-dimensional space.
@@ -81,16 +387,24 @@ long int getArea(int numofdimensions, Bounds bounddefiners) // calculates the ar
     return area; // returns the final calculated area of the MBR.
 }
 
-Bounds get_bounding_box(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) // calculates the bounding box (MBR) that contains two given MBRs in a multi-dimensional space.
+bool enlargeMBR(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) // enlarges the first MBR in place so that it also contains the second one. Returns true if the first MBR changed.
 {
-    Bounds bounding_box = malloc(sizeof(struct BoundDefiner) * numofdimensions); // creates an array bounding_box of BoundDefiner structs to hold the boundaries of the resulting bounding box.
+    bool changed = false;
     for (int i = 0; i < numofdimensions; i++)
     {
-        bounding_box[i].dmin = min(bounddefiners[i].dmin, bounddefiners2[i].dmin); // sets the minimum boundary of the resulting bounding box for the current dimension to the minimum of the corresponding boundaries of the two input MBRs.
-        bounding_box[i].dmax = max(bounddefiners[i].dmax, bounddefiners2[i].dmax); // sets the maximum boundary of the resulting bounding box for the current dimension to the maximum of the corresponding boundaries of the two input MBRs.
+        if (bounddefiners2[i].dmin < bounddefiners[i].dmin) // lowers the minimum boundary of the current dimension if the second MBR extends below it.
+        {
+            bounddefiners[i].dmin = bounddefiners2[i].dmin;
+            changed = true;
+        }
+        if (bounddefiners2[i].dmax > bounddefiners[i].dmax) // raises the maximum boundary of the current dimension if the second MBR extends above it.
+        {
+            bounddefiners[i].dmax = bounddefiners2[i].dmax;
+            changed = true;
+        }
     }
-    return bounding_box; // returns the final calculated bounding box.
-};
+    return changed;
+}
 
 int intersects(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) //  calculate the area increased from the second MBR if the first MBR intersects with it, which can be used to determine which MBRs to choose for a given search or insertion operation.
 {
@@ -140,36 +454,105 @@ int checkIfTupleInBounds(Bounds bounddefiners, int *tuple, int numofdimensions)
     return 1;
 }
 
-searchResult searchTuplesInGivenBounds(int numofdimensions, Bounds bounddefiners, struct Node *node) // used to search for tuples that fall within a given bounding box.
+enum SpatialPredicate // how an entry must relate to the query window to be reported.
 {
-    if (intersects(numofdimensions, bounddefiners, node->bounddefiners) == -1) // checks if the given bounding box intersects with the bounding box of the current node.
+    PREDICATE_INTERSECTS, // the entry and the window share at least one point.
+    PREDICATE_CONTAINS,   // the entry contains the whole window.
+    PREDICATE_WITHIN      // the entry lies entirely inside the window. For points, this and PREDICATE_INTERSECTS are the same test.
+};
+
+Bounds getExtentBounds(int *tuple) // returns the MBR of an extent record, which starts with one BoundDefiner per dimension.
+{
+    return (Bounds)tuple;
+}
+
+bool matchesPredicate(int numofdimensions, Bounds bounddefiners, Bounds entry_bounds, enum SpatialPredicate predicate) // checks whether an entry with the given MBR relates to the window as the predicate asks.
+{
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        bool matches;
+        if (predicate == PREDICATE_CONTAINS)
+            matches = entry_bounds[i].dmin <= bounddefiners[i].dmin && entry_bounds[i].dmax >= bounddefiners[i].dmax;
+        else if (predicate == PREDICATE_WITHIN)
+            matches = entry_bounds[i].dmin >= bounddefiners[i].dmin && entry_bounds[i].dmax <= bounddefiners[i].dmax;
+        else
+            matches = entry_bounds[i].dmin <= bounddefiners[i].dmax && entry_bounds[i].dmax >= bounddefiners[i].dmin;
+        if (!matches)
+            return false;
+    }
+    return true;
+}
+
+bool mayHoldMatches(int numofdimensions, Bounds bounddefiners, Bounds node_bounds, enum SpatialPredicate predicate) // checks whether the subtree of a node with the given MBR can hold an entry matching the predicate. An entry containing the window makes every MBR above it contain the window too, the other predicates only need the MBR to overlap it.
+{
+    return matchesPredicate(numofdimensions, bounddefiners, node_bounds, (predicate == PREDICATE_CONTAINS) ? PREDICATE_CONTAINS : PREDICATE_INTERSECTS);
+}
+
+bool entryMatchesPredicate(struct Node *leaf_node, int *tuple, int numofdimensions, Bounds bounddefiners, enum SpatialPredicate predicate) // checks a tuple of a leaf, or of a buffer, against the window. A point is its own degenerate MBR.
+{
+    if (leaf_node->extent_entries)
+        return matchesPredicate(numofdimensions, bounddefiners, getExtentBounds(tuple), predicate);
+    if (predicate != PREDICATE_CONTAINS)
+        return checkIfTupleInBounds(bounddefiners, tuple, numofdimensions);
+    for (int i = 0; i < numofdimensions; i++) // a point only contains a window shrunk to that point.
+    {
+        if (bounddefiners[i].dmin != tuple[i] || bounddefiners[i].dmax != tuple[i])
+            return false;
+    }
+    return true;
+}
+
+struct QueryCounters // work done by range searches, accumulated by searchTuplesInGivenBoundsWithCounters. They stay 0 when compiled with -DRTREE_NO_STATS.
+{
+    unsigned long long nodes_visited;       // nodes whose MBR was tested against the window.
+    unsigned long long leaves_scanned;      // leaves whose tuples were tested against the window.
+    unsigned long long false_positive_hits; // nodes whose MBR overlapped the window although their subtree held no tuple inside it.
+    unsigned long long results;             // tuples found.
+};
+
+searchResult searchEntriesWithPredicate(int numofdimensions, Bounds bounddefiners, enum SpatialPredicate predicate, struct Node *node, struct QueryCounters *counters) // collects the tuples, or extent records, of the subtree of node that relate to the window as the predicate asks, adding the work done to counters, which may be NULL.
+{
+    COUNT_QUERY_STAT(counters, nodes_visited, 1);
+    if (!mayHoldMatches(numofdimensions, bounddefiners, node->bounddefiners, predicate)) // checks if the bounding box of the current node can hold a match.
     {
         return NULL;
     }
     else
     {
+        searchResult result;
         if (is_leaf(node)) // checks if the current node is a leaf node or an internal node.
         {
             int **list_of_tuples = NULL;
             int numofresults = 0;
             for (int i = 0; i < node->num_of_children_or_tuples; i++) // iterates over each tuple in the node and checks if it falls within the given bounds.
             {
-                if (checkIfTupleInBounds(bounddefiners, node->list_of_tuples[i], numofdimensions))
+                if (entryMatchesPredicate(node, node->list_of_tuples[i], numofdimensions, bounddefiners, predicate))
                 {
                     list_of_tuples = realloc(list_of_tuples, sizeof(int *) * (numofresults + 1));
                     list_of_tuples[numofresults] = node->list_of_tuples[i]; //  tuple is added to the list_of_tuples array
                     numofresults++;
                 }
             }
-            return createSearchResult(list_of_tuples, numofresults);
+            COUNT_QUERY_STAT(counters, leaves_scanned, 1);
+            COUNT_QUERY_STAT(counters, results, numofresults);
+            result = createSearchResult(list_of_tuples, numofresults);
         }
         else
         {
             int **list_of_tuples = NULL;
             int numofresults = 0;
+            for (int i = 0; i < node->num_of_pending_tuples; i++) // buffered mode: the tuples waiting in the node are part of its subtree.
+            {
+                if (entryMatchesPredicate(node, node->pending_tuples[i], numofdimensions, bounddefiners, predicate))
+                {
+                    list_of_tuples = realloc(list_of_tuples, sizeof(int *) * (numofresults + 1));
+                    list_of_tuples[numofresults++] = node->pending_tuples[i];
+                    COUNT_QUERY_STAT(counters, results, 1);
+                }
+            }
             for (int i = 0; i < node->num_of_children_or_tuples; i++)
             {
-                searchResult searchresultfromchild = searchTuplesInGivenBounds(numofdimensions, bounddefiners, node->child_nodes[i]);
+                searchResult searchresultfromchild = searchEntriesWithPredicate(numofdimensions, bounddefiners, predicate, node->child_nodes[i], counters);
                 if (searchresultfromchild != NULL)
                 {
                     list_of_tuples = realloc(list_of_tuples, sizeof(int *) * (numofresults + searchresultfromchild->num_of_tuples));
@@ -178,605 +561,7761 @@ searchResult searchTuplesInGivenBounds(int numofdimensions, Bounds bounddefiners
                         list_of_tuples[numofresults] = searchresultfromchild->list_of_tuples[j];
                         numofresults++;
                     }
+                    free(searchresultfromchild->list_of_tuples); // the tuples of the child result have been copied, so the child result is released.
+                    free(searchresultfromchild);
                 }
             }
-            return createSearchResult(list_of_tuples, numofresults); // creating a data structure to store the tuples in list_of_tuples.
+            result = createSearchResult(list_of_tuples, numofresults); // creating a data structure to store the tuples in list_of_tuples.
         }
+        if (result->num_of_tuples == 0) // the MBR overlapped the window for nothing.
+            COUNT_QUERY_STAT(counters, false_positive_hits, 1);
+        return result;
     }
 }
 
-void printTuple(int *tuple, int numofdimensions)
+searchResult searchTuplesInGivenBoundsWithCounters(int numofdimensions, Bounds bounddefiners, struct Node *node, struct QueryCounters *counters) // searchTuplesInGivenBounds adding its work to counters, which may be NULL.
 {
-    printf("(");                              // Print a left parenthesis
-    for (int i = 0; i < numofdimensions; i++) // Loop through each dimension in the tuple
-    {
-        printf("%d", tuple[i]);       // Print the current element
-        if (i != numofdimensions - 1) // Checks if this is not the last dimenstion in the tuple
-        {
-            printf(", "); // Print a comma and a space to separate the elements
-        }
-    }
-    printf(")"); // Print a right parenthesis
+    return searchEntriesWithPredicate(numofdimensions, bounddefiners, PREDICATE_INTERSECTS, node, counters);
 }
 
-void searchRTree(Bounds bounddefiners, struct Rtree *rtree) // searches for tuples within the bounding box by calling the searchTuplesInGivenBounds.
+searchResult searchTuplesInGivenBounds(int numofdimensions, Bounds bounddefiners, struct Node *node) // used to search for tuples that fall within a given bounding box, or the extents that intersect it.
 {
-    if (rtree->root == NULL)
-    {
-        printf("Tree empty\n");
-        return;
-    }
-    searchResult result = searchTuplesInGivenBounds(rtree->numofdimensions, bounddefiners, rtree->root);
-    if (result == NULL)
-    {
-        printf("No tuples found in given bounds\n");
-    }
-    else
-    {
-        printf("%d Tuple(s) found in given bounds :\n", result->num_of_tuples);
-        for (int i = 0; i < result->num_of_tuples; i++)
-        {
-            printTuple(result->list_of_tuples[i], rtree->numofdimensions);
-            printf("\n");
-        }
-    }
+    return searchTuplesInGivenBoundsWithCounters(numofdimensions, bounddefiners, node, NULL);
 }
 
-void printInternalNodeFromBounds(Bounds bounddefiners, int numofdimensions) // used to print the bounds of internal nodes i.e print all min() and max() values
+bool overlaps(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) // checks whether two MBRs overlap, without computing any area.
 {
-    int *min = malloc(sizeof(int) * numofdimensions); // allocates memory for min array min ,of size numofdimensions, to store the minimum values for each dimension.
-    int *max = malloc(sizeof(int) * numofdimensions); // allocates memory for max array max ,of size numofdimensions, to store the maximum values for each dimension.
-    for (int i = 0; i < numofdimensions; i++)         // loops through each dimension and assigns the minimum and maximum values of that dimension to the min and max arrays respectively.
+    for (int i = 0; i < numofdimensions; i++)
     {
-        min[i] = bounddefiners[i].dmin;
-        max[i] = bounddefiners[i].dmax;
+        if (bounddefiners[i].dmin > bounddefiners2[i].dmax || bounddefiners[i].dmax < bounddefiners2[i].dmin)
+            return false;
     }
-    printTuple(min, numofdimensions); // prints the min array
-    printf(" ");
-    printTuple(max, numofdimensions); // prints the max array
-    printf("\n");
+    return true;
 }
 
-void printNode(struct Node *node, int numofdimensions, int depth) // prints the contents of a given node
+void fillWholeSpace(Bounds bounddefiners, int numofdimensions) // sets the bounds to a window covering every possible tuple.
 {
-    for (int i = 0; i < depth; i++)
-    {
-        printf(" ");
-    }
-    printf("[%d] ", depth);
-    if (is_leaf(node))
-    {
-        printf("Leaf Node: ");
-        for (int i = 0; i < node->num_of_children_or_tuples; i++)
-        {
-            printTuple(node->list_of_tuples[i], numofdimensions);
-            printf(" ");
-        }
-        printf("\n");
-    }
-    else
+    for (int i = 0; i < numofdimensions; i++)
     {
-        printf("Internal Node with %d children. Bounds: ", node->num_of_children_or_tuples);
-        printInternalNodeFromBounds(node->bounddefiners, numofdimensions);
-        for (int i = 0; i < node->num_of_children_or_tuples; i++)
-        {
-            printNode(node->child_nodes[i], numofdimensions, depth + 1);
-        }
+        bounddefiners[i].dmin = INT_MIN;
+        bounddefiners[i].dmax = INT_MAX;
     }
 }
 
-void printRtree(struct Rtree *rtree) // prints the contents of the R-tree
+int getTreeHeight(struct Node *node) // returns the number of levels below and including the given node. All leaves of an R-tree are at the same level.
 {
-    if (rtree->root == NULL)
+    int height = 1;
+    while (!is_leaf(node))
     {
-        printf("Tree empty\n");
-        return;
+        node = node->child_nodes[0];
+        height++;
     }
-    printNode(rtree->root, rtree->numofdimensions, 0);
+    return height;
 }
 
-long int getAreaEnlargedOnInclusion(int numofdimensions, Bounds bounddefiners, int *tuple) // calculates the area enlarged on inclusion of a new tuple within the given bounding box
-// new method for area enlarged on inclusion
+// Streaming search
+// The tree is walked iteratively with an explicit stack holding one frame per level, so that a query does no heap allocation.
+// Every tuple found is handed to a visitor instead of being collected, and the visitor can stop the search by returning false.
+
+typedef bool (*SearchVisitor)(int *tuple, void *context); // receives each tuple found by a search. Returning false stops the search early.
+
+struct SearchFrame // one level of the explicit stack used by the streaming search.
 {
-    long int orig_area = getArea(numofdimensions, bounddefiners); // original area of the bounding box is calculated using the getArea function.
-    long int new_area = 1;
+    struct Node *node; // node being scanned at this level.
+    int next_child;    // index of the next child of the node to descend into.
+};
 
-    for (int i = 0; i < numofdimensions; i++)
+ALWAYS_INLINE bool visitPendingTuples(int numofdimensions, Bounds bounddefiners, struct Node *node, SearchVisitor visitor, void *context, long int *numofresults) // buffered mode: streams the tuples waiting in an internal node that lie in the given bounds. Returns false if the visitor asked to stop.
+{
+    for (int i = 0; i < node->num_of_pending_tuples; i++)
     {
-        if (tuple[i] < bounddefiners[i].dmin)
-            new_area *= (bounddefiners[i].dmax - tuple[i]);
-        else if (tuple[i] > bounddefiners[i].dmax)
-            new_area *= (tuple[i] - bounddefiners[i].dmin);
-        // If the new tuple lies outside the existing bounding box in a dimension, the area added is calculated as the difference between the new tuple's value and the corresponding boundary value.
-        else
-            new_area *= bounddefiners[i].dmax - bounddefiners[i].dmin;
-        //  If the new tuple lies inside the existing bounding box in a dimension, the area added is calculated as the width of the dimension of the bounding box that the new tuple falls within.
+        if (checkIfTupleInBounds(bounddefiners, node->pending_tuples[i], numofdimensions))
+        {
+            (*numofresults)++;
+            if (visitor != NULL && !visitor(node->pending_tuples[i], context))
+                return false;
+        }
     }
-    return new_area - orig_area; // returns area enlarged
+    return true;
 }
 
-struct Node *chooseLeaf(int *tuple, struct Node *node, int numofdimensions) // selects a leaf node in which the given tuple should be inserted.
+ALWAYS_INLINE long int searchTuplesInDimensions(int numofdimensions, Bounds bounddefiners, struct Node *root, SearchVisitor visitor, void *context) // body of searchTuplesStreaming, inlined into one copy per dimension kernel so that a constant numofdimensions unrolls the bounds checks.
 {
-    if (is_leaf(node)) // if the current node is a leaf node, then it is returned as the selected leaf node.
-    {
-        return node;
-    }
-    else
+    if (root == NULL || !overlaps(numofdimensions, bounddefiners, root->bounddefiners))
+        return 0;
+
+    struct SearchFrame stack[getTreeHeight(root)]; // one frame per level is enough for a depth-first walk.
+    int top = 0;
+    stack[0].node = root;
+    stack[0].next_child = 0;
+    long int numofresults = 0;
+
+    while (top >= 0)
     {
-        long int minarea = LONG_MAX;
-        int minareaindex = -1;
-        long int minareaenlargedoninclusion = LONG_MAX;
-        for (int i = 0; i < node->num_of_children_or_tuples; i++) // for each child node of the current node, calculates the area enlarged on inclusion if the tuple is added to the child node's bounds.
+        struct SearchFrame *frame = &stack[top];
+        struct Node *node = frame->node;
+        if (is_leaf(node)) // scans the tuples of a leaf and pops it.
         {
-            long int areaenlargedoninclusion = getAreaEnlargedOnInclusion(numofdimensions, node->child_nodes[i]->bounddefiners, tuple);
-            if (areaenlargedoninclusion < minareaenlargedoninclusion) // selects the child node that results in the minimum area enlargement on inclusion.
-            {
-                minareaenlargedoninclusion = areaenlargedoninclusion;
-                minareaindex = i;
-            }
-            else if (areaenlargedoninclusion == minareaenlargedoninclusion) // If there is a tie, then selects the child node with the minimum area.
+            for (int i = 0; i < node->num_of_children_or_tuples; i++)
             {
-                long int area = getArea(numofdimensions, node->child_nodes[i]->bounddefiners);
-                if (area < minarea)
+                if (checkIfTupleInBounds(bounddefiners, node->list_of_tuples[i], numofdimensions))
                 {
-                    minarea = area;
-                    minareaindex = i;
+                    numofresults++;
+                    if (visitor != NULL && !visitor(node->list_of_tuples[i], context)) // the visitor asked to stop.
+                        return numofresults;
                 }
             }
-            // return chooseLeaf(tuple, node->child_nodes[minareaindex], numofdimensions); //changed to outer loop
+            top--;
+        }
+        else if (frame->next_child == node->num_of_children_or_tuples) // all children of the node have been visited.
+        {
+            top--;
+        }
+        else // descends into the next child whose MBR overlaps the given bounds, after the tuples waiting in the node on its first visit.
+        {
+            if (frame->next_child == 0 && node->num_of_pending_tuples > 0 && !visitPendingTuples(numofdimensions, bounddefiners, node, visitor, context, &numofresults))
+                return numofresults;
+            struct Node *child = node->child_nodes[frame->next_child++];
+            if (overlaps(numofdimensions, bounddefiners, child->bounddefiners))
+            {
+                top++;
+                stack[top].node = child;
+                stack[top].next_child = 0;
+            }
         }
-        return chooseLeaf(tuple, node->child_nodes[minareaindex], numofdimensions); // calls itself recursively with the selected child node as the new current node.
     }
+    return numofresults;
 }
 
-struct Node *createLeafNode(int numofdimensions, int *tuple) // creates a new leaf node for an R-tree
+long int searchTuplesStreaming(int numofdimensions, Bounds bounddefiners, struct Node *root, SearchVisitor visitor, void *context) // streams every tuple in the given bounds to the visitor. With a NULL visitor only counts them. Returns the number of tuples found.
 {
-    struct Node *leaf = malloc(sizeof(struct Node));                // allocates memory for the new leaf node using the malloc.
-    leaf->num_of_children_or_tuples = 1;                            // sets the num_of_children_or_tuples field of the node to 1 since it is a leaf node and has only one tuple.
-    leaf->list_of_tuples = malloc(sizeof(int *));                   // allocates memory for a list of tuples using malloc.
-    leaf->list_of_tuples[0] = tuple;                                // sets the first tuple in the list to tuple.
-    leaf->bounddefiners = malloc(sizeof(Bounds) * numofdimensions); // allocates memory for the bounddefiners field, which is an array of Bounds structures that represent the bounding box of the leaf node.
-    leaf->parent = NULL;                                            // sets the parent field of the new leaf node to NULL since it has no parent yet,
-    // leaf->bounddefiners = malloc(sizeof(BoundDefiner) * numofdimensions); //must be this ?
-    for (int i = 0; i < numofdimensions; i++)
-    { // For each dimension, sets the dmin and dmax fields of the Bounds structure to the corresponding value in tuple, since this is the only tuple in the leaf node.
-        leaf->bounddefiners[i].dmin = tuple[i];
-        leaf->bounddefiners[i].dmax = tuple[i];
-    }
-    return leaf; // returns the new leaf node.
+    return searchTuplesInDimensions(numofdimensions, bounddefiners, root, visitor, context);
 }
 
-struct Node *addTupleToLeafNode(int numofdimensions, int *tuple, struct Node *node) // adds a new tuple to an existing leaf node
+long int searchTuplesStreaming2D(Bounds bounddefiners, struct Node *root, SearchVisitor visitor, void *context) // searchTuplesStreaming specialised for 2 dimensions.
 {
-    node->num_of_children_or_tuples++;
-    node->list_of_tuples = realloc(node->list_of_tuples, sizeof(int *) * (node->num_of_children_or_tuples)); // resizes the list_of_tuples array of the node using realloc() to accommodate the new tuple.
-    node->list_of_tuples[node->num_of_children_or_tuples - 1] = tuple;                                       // stores the tuple in the last position of the array.
-    for (int i = 0; i < numofdimensions; i++)                                                                // updates the bounddefiners of the node by checking each dimension of the new tuple against the current bounds of the node.
-    {
-        if (tuple[i] < node->bounddefiners[i].dmin)
-        {
-            node->bounddefiners[i].dmin = tuple[i];
-        }
-        if (tuple[i] > node->bounddefiners[i].dmax)
-        {
-            node->bounddefiners[i].dmax = tuple[i];
-        }
-    }
-    return node; // returns a pointer to the modified leaf node.
+    return searchTuplesInDimensions(2, bounddefiners, root, visitor, context);
 }
 
-void adjustRootMBR(struct Rtree *rtree) // adjusts the MBR of the root node of an R-tree and typically called after a new level of nodes has been added to the R-tree, to update the MBR of the root to reflect the new structure of the tree.
+long int searchTuplesStreaming3D(Bounds bounddefiners, struct Node *root, SearchVisitor visitor, void *context) // searchTuplesStreaming specialised for 3 dimensions.
 {
-    Bounds bb = rtree->root->child_nodes[0]->bounddefiners;          // initializes the MBR as the bounding box of the first child node of the root
-    for (int i = 1; i < rtree->root->num_of_children_or_tuples; i++) // iterates over the remaining child nodes to expand the MBR to include all of them.
-    {
-        bb = get_bounding_box(rtree->numofdimensions, rtree->root->child_nodes[i]->bounddefiners, bb); // uses the get_bounding_box function to calculate the bounding box of multiple nodes.
-    }
-    rtree->root->bounddefiners = bb; // sets the root's bounddefiners field to the new MBR.
+    return searchTuplesInDimensions(3, bounddefiners, root, visitor, context);
 }
 
-void insert(struct Rtree *rtree, int *tuple) // used to insert a new tuple into the R-tree.
+void getOverlapMask(struct Node *node, int numofdimensions, Bounds bounddefiners, unsigned int *mask) // SoA layout: sets bit j of the zeroed mask when entry j overlaps the given bounds, or for a leaf when tuple j lies inside them. Bits past the last entry are undefined.
 {
-    if (rtree->root == NULL) // If the tree is empty, create a new root
+    int stride = node->entry_stride;
+    int j = 0;
+#if defined(__AVX2__)
+    for (; j < node->num_of_children_or_tuples; j += 8) // 8 entries per step.
     {
-        rtree->root = new_node(rtree->numofdimensions);
-        addTupleToLeafNode(rtree->numofdimensions, tuple, rtree->root);
+        __m256i outside = _mm256_setzero_si256();
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            __m256i mins = _mm256_loadu_si256((const __m256i *)(node->entry_mins + i * stride + j));
+            __m256i maxs = _mm256_loadu_si256((const __m256i *)(node->entry_maxs + i * stride + j));
+            outside = _mm256_or_si256(outside, _mm256_cmpgt_epi32(mins, _mm256_set1_epi32(bounddefiners[i].dmax)));
+            outside = _mm256_or_si256(outside, _mm256_cmpgt_epi32(_mm256_set1_epi32(bounddefiners[i].dmin), maxs));
+        }
+        mask[j / 32] |= (~(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFFu) << (j % 32);
     }
-    else // If the tree is not empty, traverse it to find the appropriate leaf node to insert the tuple
+#elif defined(__SSE2__)
+    for (; j < node->num_of_children_or_tuples; j += 4) // 4 entries per step.
     {
-        struct Node *leaf_node = chooseLeaf(tuple, rtree->root, rtree->numofdimensions);
-        struct Node *split_leaf_node = NULL;
-
-        // Add the tuple to the leaf node
-        if (leaf_node->num_of_children_or_tuples < rtree->max_entries) // Checks If there is space in the leaf node
+        __m128i outside = _mm_setzero_si128();
+        for (int i = 0; i < numofdimensions; i++)
         {
-            leaf_node = addTupleToLeafNode(rtree->numofdimensions, tuple, leaf_node);
+            __m128i mins = _mm_loadu_si128((const __m128i *)(node->entry_mins + i * stride + j));
+            __m128i maxs = _mm_loadu_si128((const __m128i *)(node->entry_maxs + i * stride + j));
+            outside = _mm_or_si128(outside, _mm_cmpgt_epi32(mins, _mm_set1_epi32(bounddefiners[i].dmax)));
+            outside = _mm_or_si128(outside, _mm_cmpgt_epi32(_mm_set1_epi32(bounddefiners[i].dmin), maxs));
         }
-        else // If there is no space in the leaf node, split it
+        mask[j / 32] |= (~(unsigned int)_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xFu) << (j % 32);
+    }
+#else
+    for (; j < node->num_of_children_or_tuples; j++) // scalar fallback, still reading the contiguous per-dimension arrays.
+    {
+        bool inside = true;
+        for (int i = 0; i < numofdimensions; i++)
+            inside &= (node->entry_mins[i * stride + j] <= bounddefiners[i].dmax) & (node->entry_maxs[i * stride + j] >= bounddefiners[i].dmin);
+        mask[j / 32] |= (unsigned int)inside << (j % 32);
+    }
+#endif
+}
+
+long int searchTuplesSoA(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context) // searchTuplesStreaming for the SoA layout: all entries of a node are tested at once, and only the matching ones are read through their pointers.
+{
+    struct Node *node = rtree->root;
+    int numofdimensions = rtree->numofdimensions;
+    if (node == NULL || !overlaps(numofdimensions, bounddefiners, node->bounddefiners))
+        return 0;
+
+    int height = getTreeHeight(node);
+    int num_of_words = (node->entry_stride + 31) / 32;
+    struct SearchFrame stack[height];         // the internal nodes on the current path.
+    unsigned int masks[height][num_of_words]; // the matching entries of each node on the path, and of the leaf being scanned.
+    int top = -1;
+    long int numofresults = 0;
+    while (true)
+    {
+        if (node != NULL) // enters a node: internal nodes are pushed, leaves are scanned at once.
         {
-            split_leaf_node = nodeSplit_leaf(rtree, leaf_node, tuple);
+            memset(masks[top + 1], 0, sizeof(masks[0]));
+            getOverlapMask(node, numofdimensions, bounddefiners, masks[top + 1]);
+            if (is_leaf(node))
+            {
+                for (int j = 0; j < node->num_of_children_or_tuples; j++)
+                {
+                    if ((masks[top + 1][j / 32] >> (j % 32)) & 1)
+                    {
+                        numofresults++;
+                        if (visitor != NULL && !visitor(node->list_of_tuples[j], context)) // the visitor asked to stop.
+                            return numofresults;
+                    }
+                }
+            }
+            else
+            {
+                if (node->num_of_pending_tuples > 0 && !visitPendingTuples(numofdimensions, bounddefiners, node, visitor, context, &numofresults))
+                    return numofresults;
+                top++;
+                stack[top].node = node;
+                stack[top].next_child = 0;
+            }
+            node = NULL;
         }
+        if (top < 0)
+            break;
 
-        struct Node *split_root = adjust_tree(rtree, leaf_node, split_leaf_node); // After the leaf node is split, adjust_tree is called to adjust the tree and propagate the changes up to the root node.
-
-        if (split_root != NULL) // If the root node is split, a new root node is created and the two split nodes are added as children
+        struct SearchFrame *frame = &stack[top]; // moves to the next matching child of the deepest internal node, or pops it.
+        int j = frame->next_child;
+        while (j < frame->node->num_of_children_or_tuples && !((masks[top][j / 32] >> (j % 32)) & 1))
+            j++;
+        if (j < frame->node->num_of_children_or_tuples)
         {
-            struct Node *new_root = new_node(rtree->numofdimensions);
-            addChildNode2Parent(new_root, rtree->root, rtree->numofdimensions);
-            addChildNode2Parent(new_root, split_root, rtree->numofdimensions);
-            rtree->root = new_root;
+            frame->next_child = j + 1;
+            node = frame->node->child_nodes[j];
         }
-        else if (!is_leaf(rtree->root)) // If the root node did not split, but it is not a leaf node, the function adjustRootMBR is called to adjust the MBR of the root node.
+        else
         {
-            adjustRootMBR(rtree);
+            top--;
         }
     }
+    return numofresults;
 }
 
-void adjustNodeMBR(struct Node *node1, int numofdimensions) // adjusts the MBR (minimum bounding rectangle) of a given node.
+long int concurrentSearch(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context); // searches a concurrent tree, see the concurrent access section.
+
+bool visitEntriesWithPredicate(int numofdimensions, Bounds bounddefiners, enum SpatialPredicate predicate, struct Node *node, SearchVisitor visitor, void *context, long int *numofresults) // streams the entries of the subtree of node matching the predicate to the visitor, counting them. Returns false once the visitor asked to stop.
 {
-    if (!is_leaf(node1)) // checks whether the given node is a leaf node or not.
+    if (!mayHoldMatches(numofdimensions, bounddefiners, node->bounddefiners, predicate))
+        return true;
+    int count = is_leaf(node) ? node->num_of_children_or_tuples : node->num_of_pending_tuples; // the tuples of a leaf, or those waiting in an internal node.
+    int **list_of_tuples = is_leaf(node) ? node->list_of_tuples : node->pending_tuples;
+    for (int i = 0; i < count; i++)
     {
-        Bounds bb1 = node1->child_nodes[0]->bounddefiners;
-        for (int i = 1; i < node1->num_of_children_or_tuples; i++) // iterates through all the child nodes of the given node to compute the bounding box of all the child nodes.
+        if (entryMatchesPredicate(node, list_of_tuples[i], numofdimensions, bounddefiners, predicate))
         {
-            bb1 = get_bounding_box(numofdimensions, bb1, node1->child_nodes[i]->bounddefiners);
+            (*numofresults)++;
+            if (visitor != NULL && !visitor(list_of_tuples[i], context))
+                return false;
         }
-        node1->bounddefiners = bb1;
     }
-    else
+    for (int i = 0; !is_leaf(node) && i < node->num_of_children_or_tuples; i++)
     {
-        struct Node *dummyNode = createLeafNode(numofdimensions, node1->list_of_tuples[0]); // creates a dummy leaf node with the first tuple of the node and computes the bounding box.
-        Bounds bb2 = dummyNode->bounddefiners;
-        free(dummyNode);
-        for (int i = 1; i < node1->num_of_children_or_tuples; i++) // iterates through all the tuples of the node and computes the bounding box of all the tuples.
-        {
-            struct Node *dummyNode2 = createLeafNode(numofdimensions, node1->list_of_tuples[i]);
-            bb2 = get_bounding_box(numofdimensions, dummyNode2->bounddefiners, bb2);
-            free(dummyNode2);
-        }
-        node1->bounddefiners = bb2; // updates the MBR of the given node with the computed bounding box.
+        if (!visitEntriesWithPredicate(numofdimensions, bounddefiners, predicate, node->child_nodes[i], visitor, context, numofresults))
+            return false;
     }
+    return true;
 }
 
-struct Node *adjust_tree(struct Rtree *rtree, struct Node *node1, struct Node *node2)
-{
-    // Step 1 : if N == root
-    if (node1->parent == NULL)
-        return node2;
-
-    // Step 2: Changing MBR of node1 if node not split
-    if (node2 == NULL)
-        adjustNodeMBR(node1, rtree->numofdimensions);
+long int searchRtreeWithPredicate(struct Rtree *rtree, Bounds bounddefiners, enum SpatialPredicate predicate, SearchVisitor visitor, void *context); // streams every entry of the R-tree matching the predicate to the visitor.
 
-    struct Node *parent_split = NULL;
-    struct Node *parent_node = node1->parent;
-    // Step 3: Propogate Node Split
-    if (node1->parent->num_of_children_or_tuples < rtree->max_entries && node2 != NULL)
+long int searchRtreeWithVisitor(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context) // streams every tuple of the R-tree in the given bounds to the visitor. On an extent tree, every extent intersecting them.
+{
+    if (rtree->extent_entries)
+        return searchRtreeWithPredicate(rtree, bounddefiners, PREDICATE_INTERSECTS, visitor, context);
+    if (rtree->concurrent)
+        return concurrentSearch(rtree, bounddefiners, visitor, context);
+    if (rtree->node_layout == LAYOUT_SOA)
+        return searchTuplesSoA(rtree, bounddefiners, visitor, context);
+    switch (rtree->dimension_kernel)
     {
-        // to add node to parent node's list of child nodes
-        addChildNode2Parent(node1->parent, node2, rtree->numofdimensions);
-    }
-    else if (node1->parent->num_of_children_or_tuples == rtree->max_entries && node2 != NULL)
-    { // to split node
-        parent_split = nodeSplit(rtree, node1->parent, node2);
+    case KERNEL_2D:
+        return searchTuplesStreaming2D(bounddefiners, rtree->root, visitor, context);
+    case KERNEL_3D:
+        return searchTuplesStreaming3D(bounddefiners, rtree->root, visitor, context);
+    default:
+        return searchTuplesStreaming(rtree->numofdimensions, bounddefiners, rtree->root, visitor, context);
     }
+}
 
-    // Step 4: Move upto next level
-    return adjust_tree(rtree, parent_node, parent_split);
+long int searchRtreeWithPredicate(struct Rtree *rtree, Bounds bounddefiners, enum SpatialPredicate predicate, SearchVisitor visitor, void *context) // streams every entry of the R-tree matching the predicate to the visitor. Returns the number of entries found.
+{
+    if (rtree->root == NULL)
+        return 0;
+    if (!rtree->extent_entries) // a point intersects the window exactly when it lies within it, and only contains a window shrunk to that point, so the search kernels answer all three.
+    {
+        for (int i = 0; predicate == PREDICATE_CONTAINS && i < rtree->numofdimensions; i++)
+        {
+            if (bounddefiners[i].dmin != bounddefiners[i].dmax)
+                return 0;
+        }
+        return searchRtreeWithVisitor(rtree, bounddefiners, visitor, context);
+    }
+    long int numofresults = 0;
+    visitEntriesWithPredicate(rtree->numofdimensions, bounddefiners, predicate, rtree->root, visitor, context, &numofresults);
+    return numofresults;
 }
 
-// NOTES for nodeSplit
-// 1. struct Node * nodeSplit(int numofdimensions, struct Node *parent_node, struct Node excess_child_node)
-// 2. All nodes after nodeSplit must have MBR adjusted !! (Very Imp)
-// 3. Use Quadratic Splitting for PickNext
+long int countTuplesInBounds(struct Rtree *rtree, Bounds bounddefiners) // counts the tuples of the R-tree in the given bounds without any per-tuple work beyond the bounds check.
+{
+    return searchRtreeWithVisitor(rtree, bounddefiners, NULL, NULL);
+}
 
-struct SplitArray // used to represent the result of a node split operation
+struct SearchBuffer // caller-owned output buffer filled by searchRtreeIntoBuffer.
 {
-    struct Node **array_of_child_nodes; // pointer to an array of pointers to Node structures, representing the child nodes of the split nodes.
-    int numofchildnodes;                // represents the number of child nodes in the array.
+    int **list_of_tuples; // buffer receiving the tuples found.
+    long int capacity;    // number of tuples the buffer can hold.
+    long int num_of_tuples; // number of tuples stored so far.
 };
 
-struct SplitArray *newSplitArray(struct Node *parent_node, struct Node *child_node)
+bool fillSearchBuffer(int *tuple, void *context) // visitor storing each tuple into a SearchBuffer, stopping once it is full.
 {
-    struct SplitArray *splitArray = malloc(sizeof(struct SplitArray));                                               // allocates memory for a new SplitArray struct using malloc().
-    splitArray->array_of_child_nodes = malloc(sizeof(struct Node *) * (parent_node->num_of_children_or_tuples + 1)); // allocates memory for an array of Node pointers inside the SplitArray struct, with a size equal to the number of children of the parent node plus one. This is because we're splitting the parent node and adding a new child node, so the number of children will increase by one.
-    splitArray->array_of_child_nodes[0] = child_node;                                                                // assigns the child node to the first element of the array of child nodes.
-    splitArray->numofchildnodes = parent_node->num_of_children_or_tuples + 1;                                        // updates number of child nodes.
-    for (int i = 0; i < parent_node->num_of_children_or_tuples; i++)                                                 // loops through the remaining children of the parent node and copies their pointers to the array_of_child_nodes array of the SplitArray struct, shifting them over by one index to make room for the new child node.
-        splitArray->array_of_child_nodes[i + 1] = parent_node->child_nodes[i];
+    struct SearchBuffer *buffer = context;
+    buffer->list_of_tuples[buffer->num_of_tuples++] = tuple;
+    return buffer->num_of_tuples < buffer->capacity;
+}
 
-    return splitArray; // returns a pointer to the newly created SplitArray struct.
+long int searchRtreeIntoBuffer(struct Rtree *rtree, Bounds bounddefiners, int **list_of_tuples, long int capacity) // stores the first capacity tuples found in the given bounds into list_of_tuples. Returns the number of tuples stored.
+{
+    if (capacity <= 0)
+        return 0;
+    struct SearchBuffer buffer = {list_of_tuples, capacity, 0};
+    searchRtreeWithVisitor(rtree, bounddefiners, fillSearchBuffer, &buffer);
+    return buffer.num_of_tuples;
 }
 
-void removeNodeFromSplitArray(struct SplitArray *splitArray, int ind) // removes a node from a SplitArray at the specified index ind
+void printTuple(int *tuple, int numofdimensions)
 {
-    for (int j = ind; j < splitArray->numofchildnodes - 1; j++) // start a loop that goes through all the child nodes in the SplitArray after the specified index ind (including ind). It starts at ind and ends at numofchildnodes - 2 because the last child node will be removed in the next line.
+    printf("(");                              // Print a left parenthesis
+    for (int i = 0; i < numofdimensions; i++) // Loop through each dimension in the tuple
     {
-        splitArray->array_of_child_nodes[j] = splitArray->array_of_child_nodes[j + 1]; // shifts each child node one position to the left, effectively overwriting the node at index ind.
+        printf("%d", tuple[i]);       // Print the current element
+        if (i != numofdimensions - 1) // Checks if this is not the last dimenstion in the tuple
+        {
+            printf(", "); // Print a comma and a space to separate the elements
+        }
     }
-    splitArray->array_of_child_nodes[splitArray->numofchildnodes - 1] = NULL; // sets the last child node in the SplitArray to NULL, effectively removing it from the array.
-    splitArray->numofchildnodes--;                                            // updating number of child nodes
+    printf(")"); // Print a right parenthesis
 }
 
-struct Node **pickSeed(int numofdimensions, struct SplitArray *splitArray) // used in the process of selecting two nodes as seeds for splitting a node
+bool printTupleVisitor(int *tuple, void *context) // visitor printing each tuple found on its own line. The context holds the number of dimensions.
 {
-    long int max_area_inclusion_difference = LONG_MIN;
-    int index1, index2;
-    for (int i = 0; i < splitArray->numofchildnodes; i++) // Loop through all the child nodes in the split array.
+    printTuple(tuple, *(int *)context);
+    printf("\n");
+    return true;
+}
+
+int getExtentPayload(int numofdimensions, int *tuple) // returns the payload of an extent record, stored after its MBR.
+{
+    return tuple[2 * numofdimensions];
+}
+
+void printExtent(int *tuple, int numofdimensions) // prints an extent record as its lower corner, its upper corner and its payload.
+{
+    int lower[numofdimensions], upper[numofdimensions];
+    for (int i = 0; i < numofdimensions; i++)
     {
-        for (int j = i; j < splitArray->numofchildnodes; j++) //  Loop through all the child nodes in the split array again, but starting from the current value of i.
-        {
-            // Calculate the difference in area of the bounding box that would be created if the two child nodes at indices i and j were merged and the areas of their original bounding boxes. This difference represents the maximum amount by which the new bounding box would be expanded if these two nodes were chosen as seeds.
-            long int temp_area_difference = getArea(numofdimensions, get_bounding_box(numofdimensions, splitArray->array_of_child_nodes[i]->bounddefiners, splitArray->array_of_child_nodes[j]->bounddefiners)) - getArea(numofdimensions, splitArray->array_of_child_nodes[i]->bounddefiners) - getArea(numofdimensions, splitArray->array_of_child_nodes[j]->bounddefiners);
-            if (temp_area_difference > max_area_inclusion_difference)
-            {
-                max_area_inclusion_difference = temp_area_difference;
-                index1 = i;
-                index2 = j;
-            }
-        }
+        lower[i] = getExtentBounds(tuple)[i].dmin;
+        upper[i] = getExtentBounds(tuple)[i].dmax;
     }
-    struct Node **ans = malloc(sizeof(struct Node *) * 2);
+    printTuple(lower, numofdimensions);
+    printf("-");
+    printTuple(upper, numofdimensions);
+    printf(" #%d", getExtentPayload(numofdimensions, tuple));
+}
 
-    ans[0] = splitArray->array_of_child_nodes[index1];         // Stores the child node at index index1 in the ans array at 0th position.
-    ans[1] = splitArray->array_of_child_nodes[index2];         // Store the child node at index index2 in the ans array at 1st position.
-    removeNodeFromSplitArray(splitArray, max(index1, index2)); // Remove the child node with the higher index among index1 and index2 from the split array.
-    removeNodeFromSplitArray(splitArray, min(index1, index2)); // Remove the child node with the lower index among index1 and index2 from the split array.
-    return ans;                                                // Return the array ans containing the two selected nodes as seeds.
+bool printExtentVisitor(int *tuple, void *context) // printTupleVisitor for extent records.
+{
+    printExtent(tuple, *(int *)context);
+    printf("\n");
+    return true;
 }
 
-void addChildNode2Parent(struct Node *parent_node, struct Node *child_node, int numofdimensions) // adds a child node to a given parent node
+struct GrowingResult // result list filled by appendToGrowingResult.
 {
-    parent_node->num_of_children_or_tuples++; // updates the number of child nodes of the parent node.
-    if (parent_node->child_nodes == NULL)
-        parent_node->child_nodes = malloc(sizeof(struct Node *) * parent_node->num_of_children_or_tuples); // allocates memory for an array of child nodes with the size of num_of_children_or_tuples
-    else
-        parent_node->child_nodes = realloc(parent_node->child_nodes, sizeof(struct Node *) * parent_node->num_of_children_or_tuples); // reallocates the memory for the array of child nodes to accommodate the new child node.
-    parent_node->child_nodes[parent_node->num_of_children_or_tuples - 1] = child_node;                                                // assigns the child node to the last element of the array of child nodes in the parent node.
-    child_node->parent = parent_node;                                                                                                 // sets the parent of the child node to be the parent node.
-    if (parent_node->num_of_children_or_tuples == 1)
+    int **list_of_tuples;   // tuples found so far.
+    long int num_of_tuples; // number of tuples found so far.
+    long int capacity;      // number of tuples list_of_tuples can hold.
+};
+
+bool appendToGrowingResult(int *tuple, void *context) // SearchVisitor appending each tuple to a list that doubles when full.
+{
+    struct GrowingResult *result = context;
+    if (result->num_of_tuples == result->capacity)
     {
-        // sets the bounding box of the parent node to be the same as the bounding box of the child node.
-        for (int i = 0; i < numofdimensions; i++)
-        {
-            parent_node->bounddefiners[i].dmax = child_node->bounddefiners[i].dmax;
-            parent_node->bounddefiners[i].dmin = child_node->bounddefiners[i].dmin;
-        }
+        result->capacity = (result->capacity > 0) ? 2 * result->capacity : 16;
+        result->list_of_tuples = realloc(result->list_of_tuples, sizeof(int *) * result->capacity);
+    }
+    result->list_of_tuples[result->num_of_tuples++] = tuple;
+    return true;
+}
+
+long int searchRtreeCached(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context); // searchRtreeWithVisitor through the query cache of the tree, if it has one.
+
+void searchRTreeWithPredicate(Bounds bounddefiners, struct Rtree *rtree, enum SpatialPredicate predicate) // searchRTree for the entries matching the predicate.
+{
+    if (rtree->root == NULL)
+    {
+        printf("Tree empty\n");
+        return;
+    }
+    bool cached = (predicate == PREDICATE_INTERSECTS && rtree->query_cache != NULL); // the cache holds intersection results, looked up once and listed after the count.
+    SearchVisitor visitor = rtree->extent_entries ? printExtentVisitor : printTupleVisitor;
+    const char *noun = rtree->extent_entries ? "Extent" : "Tuple";
+    struct GrowingResult result = {NULL, 0, 0};
+    long int numofresults = cached ? searchRtreeCached(rtree, bounddefiners, appendToGrowingResult, &result) : searchRtreeWithPredicate(rtree, bounddefiners, predicate, NULL, NULL);
+    if (numofresults == 0)
+    {
+        printf("No %ss found in given bounds\n", rtree->extent_entries ? "extent" : "tuple");
     }
     else
     {
-        // adjusts the bounding box of the parent node to accommodate the new child node by taking the minimum and maximum values of the bounding box dimensions.
-        for (int i = 0; i < numofdimensions; i++)
+        printf("%ld %s(s) found in given bounds :\n", numofresults, noun);
+        if (cached)
         {
-            parent_node->bounddefiners[i].dmax = max(child_node->bounddefiners[i].dmax, parent_node->bounddefiners[i].dmax);
-            parent_node->bounddefiners[i].dmin = min(child_node->bounddefiners[i].dmin, parent_node->bounddefiners[i].dmin);
+            for (long int t = 0; t < result.num_of_tuples; t++)
+                visitor(result.list_of_tuples[t], &rtree->numofdimensions);
         }
+        else
+            searchRtreeWithPredicate(rtree, bounddefiners, predicate, visitor, &rtree->numofdimensions);
     }
+    free(result.list_of_tuples);
 }
 
-void pickNext(struct Node *node1, struct Node *node2, struct SplitArray *splitArray, struct Rtree *rtree) // helper function used in the process of splitting a node as it helps to select which of the two nodes the next child node from the split array should be added to.
+void searchRTree(Bounds bounddefiners, struct Rtree *rtree) // searches for tuples within the bounding box and prints them, first counting them and then streaming them.
 {
-    long int max_area_difference = LONG_MIN;
-    struct Node *node_temp;                               // pointer to the node that will be selected as the parent for the next child node to be added to the split array.
-    int index;                                            // index of the next child node to be added to the parent node.
-    for (int i = 0; i < splitArray->numofchildnodes; i++) // iterates over each child node in the split array.
-    {
-        // calculates the difference between the areas of the bounding boxes that would result if the child node were added to node1 or node2.
-        long int area4node1 = getArea(rtree->numofdimensions, get_bounding_box(rtree->numofdimensions, splitArray->array_of_child_nodes[i]->bounddefiners, node1->bounddefiners)) - getArea(rtree->numofdimensions, node1->bounddefiners);
-        long int area4node2 = getArea(rtree->numofdimensions, get_bounding_box(rtree->numofdimensions, splitArray->array_of_child_nodes[i]->bounddefiners, node2->bounddefiners)) - getArea(rtree->numofdimensions, node2->bounddefiners);
-        // selects the child node that results in the largest difference in area between node1 and node2.
-        if (labs(area4node1 - area4node2) > max_area_difference)
-        {
-            max_area_difference = labs(area4node1 - area4node2);
-            node_temp = (area4node1 > area4node2) ? node2 : node1;
-            index = i;
-        }
-    }
-    // adds the selected child node to the parent node, and removes it from the split array.
-    addChildNode2Parent(node_temp, splitArray->array_of_child_nodes[index], rtree->numofdimensions);
-    removeNodeFromSplitArray(splitArray, index);
+    searchRTreeWithPredicate(bounddefiners, rtree, PREDICATE_INTERSECTS);
 }
 
-void emptyNode(struct Node *node, int numofdimensions) // used to clear out the contents of a node, making it empty and ready to be reused. When a node becomes empty, it can be reused by splitting the contents of another node or by moving its contents to a parent node.
+// k nearest neighbours
+// Nodes are visited best-first from a priority queue ordered by MINDIST, the distance from the query point to the MBR of the node.
+// The k best tuples found so far are kept in a max-heap, and a node is pruned once its MINDIST exceeds the worst of them.
+
+enum DistanceMetric
+{
+    DISTANCE_EUCLIDEAN_SQUARED, // sum of squared differences, exact in integer arithmetic.
+    DISTANCE_MANHATTAN          // sum of absolute differences.
+};
+
+unsigned long long addDistances(unsigned long long distance, unsigned long long distance2) // adds two distances, saturating instead of wrapping around.
+{
+    return (distance > ULLONG_MAX - distance2) ? ULLONG_MAX : distance + distance2;
+}
+
+unsigned long long getDimensionDistance(long long difference, enum DistanceMetric metric) // returns the contribution of a difference along one dimension to the distance.
+{
+    unsigned long long magnitude = (unsigned long long)llabs(difference); // at most 2^32 - 1, so its square still fits.
+    return (metric == DISTANCE_MANHATTAN) ? magnitude : magnitude * magnitude;
+}
+
+unsigned long long getTupleDistance(int numofdimensions, int *tuple, int *point, enum DistanceMetric metric) // returns the distance between a tuple and the query point.
 {
-    if (node->child_nodes)
+    unsigned long long distance = 0;
+    for (int i = 0; i < numofdimensions; i++)
     {
-        free(node->child_nodes);
-        node->child_nodes = NULL;
-        node->child_nodes = malloc(sizeof(struct Node *));
+        distance = addDistances(distance, getDimensionDistance((long long)tuple[i] - point[i], metric));
     }
+    return distance;
+}
 
+unsigned long long getMinDist(int numofdimensions, Bounds bounddefiners, int *point, enum DistanceMetric metric) // returns MINDIST, the smallest distance from the query point to any point of the MBR.
+{
+    unsigned long long distance = 0;
     for (int i = 0; i < numofdimensions; i++)
     {
-        node->bounddefiners[i].dmax = INT_MIN;
-        node->bounddefiners[i].dmin = INT_MAX;
+        long long difference = 0; // zero when the point lies within the MBR in this dimension.
+        if (point[i] < bounddefiners[i].dmin)
+            difference = (long long)bounddefiners[i].dmin - point[i];
+        else if (point[i] > bounddefiners[i].dmax)
+            difference = (long long)point[i] - bounddefiners[i].dmax;
+        distance = addDistances(distance, getDimensionDistance(difference, metric));
     }
-    node->num_of_children_or_tuples = 0;
+    return distance;
 }
 
-struct Node *nodeSplit(struct Rtree *rtree, struct Node *parent_node, struct Node *child_node) // Splits a node in an R tree
+struct KnnQueueEntry // a node waiting in the priority queue of a nearest neighbour search.
 {
-    struct SplitArray *splitArray = newSplitArray(parent_node, child_node); // will be used to store the child nodes that need to be split between the parent and the new split node.
-    struct Node *grandparent_node = parent_node->parent;                    // creates a pointer to the grandparent node of the child node by getting the parent of the parent node.
-
-    struct Node *split_node = new_node(rtree->numofdimensions); // This node will be used as the new split node.
-    emptyNode(parent_node, rtree->numofdimensions);             // empties the parent node by calling the emptyNode function, necessary because the parent node will be used to store some of the child nodes after the split.
+    unsigned long long mindist; // MINDIST from the query point to the node.
+    struct Node *node;          // pointer to the node.
+};
 
-    // Step 1: Call pickSeed
-    struct Node **pick_seed_node = pickSeed(rtree->numofdimensions, splitArray); // pick two seed nodes from the child nodes and assign them to the parent and split nodes. The pickSeed function is called and it returns an array of two pointers to nodes.
-    addChildNode2Parent(parent_node, pick_seed_node[0], rtree->numofdimensions); // These two seed nodes are added to the parent and split nodes using the addChildNode2Parent function.
-    addChildNode2Parent(split_node, pick_seed_node[1], rtree->numofdimensions);
+struct KnnQueue // binary min-heap of nodes ordered by MINDIST.
+{
+    struct KnnQueueEntry *entries;
+    int size;
+    int capacity;
+};
 
-    // Step 2: Call pickNext if min_enties not fulfilled
-    for (int i = 0; i < rtree->max_entries - 1; i++)
+void pushKnnQueue(struct KnnQueue *queue, unsigned long long mindist, struct Node *node) // adds a node to the priority queue.
+{
+    if (queue->size == queue->capacity) // grows the heap geometrically.
     {
-        if (parent_node->num_of_children_or_tuples + splitArray->numofchildnodes == rtree->min_entries && split_node->num_of_children_or_tuples >= rtree->min_entries)
-        {
-            // If adding a child node to parent_node would cause it to have fewer than the minimum number of entries and adding a child node to split_node would leave it with at least the minimum number of entries, then add the child node to parent_node.
-            addChildNode2Parent(parent_node, splitArray->array_of_child_nodes[0], rtree->numofdimensions);
-            removeNodeFromSplitArray(splitArray, 0);
-        }
-        else if (split_node->num_of_children_or_tuples + splitArray->numofchildnodes == rtree->min_entries && parent_node->num_of_children_or_tuples >= rtree->min_entries)
-        {
-            // If adding a child node to split_node would cause it to have fewer than the minimum number of entries and adding a child node to parent_node would leave it with at least the minimum number of entries, then add the child node to split_node.
-            addChildNode2Parent(split_node, splitArray->array_of_child_nodes[0], rtree->numofdimensions);
-            removeNodeFromSplitArray(splitArray, 0);
-        }
-        // If neither of the above conditions are true, call pickNext to determine which node to add the child node to.
-        else
-        {
-            pickNext(parent_node, split_node, splitArray, rtree);
-        }
+        queue->capacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+        queue->entries = realloc(queue->entries, sizeof(struct KnnQueueEntry) * queue->capacity);
+    }
+    int i = queue->size++;
+    while (i > 0 && queue->entries[(i - 1) / 2].mindist > mindist) // sifts the new entry up past every parent further away.
+    {
+        queue->entries[i] = queue->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
     }
+    queue->entries[i].mindist = mindist;
+    queue->entries[i].node = node;
+}
 
-    free(splitArray->array_of_child_nodes);
-    free(splitArray);
-    parent_node->parent = grandparent_node; // sets the parent of parent_node to grandparent_node.
-    split_node->parent = NULL;              // sets the parent of split_node to NULL.
+struct KnnQueueEntry popKnnQueue(struct KnnQueue *queue) // removes and returns the node of the priority queue with the smallest MINDIST.
+{
+    struct KnnQueueEntry top = queue->entries[0];
+    struct KnnQueueEntry last = queue->entries[--queue->size];
+    int i = 0;
+    while (2 * i + 1 < queue->size) // sifts the last entry down from the top past every child closer than it.
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < queue->size && queue->entries[child + 1].mindist < queue->entries[child].mindist)
+            child++;
+        if (queue->entries[child].mindist >= last.mindist)
+            break;
+        queue->entries[i] = queue->entries[child];
+        i = child;
+    }
+    queue->entries[i] = last;
+    return top;
+}
 
-    return split_node; // Returns the newly created split_node.
+void siftDownCandidates(int **list_of_tuples, unsigned long long *distances, int size, int i) // restores the max-heap of candidate tuples below position i.
+{
+    while (2 * i + 1 < size)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < size && distances[child + 1] > distances[child])
+            child++;
+        if (distances[child] <= distances[i])
+            break;
+        unsigned long long distance = distances[i];
+        distances[i] = distances[child];
+        distances[child] = distance;
+        int *tuple = list_of_tuples[i];
+        list_of_tuples[i] = list_of_tuples[child];
+        list_of_tuples[child] = tuple;
+        i = child;
+    }
 }
 
-void convertChild2Tuple(struct Node *parent_node, int numofdimensions) // converts the child nodes of a given parent node into tuples.
+void offerCandidate(int **list_of_tuples, unsigned long long *distances, int *size, int k, int *tuple, unsigned long long distance) // keeps the tuple if it is among the k nearest seen so far. The candidates form a max-heap on distance.
 {
-    if (parent_node == NULL)
-        return;
-    // reallocates memory for the parent node's list of tuples. It resizes the memory block to hold the number of child nodes that the parent node has.
-    parent_node->list_of_tuples = realloc(parent_node->list_of_tuples, (sizeof(int *) * parent_node->num_of_children_or_tuples));
-    for (int i = 0; i < parent_node->num_of_children_or_tuples; i++)
+    if (*size < k) // the heap is not full yet, so the tuple is sifted up from the end.
     {
-        parent_node->list_of_tuples[i] = malloc(sizeof(int) * numofdimensions); //  allocates memory for the i-th tuple. It resizes the memory block to hold the number of dimensions in the R tree.
-        for (int j = 0; j < numofdimensions; j++)
+        int i = (*size)++;
+        while (i > 0 && distances[(i - 1) / 2] < distance)
         {
-            parent_node->list_of_tuples[i][j] = parent_node->child_nodes[i]->bounddefiners[j].dmax; //  assigns the maximum value of the j-th dimension of the i-th child node's bounding box to the corresponding element of the i-th tuple.
+            distances[i] = distances[(i - 1) / 2];
+            list_of_tuples[i] = list_of_tuples[(i - 1) / 2];
+            i = (i - 1) / 2;
         }
+        distances[i] = distance;
+        list_of_tuples[i] = tuple;
+    }
+    else if (distance < distances[0]) // the tuple replaces the farthest candidate.
+    {
+        distances[0] = distance;
+        list_of_tuples[0] = tuple;
+        siftDownCandidates(list_of_tuples, distances, *size, 0);
     }
-    free(parent_node->child_nodes); // frees the memory allocated for the parent node's child nodes.
-    parent_node->child_nodes = NULL;
 }
 
-struct Node *nodeSplit_leaf(struct Rtree *rtree, struct Node *leaf_node, int *tuple) // used to split a leaf node
+void sortCandidates(int **list_of_tuples, unsigned long long *distances, int size) // heap-sorts the candidates by increasing distance.
 {
-    // converting tuples to child nodes
-    struct Node *tuple_node = createLeafNode(rtree->numofdimensions, tuple);
-    int **list_of_tuples = leaf_node->list_of_tuples; // Gets the list of tuples from the input leaf node.
-    emptyNode(leaf_node, rtree->numofdimensions);     // Clear the contents of leaf node.
-
-    for (int i = 0; i < rtree->max_entries; i++)
+    for (int end = size - 1; end > 0; end--)
     {
-        addChildNode2Parent(leaf_node, createLeafNode(rtree->numofdimensions, list_of_tuples[i]), rtree->numofdimensions); //  Adds a child node to the leaf node
+        unsigned long long distance = distances[0];
+        distances[0] = distances[end];
+        distances[end] = distance;
+        int *tuple = list_of_tuples[0];
+        list_of_tuples[0] = list_of_tuples[end];
+        list_of_tuples[end] = tuple;
+        siftDownCandidates(list_of_tuples, distances, end, 0);
     }
-
-    struct Node *split_leaf_node = nodeSplit(rtree, leaf_node, tuple_node); // Call the nodeSplit function to split the leaf node.
-
-    // converting child nodes to tuple
-    convertChild2Tuple(leaf_node, rtree->numofdimensions);
-    convertChild2Tuple(split_leaf_node, rtree->numofdimensions);
-
-    return split_leaf_node; // Returns the split leaf node.
 }
 
-int read_tuples_and_insert(struct Rtree *rtree, const char *filename) //  reads tuples from a file and inserts them into an R-tree data structure
+int nearestNeighbours(struct Rtree *rtree, int *point, int k, enum DistanceMetric metric, int **list_of_tuples, unsigned long long *distances) // finds the k tuples nearest to the point. The caller-owned arrays receive them by increasing distance. Returns the number found.
 {
-    FILE *file = fopen(filename, "r"); // opens the specified file in read mode and assigns a file pointer to file.
-    if (file == NULL)
-    { // file failed to open
-        printf("Error opening file: %s\n", strerror(errno));
-        return 1;
-    }
+    int numofdimensions = rtree->numofdimensions;
+    int numofresults = 0;
+    if (rtree->root == NULL || k <= 0)
+        return 0;
 
-    int count, value;
-    while (fscanf(file, "%d", &value) == 1) // reads the tuples from the file line by line.
+    struct KnnQueue queue = {NULL, 0, 0};
+    pushKnnQueue(&queue, getMinDist(numofdimensions, rtree->root->bounddefiners, point, metric), rtree->root);
+    while (queue.size > 0)
     {
-        count = 0;
-        int *tuple = malloc(sizeof(int) * rtree->numofdimensions);
-        if (tuple == NULL)
-        {
-            printf("Error allocating memory");
-            fclose(file);
-            return 1;
-        }
-
-        tuple[count++] = value;
-
-        for (int i = 1; i < rtree->numofdimensions; ++i)
+        struct KnnQueueEntry entry = popKnnQueue(&queue);
+        if (numofresults == k && entry.mindist > distances[0]) // every remaining node is farther than the k-th nearest tuple found.
+            break;
+        struct Node *node = entry.node;
+        for (int i = 0; i < node->num_of_pending_tuples; i++) // buffered mode: the tuples waiting in an internal node lie inside its MBR, so they are candidates once it is reached.
+            offerCandidate(list_of_tuples, distances, &numofresults, k, node->pending_tuples[i], getTupleDistance(numofdimensions, node->pending_tuples[i], point, metric));
+        for (int i = 0; i < node->num_of_children_or_tuples; i++)
         {
-            if (fscanf(file, "%d", &value) == 1)
+            if (is_leaf(node))
             {
-                tuple[count++] = value;
+                unsigned long long distance = node->extent_entries ? getMinDist(numofdimensions, getExtentBounds(node->list_of_tuples[i]), point, metric) : getTupleDistance(numofdimensions, node->list_of_tuples[i], point, metric);
+                offerCandidate(list_of_tuples, distances, &numofresults, k, node->list_of_tuples[i], distance);
             }
             else
             {
-                break;
+                unsigned long long mindist = getMinDist(numofdimensions, node->child_nodes[i]->bounddefiners, point, metric);
+                if (numofresults < k || mindist <= distances[0]) // prunes children that cannot hold a nearer tuple.
+                    pushKnnQueue(&queue, mindist, node->child_nodes[i]);
             }
         }
-        // If a complete tuple with the correct number of dimensions is read, the insert() function is called to insert the tuple into the R-tree.
-        if (count == rtree->numofdimensions)
-        {
-            insert(rtree, tuple);
-        }
-        // If the tuple is incomplete, an error message is printed, and the allocated memory for the tuple is freed.
-        else
-        {
-            printf("Error: Tuple count is less than the number of dimensions (%d < %d)\n", count, rtree->numofdimensions);
-            free(tuple);
-        }
     }
+    free(queue.entries);
+    sortCandidates(list_of_tuples, distances, numofresults);
+    return numofresults;
+}
 
-    fclose(file);
-    return 0;
+void printNearestNeighbours(struct Rtree *rtree, int *point, int k, enum DistanceMetric metric) // finds and prints the k tuples nearest to the point.
+{
+    int **list_of_tuples = malloc(sizeof(int *) * k);
+    unsigned long long *distances = malloc(sizeof(unsigned long long) * k);
+    int numofresults = nearestNeighbours(rtree, point, k, metric, list_of_tuples, distances);
+    printf("%d nearest tuple(s) :\n", numofresults);
+    for (int i = 0; i < numofresults; i++)
+    {
+        if (rtree->extent_entries)
+            printExtent(list_of_tuples[i], rtree->numofdimensions);
+        else
+            printTuple(list_of_tuples[i], rtree->numofdimensions);
+        printf(" distance %llu\n", distances[i]);
+    }
+    free(list_of_tuples);
+    free(distances);
 }
 
-void free_node(struct Node *node, int numofdimensions)
+// Parallel queries
+// Searches only read the tree. Each traversal keeps its stack, heap and results in memory owned by the calling thread, and no
+// node or tree field is written, so any number of threads may query one tree at once as long as none of them modifies it.
+// A WorkerPool runs fork-join jobs on a fixed set of threads. Batches of queries are spread over it one query at a time, and a
+// single large range query can be split over it by subtree, each worker stealing nodes from the others once it runs dry.
+
+struct WorkerPool; // fixed set of threads running fork-join jobs.
+
+struct WorkerThread // one thread of a worker pool.
 {
-    if (node == NULL)
-        return;
+    struct WorkerPool *pool; // pool the thread belongs to.
+    int index;               // index of the thread within the pool, handed to every job.
+    pthread_t thread;        // the thread itself.
+};
 
-    if (is_leaf(node))
+struct WorkerPool // fixed set of threads that run one job at a time, every thread calling the job function with its own index.
+{
+    struct WorkerThread *workers; // the worker threads.
+    int num_of_threads;           // number of worker threads.
+    pthread_mutex_t lock;         // protects the fields below.
+    pthread_cond_t job_posted;    // signalled when a job is posted or the pool shuts down.
+    pthread_cond_t job_finished;  // signalled when the last worker returns from the current job.
+    void (*job)(void *, int);     // job run by every worker, given the context and the index of the worker.
+    void *context;                // context of the current job.
+    unsigned long generation;     // number of jobs posted so far, so that each worker runs every job exactly once.
+    int num_of_busy;              // number of workers still running the current job.
+    bool shutting_down;           // set when the pool is freed.
+};
+
+void *runWorker(void *argument) // main loop of a worker thread: waits for a job, runs it, and reports back.
+{
+    struct WorkerThread *worker = argument;
+    struct WorkerPool *pool = worker->pool;
+    unsigned long generation = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (true)
     {
-        for (int i = 0; i < node->num_of_children_or_tuples; i++)
-        {
-            free(node->list_of_tuples[i]);
-        }
+        while (pool->generation == generation && !pool->shutting_down)
+            pthread_cond_wait(&pool->job_posted, &pool->lock);
+        if (pool->shutting_down)
+            break;
+        generation = pool->generation;
+        void (*job)(void *, int) = pool->job;
+        void *context = pool->context;
+        pthread_mutex_unlock(&pool->lock);
+        job(context, worker->index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->num_of_busy == 0)
+            pthread_cond_signal(&pool->job_finished);
     }
-    else
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+struct WorkerPool *newWorkerPool(int num_of_threads) // starts a pool of num_of_threads worker threads.
+{
+    struct WorkerPool *pool = malloc(sizeof(struct WorkerPool));
+    pool->workers = malloc(sizeof(struct WorkerThread) * num_of_threads);
+    pool->num_of_threads = num_of_threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_posted, NULL);
+    pthread_cond_init(&pool->job_finished, NULL);
+    pool->job = NULL;
+    pool->context = NULL;
+    pool->generation = 0;
+    pool->num_of_busy = 0;
+    pool->shutting_down = false;
+    for (int i = 0; i < num_of_threads; i++)
     {
-        for (int i = 0; i < node->num_of_children_or_tuples; i++)
-        {
-            free_node(node->child_nodes[i], numofdimensions);
-        }
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pthread_create(&pool->workers[i].thread, NULL, runWorker, &pool->workers[i]);
     }
+    return pool;
+}
 
-    free(node->bounddefiners);
-    free(node->child_nodes);
-    free(node->list_of_tuples);
-    free(node);
+void runOnWorkerPool(struct WorkerPool *pool, void (*job)(void *, int), void *context) // runs the job on every worker of the pool and waits until all of them return.
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->context = context;
+    pool->num_of_busy = pool->num_of_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->job_posted);
+    while (pool->num_of_busy > 0)
+        pthread_cond_wait(&pool->job_finished, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
 }
 
-void free_rtree(struct Rtree *rtree)
+void freeWorkerPool(struct WorkerPool *pool) // stops and joins the worker threads and releases the pool.
 {
-    if (rtree == NULL)
-        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->job_posted);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->num_of_threads; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->job_posted);
+    pthread_cond_destroy(&pool->job_finished);
+    free(pool->workers);
+    free(pool);
+}
 
-    free_node(rtree->root, rtree->numofdimensions);
-    free(rtree);
+enum BatchQueryType // kind of a query in a batch.
+{
+    BATCH_RANGE, // every tuple within a window.
+    BATCH_KNN    // the k tuples nearest to a point.
+};
+
+struct BatchQuery // one query of a batch. The caller fills in the query and its output buffers, and the worker running it fills in the result.
+{
+    enum BatchQueryType type;      // range or nearest neighbour query.
+    Bounds bounddefiners;          // window of a range query.
+    int *point;                    // query point of a nearest neighbour query.
+    int k;                         // number of neighbours of a nearest neighbour query.
+    enum DistanceMetric metric;    // distance used by a nearest neighbour query.
+    int **list_of_tuples;          // buffer receiving the tuples found: capacity tuples for a range query, k for a nearest neighbour query. A range query with a NULL buffer only counts.
+    long int capacity;             // number of tuples a range query may store.
+    unsigned long long *distances; // buffer receiving the k distances of a nearest neighbour query.
+    long int num_of_results;       // number of tuples found, or stored when a range query has a buffer.
+};
+
+struct QueryBatch // a batch being run by a worker pool.
+{
+    struct Rtree *rtree;         // tree queried.
+    struct BatchQuery *queries;  // the queries of the batch.
+    long int num_of_queries;     // number of queries in the batch.
+    atomic_long next_query;      // index of the next query not yet claimed by a worker.
+};
+
+void runBatchQuery(struct Rtree *rtree, struct BatchQuery *query) // runs one query of a batch on the calling thread.
+{
+    if (query->type == BATCH_KNN)
+        query->num_of_results = nearestNeighbours(rtree, query->point, query->k, query->metric, query->list_of_tuples, query->distances);
+    else if (query->list_of_tuples == NULL)
+        query->num_of_results = countTuplesInBounds(rtree, query->bounddefiners);
+    else
+        query->num_of_results = searchRtreeIntoBuffer(rtree, query->bounddefiners, query->list_of_tuples, query->capacity);
 }
 
-int main(int argc, char *argv[])
+void runQueryBatchJob(void *context, int worker) // worker pool job claiming the queries of a batch one at a time, so that a slow query never holds up queries queued behind it.
 {
-    struct Rtree *rtree = new_rtree(4, 2, 2);
-    printRtree(rtree);
-    if (argc != 2)
-    {
-        printf("Please provide a filename\n");
-        return 1;
-    }
-    read_tuples_and_insert(rtree, argv[1]);
-    printRtree(rtree);
-    free_rtree(rtree);
+    struct QueryBatch *batch = context;
+    (void)worker;
+    for (long int q = atomic_fetch_add(&batch->next_query, 1); q < batch->num_of_queries; q = atomic_fetch_add(&batch->next_query, 1))
+        runBatchQuery(batch->rtree, &batch->queries[q]);
+}
 
-    // run the script file
+void runQueryBatch(struct WorkerPool *pool, struct Rtree *rtree, struct BatchQuery *queries, long int num_of_queries) // runs a batch of queries against a tree that is not modified meanwhile, spreading them over the workers of the pool.
+{
+    struct QueryBatch batch = {rtree, queries, num_of_queries, 0};
+    runOnWorkerPool(pool, runQueryBatchJob, &batch);
+}
 
-    return 0;
-}
\ No newline at end of file
+struct StealDeque // nodes waiting to be searched by one worker. The owner pushes and pops at the bottom, idle workers steal from the top.
+{
+    pthread_mutex_t lock;  // protects the fields below.
+    struct Node **nodes;   // nodes[top] to nodes[bottom - 1] are waiting.
+    int top;               // index of the oldest waiting node, taken by thieves.
+    int bottom;            // index after the newest waiting node, taken by the owner.
+    int capacity;          // number of nodes the array can hold.
+};
+
+struct ParallelSearch // a range query being run by every worker of a pool.
+{
+    struct Rtree *rtree;        // tree searched.
+    Bounds bounddefiners;       // window searched.
+    struct StealDeque *deques;  // one deque of waiting nodes per worker.
+    int num_of_workers;         // number of workers taking part.
+    atomic_long pending;        // nodes pushed but not yet searched. The search is over once it drops to 0.
+    bool collect;               // whether the tuples found are collected, or only counted.
+    int ***results;             // per worker, the tuples found by that worker.
+    long int *num_of_results;   // per worker, the number of tuples found by that worker.
+    long int *result_capacity;  // per worker, the number of tuples its results array can hold.
+};
+
+void pushStealDeque(struct StealDeque *deque, struct Node *node) // adds a node at the bottom of a deque, growing it when needed.
+{
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom == deque->capacity)
+    {
+        if (deque->top > 0) // reclaims the slots freed by thieves before growing.
+        {
+            memmove(deque->nodes, deque->nodes + deque->top, sizeof(struct Node *) * (deque->bottom - deque->top));
+            deque->bottom -= deque->top;
+            deque->top = 0;
+        }
+        if (deque->bottom == deque->capacity)
+        {
+            deque->capacity = (deque->capacity == 0) ? 64 : deque->capacity * 2;
+            deque->nodes = realloc(deque->nodes, sizeof(struct Node *) * deque->capacity);
+        }
+    }
+    deque->nodes[deque->bottom++] = node;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+struct Node *takeStealDeque(struct StealDeque *deque, bool steal) // removes the newest node of a deque for its owner, or the oldest one for a thief. Returns NULL if the deque is empty.
+{
+    struct Node *node = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->top < deque->bottom)
+        node = steal ? deque->nodes[deque->top++] : deque->nodes[--deque->bottom];
+    pthread_mutex_unlock(&deque->lock);
+    return node;
+}
+
+void addParallelResult(struct ParallelSearch *search, int worker, int *tuple) // records a tuple found by a worker of a parallel range query.
+{
+    if (search->collect)
+    {
+        if (search->num_of_results[worker] == search->result_capacity[worker])
+        {
+            search->result_capacity[worker] = (search->result_capacity[worker] == 0) ? 256 : search->result_capacity[worker] * 2;
+            search->results[worker] = realloc(search->results[worker], sizeof(int *) * search->result_capacity[worker]);
+        }
+        search->results[worker][search->num_of_results[worker]] = tuple;
+    }
+    search->num_of_results[worker]++;
+}
+
+void parallelSearchJob(void *context, int worker) // worker pool job of a parallel range query: searches nodes from its own deque depth-first, and steals the oldest, largest subtrees of other workers when it runs dry.
+{
+    struct ParallelSearch *search = context;
+    int numofdimensions = search->rtree->numofdimensions;
+    while (atomic_load(&search->pending) > 0)
+    {
+        struct Node *node = takeStealDeque(&search->deques[worker], false);
+        for (int i = 1; node == NULL && i < search->num_of_workers; i++)
+            node = takeStealDeque(&search->deques[(worker + i) % search->num_of_workers], true);
+        if (node == NULL) // every waiting node is being searched by another worker, which may still push children.
+        {
+            sched_yield();
+            continue;
+        }
+
+        if (is_leaf(node))
+        {
+            for (int i = 0; i < node->num_of_children_or_tuples; i++)
+            {
+                if (entryMatchesPredicate(node, node->list_of_tuples[i], numofdimensions, search->bounddefiners, PREDICATE_INTERSECTS))
+                    addParallelResult(search, worker, node->list_of_tuples[i]);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < node->num_of_pending_tuples; i++) // buffered mode: the tuples waiting in the node.
+            {
+                if (checkIfTupleInBounds(search->bounddefiners, node->pending_tuples[i], numofdimensions))
+                    addParallelResult(search, worker, node->pending_tuples[i]);
+            }
+            for (int i = 0; i < node->num_of_children_or_tuples; i++)
+            {
+                if (overlaps(numofdimensions, search->bounddefiners, node->child_nodes[i]->bounddefiners))
+                {
+                    atomic_fetch_add(&search->pending, 1); // counted before the node itself is retired, so pending never reaches 0 early.
+                    pushStealDeque(&search->deques[worker], node->child_nodes[i]);
+                }
+            }
+        }
+        atomic_fetch_sub(&search->pending, 1);
+    }
+}
+
+long int parallelSearchRtree(struct WorkerPool *pool, struct Rtree *rtree, Bounds bounddefiners, int ***list_of_tuples) // searches one window with every worker of the pool, splitting the traversal by subtree. If list_of_tuples is not NULL, it receives a malloc'd array of the tuples found. Returns the number of tuples found.
+{
+    if (list_of_tuples != NULL)
+        *list_of_tuples = NULL;
+    if (rtree->root == NULL || !overlaps(rtree->numofdimensions, bounddefiners, rtree->root->bounddefiners))
+        return 0;
+
+    int num_of_workers = pool->num_of_threads;
+    struct ParallelSearch search;
+    search.rtree = rtree;
+    search.bounddefiners = bounddefiners;
+    search.num_of_workers = num_of_workers;
+    search.collect = (list_of_tuples != NULL);
+    search.deques = calloc(num_of_workers, sizeof(struct StealDeque));
+    search.results = calloc(num_of_workers, sizeof(int **));
+    search.num_of_results = calloc(num_of_workers, sizeof(long int));
+    search.result_capacity = calloc(num_of_workers, sizeof(long int));
+    for (int w = 0; w < num_of_workers; w++)
+        pthread_mutex_init(&search.deques[w].lock, NULL);
+    atomic_init(&search.pending, 1);
+    pushStealDeque(&search.deques[0], rtree->root);
+
+    runOnWorkerPool(pool, parallelSearchJob, &search);
+
+    long int numofresults = 0;
+    for (int w = 0; w < num_of_workers; w++)
+        numofresults += search.num_of_results[w];
+    if (search.collect) // concatenates the results of the workers.
+    {
+        *list_of_tuples = malloc(sizeof(int *) * (numofresults > 0 ? numofresults : 1));
+        long int offset = 0;
+        for (int w = 0; w < num_of_workers; w++)
+        {
+            memcpy(*list_of_tuples + offset, search.results[w], sizeof(int *) * search.num_of_results[w]);
+            offset += search.num_of_results[w];
+        }
+    }
+    for (int w = 0; w < num_of_workers; w++)
+    {
+        pthread_mutex_destroy(&search.deques[w].lock);
+        free(search.deques[w].nodes);
+        free(search.results[w]);
+    }
+    free(search.deques);
+    free(search.results);
+    free(search.num_of_results);
+    free(search.result_capacity);
+    return numofresults;
+}
+
+void printInternalNodeFromBounds(Bounds bounddefiners, int numofdimensions) // used to print the bounds of internal nodes i.e print all min() and max() values
+{
+    int min[numofdimensions]; // array min ,of size numofdimensions, to store the minimum values for each dimension.
+    int max[numofdimensions]; // array max ,of size numofdimensions, to store the maximum values for each dimension.
+    for (int i = 0; i < numofdimensions; i++)         // loops through each dimension and assigns the minimum and maximum values of that dimension to the min and max arrays respectively.
+    {
+        min[i] = bounddefiners[i].dmin;
+        max[i] = bounddefiners[i].dmax;
+    }
+    printTuple(min, numofdimensions); // prints the min array
+    printf(" ");
+    printTuple(max, numofdimensions); // prints the max array
+    printf("\n");
+}
+
+void printNode(struct Node *node, int numofdimensions, int depth) // prints the contents of a given node
+{
+    for (int i = 0; i < depth; i++)
+    {
+        printf(" ");
+    }
+    printf("[%d] ", depth);
+    if (is_leaf(node))
+    {
+        printf("Leaf Node: ");
+        for (int i = 0; i < node->num_of_children_or_tuples; i++)
+        {
+            if (node->extent_entries)
+                printExtent(node->list_of_tuples[i], numofdimensions);
+            else
+                printTuple(node->list_of_tuples[i], numofdimensions);
+            printf(" ");
+        }
+        printf("\n");
+    }
+    else
+    {
+        printf("Internal Node with %d children. Bounds: ", node->num_of_children_or_tuples);
+        printInternalNodeFromBounds(node->bounddefiners, numofdimensions);
+        if (node->num_of_pending_tuples > 0) // buffered mode: the tuples waiting in the node.
+        {
+            for (int i = 0; i <= depth; i++)
+                printf(" ");
+            printf("Pending: ");
+            for (int i = 0; i < node->num_of_pending_tuples; i++)
+            {
+                printTuple(node->pending_tuples[i], numofdimensions);
+                printf(" ");
+            }
+            printf("\n");
+        }
+        for (int i = 0; i < node->num_of_children_or_tuples; i++)
+        {
+            printNode(node->child_nodes[i], numofdimensions, depth + 1);
+        }
+    }
+}
+
+void printRtree(struct Rtree *rtree) // prints the contents of the R-tree
+{
+    if (rtree->root == NULL)
+    {
+        printf("Tree empty\n");
+        return;
+    }
+    printNode(rtree->root, rtree->numofdimensions, 0);
+}
+
+long int getAreaEnlargedOnInclusion(int numofdimensions, Bounds bounddefiners, int *tuple) // calculates the area enlarged on inclusion of a new tuple within the given bounding box
+// new method for area enlarged on inclusion
+{
+    long int orig_area = getArea(numofdimensions, bounddefiners); // original area of the bounding box is calculated using the getArea function.
+    long int new_area = 1;
+
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        if (tuple[i] < bounddefiners[i].dmin)
+            new_area *= (bounddefiners[i].dmax - tuple[i]);
+        else if (tuple[i] > bounddefiners[i].dmax)
+            new_area *= (tuple[i] - bounddefiners[i].dmin);
+        // If the new tuple lies outside the existing bounding box in a dimension, the area added is calculated as the difference between the new tuple's value and the corresponding boundary value.
+        else
+            new_area *= bounddefiners[i].dmax - bounddefiners[i].dmin;
+        //  If the new tuple lies inside the existing bounding box in a dimension, the area added is calculated as the width of the dimension of the bounding box that the new tuple falls within.
+    }
+    return new_area - orig_area; // returns area enlarged
+}
+
+ALWAYS_INLINE struct Node *chooseLeafInDimensions(int numofdimensions, int *tuple, struct Node *node) // body of chooseLeaf, inlined into one copy per dimension kernel so that a constant numofdimensions unrolls the area computations.
+{
+    while (!is_leaf(node)) // descends until the current node is a leaf node, which is returned as the selected leaf node.
+    {
+        long int minarea = LONG_MAX;
+        int minareaindex = -1;
+        long int minareaenlargedoninclusion = LONG_MAX;
+        for (int i = 0; i < node->num_of_children_or_tuples; i++) // for each child node of the current node, calculates the area enlarged on inclusion if the tuple is added to the child node's bounds.
+        {
+            long int areaenlargedoninclusion = getAreaEnlargedOnInclusion(numofdimensions, node->child_nodes[i]->bounddefiners, tuple);
+            if (areaenlargedoninclusion < minareaenlargedoninclusion) // selects the child node that results in the minimum area enlargement on inclusion.
+            {
+                minareaenlargedoninclusion = areaenlargedoninclusion;
+                minareaindex = i;
+            }
+            else if (areaenlargedoninclusion == minareaenlargedoninclusion) // If there is a tie, then selects the child node with the minimum area.
+            {
+                long int area = getArea(numofdimensions, node->child_nodes[i]->bounddefiners);
+                if (area < minarea)
+                {
+                    minarea = area;
+                    minareaindex = i;
+                }
+            }
+        }
+        node = node->child_nodes[minareaindex]; // continues with the selected child node as the new current node.
+    }
+    return node;
+}
+
+struct Node *chooseLeaf(int *tuple, struct Node *node, int numofdimensions) // selects a leaf node in which the given tuple should be inserted.
+{
+    return chooseLeafInDimensions(numofdimensions, tuple, node);
+}
+
+struct Node *chooseLeaf2D(int *tuple, struct Node *node) // chooseLeaf specialised for 2 dimensions.
+{
+    return chooseLeafInDimensions(2, tuple, node);
+}
+
+struct Node *chooseLeaf3D(int *tuple, struct Node *node) // chooseLeaf specialised for 3 dimensions.
+{
+    return chooseLeafInDimensions(3, tuple, node);
+}
+
+void getEnlargements(struct Node *node, int numofdimensions, int *tuple, double *areas, double *enlargements) // SoA layout: computes the area of the MBR of every child and its enlargement on inclusion of the tuple, in doubles so that SIMD lanes can hold them.
+{
+    int stride = node->entry_stride;
+    int j = 0;
+#if defined(__AVX2__)
+    for (; j < node->num_of_children_or_tuples; j += 4) // 4 children per step.
+    {
+        __m256d area = _mm256_set1_pd(1), enlarged_area = _mm256_set1_pd(1);
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            __m256d mins = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(node->entry_mins + i * stride + j)));
+            __m256d maxs = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(node->entry_maxs + i * stride + j)));
+            __m256d coordinate = _mm256_set1_pd(tuple[i]);
+            area = _mm256_mul_pd(area, _mm256_sub_pd(maxs, mins));
+            enlarged_area = _mm256_mul_pd(enlarged_area, _mm256_sub_pd(_mm256_max_pd(maxs, coordinate), _mm256_min_pd(mins, coordinate)));
+        }
+        _mm256_storeu_pd(areas + j, area);
+        _mm256_storeu_pd(enlargements + j, _mm256_sub_pd(enlarged_area, area));
+    }
+#elif defined(__SSE2__)
+    for (; j < node->num_of_children_or_tuples; j += 2) // 2 children per step.
+    {
+        __m128d area = _mm_set1_pd(1), enlarged_area = _mm_set1_pd(1);
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            __m128d mins = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(node->entry_mins + i * stride + j)));
+            __m128d maxs = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(node->entry_maxs + i * stride + j)));
+            __m128d coordinate = _mm_set1_pd(tuple[i]);
+            area = _mm_mul_pd(area, _mm_sub_pd(maxs, mins));
+            enlarged_area = _mm_mul_pd(enlarged_area, _mm_sub_pd(_mm_max_pd(maxs, coordinate), _mm_min_pd(mins, coordinate)));
+        }
+        _mm_storeu_pd(areas + j, area);
+        _mm_storeu_pd(enlargements + j, _mm_sub_pd(enlarged_area, area));
+    }
+#else
+    for (; j < node->num_of_children_or_tuples; j++) // scalar fallback, still reading the contiguous per-dimension arrays.
+    {
+        double area = 1, enlarged_area = 1;
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            double dmin = node->entry_mins[i * stride + j], dmax = node->entry_maxs[i * stride + j];
+            area *= dmax - dmin;
+            enlarged_area *= ((tuple[i] > dmax) ? tuple[i] : dmax) - ((tuple[i] < dmin) ? tuple[i] : dmin);
+        }
+        areas[j] = area;
+        enlargements[j] = enlarged_area - area;
+    }
+#endif
+}
+
+struct Node *chooseLeafSoA(struct Rtree *rtree, int *tuple) // chooseLeaf for the SoA layout: the child needing the least area enlargement, ties broken by the smallest area, is picked from enlargements computed for all children at once.
+{
+    struct Node *node = rtree->root;
+    double areas[node->entry_stride], enlargements[node->entry_stride];
+    while (!is_leaf(node))
+    {
+        getEnlargements(node, rtree->numofdimensions, tuple, areas, enlargements);
+        int minareaindex = 0;
+        for (int j = 1; j < node->num_of_children_or_tuples; j++)
+        {
+            if (enlargements[j] < enlargements[minareaindex] || (enlargements[j] == enlargements[minareaindex] && areas[j] < areas[minareaindex]))
+                minareaindex = j;
+        }
+        node = node->child_nodes[minareaindex];
+    }
+    return node;
+}
+
+struct Node *chooseLeafForTree(struct Rtree *rtree, int *tuple) // selects the leaf for a tuple with the node layout and dimension kernel of the R-tree.
+{
+    if (rtree->node_layout == LAYOUT_SOA)
+        return chooseLeafSoA(rtree, tuple);
+    switch (rtree->dimension_kernel)
+    {
+    case KERNEL_2D:
+        return chooseLeaf2D(tuple, rtree->root);
+    case KERNEL_3D:
+        return chooseLeaf3D(tuple, rtree->root);
+    default:
+        return chooseLeaf(tuple, rtree->root, rtree->numofdimensions);
+    }
+}
+
+struct Node *addTupleToLeafNode(int numofdimensions, int *tuple, struct Node *node) // adds a new tuple to an existing leaf node
+{
+    node->list_of_tuples[node->num_of_children_or_tuples++] = tuple; // stores the tuple in the next free inline slot of the node.
+    syncEntry(node, node->num_of_children_or_tuples - 1, numofdimensions);
+    if (node->extent_entries) // an extent enlarges the node by its whole MBR.
+    {
+        if (enlargeMBR(numofdimensions, node->bounddefiners, getExtentBounds(tuple)))
+            syncBoundsToParent(node, numofdimensions);
+        return node;
+    }
+    bool changed = false;
+    for (int i = 0; i < numofdimensions; i++) // updates the bounddefiners of the node by checking each dimension of the new tuple against the current bounds of the node.
+    {
+        if (tuple[i] < node->bounddefiners[i].dmin)
+        {
+            node->bounddefiners[i].dmin = tuple[i];
+            changed = true;
+        }
+        if (tuple[i] > node->bounddefiners[i].dmax)
+        {
+            node->bounddefiners[i].dmax = tuple[i];
+            changed = true;
+        }
+    }
+    if (changed)
+        syncBoundsToParent(node, numofdimensions);
+    return node; // returns a pointer to the modified leaf node.
+}
+
+void addToAggregate(struct Aggregate *aggregate, struct Aggregate *aggregate2) // merges the second aggregate into the first.
+{
+    aggregate->count += aggregate2->count;
+    aggregate->sum += aggregate2->sum;
+    aggregate->min = min(aggregate->min, aggregate2->min);
+    aggregate->max = max(aggregate->max, aggregate2->max);
+}
+
+void addTupleToAggregate(struct Rtree *rtree, struct Aggregate *aggregate, int *tuple) // counts one tuple, and its value, into an aggregate.
+{
+    aggregate->count++;
+    if (rtree->aggregate_value < 0)
+        return;
+    int value = tuple[rtree->aggregate_value];
+    aggregate->sum += value;
+    aggregate->min = min(aggregate->min, value);
+    aggregate->max = max(aggregate->max, value);
+}
+
+void updateAggregate(struct Rtree *rtree, struct Node *node) // aggregate trees: recomputes the aggregate of a node from its entries, whose own aggregates are up to date.
+{
+    node->aggregate = (struct Aggregate){0, 0, INT_MAX, INT_MIN};
+    for (int i = 0; i < node->num_of_children_or_tuples; i++)
+    {
+        if (is_leaf(node))
+            addTupleToAggregate(rtree, &node->aggregate, node->list_of_tuples[i]);
+        else
+            addToAggregate(&node->aggregate, &node->child_nodes[i]->aggregate);
+    }
+}
+
+void refreshAggregatesOnPath(struct Rtree *rtree, struct Node *node) // aggregate trees: recomputes the aggregates of a node whose entries changed and of all its ancestors.
+{
+    for (; rtree->aggregates && node != NULL; node = node->parent)
+        updateAggregate(rtree, node);
+}
+
+void refreshAggregates(struct Rtree *rtree, struct Node *node) // aggregate trees: recomputes the aggregates of a whole subtree bottom-up, after it was packed or batch-inserted.
+{
+    if (!rtree->aggregates || node == NULL)
+        return;
+    for (int i = 0; !is_leaf(node) && i < node->num_of_children_or_tuples; i++)
+        refreshAggregates(rtree, node->child_nodes[i]);
+    updateAggregate(rtree, node);
+}
+
+void growTreeIfRootSplit(struct Rtree *rtree, struct Node *split_root) // If the root node was split, a new root node is created and the two split nodes are added as children
+{
+    if (split_root != NULL)
+    {
+        COUNT_STAT(rtree->insert_counters.root_splits, 1);
+        struct Node *new_root = new_node(rtree, false);
+        addChildNode2Parent(new_root, rtree->root, rtree->numofdimensions);
+        addChildNode2Parent(new_root, split_root, rtree->numofdimensions);
+        rtree->root = new_root;
+        refreshAggregatesOnPath(rtree, new_root);
+    }
+}
+
+struct Node *chooseNodeAtLevel(struct Rtree *rtree, Bounds bounddefiners, int level); // selects the node at the given level whose MBR needs the least enlargement to include the given MBR.
+
+void insertStoredTuple(struct Rtree *rtree, int *tuple) // inserts a tuple that is already held by the tuple pool of the R-tree.
+{
+    if (rtree->concurrent)
+        concurrentInsertStoredTuple(rtree, tuple);
+    else if (rtree->root == NULL) // If the tree is empty, create a new root
+    {
+        rtree->root = new_node(rtree, true);
+        addTupleToLeafNode(rtree->numofdimensions, tuple, rtree->root);
+        refreshAggregatesOnPath(rtree, rtree->root);
+    }
+    else if (rtree->insert_policy == INSERT_RSTAR)
+    {
+        insertRstar(rtree, tuple);
+    }
+    else // If the tree is not empty, traverse it to find the appropriate leaf node to insert the tuple
+    {
+        struct Node *leaf_node = rtree->extent_entries ? chooseNodeAtLevel(rtree, getExtentBounds(tuple), 0) : chooseLeafForTree(rtree, tuple); // the kernels choose the leaf for a point.
+        struct Node *split_leaf_node = NULL;
+
+        // Add the tuple to the leaf node
+        if (leaf_node->num_of_children_or_tuples < rtree->max_entries) // Checks If there is space in the leaf node
+        {
+            leaf_node = addTupleToLeafNode(rtree->numofdimensions, tuple, leaf_node);
+        }
+        else // If there is no space in the leaf node, split it
+        {
+            split_leaf_node = nodeSplit_leaf(rtree, leaf_node, tuple);
+        }
+
+        struct Node *split_root = adjust_tree(rtree, leaf_node, split_leaf_node); // After the leaf node is split, adjust_tree is called to adjust the tree and propagate the changes up to the root node.
+        growTreeIfRootSplit(rtree, split_root);
+    }
+}
+
+bool insert(struct Rtree *rtree, int *tuple) // used to insert a new tuple into the R-tree. The tuple is copied into the tuple pool of the tree. Returns false on an extent tree, which takes insert_extent.
+{
+    if (rtree->extent_entries) // a point is shorter than an extent record.
+        return false;
+    if (rtree->concurrent) // the tuple pool is shared by the writers, so the copy is made under the writer lock too.
+    {
+        pthread_mutex_lock(&rtree->writer_lock);
+        int *stored_tuple = storeTuple(rtree, tuple);
+        pthread_mutex_unlock(&rtree->writer_lock);
+        insertStoredTuple(rtree, stored_tuple);
+        return true;
+    }
+    if (rtree->query_cache != NULL) // the cached windows holding the new tuple are out of date.
+        invalidateQueryCacheAtTuple(rtree, tuple);
+    if (rtree->buffer_capacity > 0 && rtree->insert_policy == INSERT_GUTTMAN && !rtree->aggregates) // buffered mode: the tuple waits in the root until a flush carries it down.
+    {
+        bufferedInsert(rtree, storeTuple(rtree, tuple));
+        return true;
+    }
+    insertStoredTuple(rtree, storeTuple(rtree, tuple));
+    return true;
+}
+
+bool adjustNodeMBR(struct Node *node1, int numofdimensions) // recomputes the MBR (minimum bounding rectangle) of a given node in place from its entries. Returns true if the MBR changed.
+{
+    bool changed = false;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        int dmin = INT_MAX, dmax = INT_MIN;
+        for (int j = 0; j < node1->num_of_children_or_tuples; j++) // takes the extent of all the child nodes, or of all the tuples for a leaf node, in the current dimension.
+        {
+            if (node1->extent_entries)
+            {
+                dmin = min(dmin, getExtentBounds(node1->list_of_tuples[j])[i].dmin);
+                dmax = max(dmax, getExtentBounds(node1->list_of_tuples[j])[i].dmax);
+            }
+            else if (is_leaf(node1))
+            {
+                dmin = min(dmin, node1->list_of_tuples[j][i]);
+                dmax = max(dmax, node1->list_of_tuples[j][i]);
+            }
+            else
+            {
+                dmin = min(dmin, node1->child_nodes[j]->bounddefiners[i].dmin);
+                dmax = max(dmax, node1->child_nodes[j]->bounddefiners[i].dmax);
+            }
+        }
+        if (dmin != node1->bounddefiners[i].dmin || dmax != node1->bounddefiners[i].dmax)
+        {
+            node1->bounddefiners[i].dmin = dmin;
+            node1->bounddefiners[i].dmax = dmax;
+            changed = true;
+        }
+    }
+    if (changed)
+        syncBoundsToParent(node1, numofdimensions);
+    return changed;
+}
+
+struct Node *adjust_tree(struct Rtree *rtree, struct Node *node1, struct Node *node2) // walks from node1 up to the root, propagating a split of node1 into node2 and updating the MBRs on the path. Returns the split sibling of the root, if the root was split.
+{
+    // If node1 was split, its MBR may have shrunk, so its parent must be recomputed from scratch. Otherwise node1 only grew and its parent can simply be enlarged.
+    bool shrunk = (node2 != NULL);
+    if (rtree->aggregates) // the entries of node1, and of node2, changed.
+    {
+        updateAggregate(rtree, node1);
+        if (node2 != NULL)
+            updateAggregate(rtree, node2);
+    }
+    // Step 1 : stop when N == root
+    while (node1->parent != NULL)
+    {
+        struct Node *parent_node = node1->parent;
+        struct Node *parent_split = NULL;
+
+        // Step 2: Propogate Node Split
+        if (node2 != NULL && parent_node->num_of_children_or_tuples < rtree->max_entries)
+        {
+            // to add node to parent node's list of child nodes
+            addChildNode2Parent(parent_node, node2, rtree->numofdimensions);
+        }
+        else if (node2 != NULL)
+        { // to split node
+            parent_split = nodeSplit(rtree, parent_node, node2);
+        }
+
+        // Step 3: Adjust the MBR of the parent. A split already rebuilt it from the new children, and adding node2 may already have enlarged it.
+        bool changed;
+        if (parent_split != NULL)
+            changed = true;
+        else if (shrunk)
+            changed = adjustNodeMBR(parent_node, rtree->numofdimensions) || node2 != NULL;
+        else if ((changed = enlargeMBR(rtree->numofdimensions, parent_node->bounddefiners, node1->bounddefiners)))
+            syncBoundsToParent(parent_node, rtree->numofdimensions);
+        if (rtree->aggregates)
+        {
+            updateAggregate(rtree, parent_node);
+            if (parent_split != NULL)
+                updateAggregate(rtree, parent_split);
+        }
+
+        if (!changed) // the MBR of the parent did not change, so neither do the MBRs of its ancestors. Only their aggregates still need the new counts.
+        {
+            refreshAggregatesOnPath(rtree, parent_node->parent);
+            return NULL;
+        }
+
+        // Step 4: Move upto next level
+        shrunk = shrunk || parent_split != NULL;
+        node1 = parent_node;
+        node2 = parent_split;
+    }
+    return node2;
+}
+
+// NOTES for nodeSplit
+// 1. Both nodeSplit and nodeSplit_leaf gather the max_entries + 1 entries into the SplitArray and run the same quadratic split on their MBRs.
+// 2. All nodes after nodeSplit must have MBR adjusted !! (Very Imp)
+// 3. Use Quadratic Splitting for PickNext
+
+struct SplitArray // scratch space used while splitting an overflowing node. It is allocated once per tree and reused by every split.
+{
+    void **entries;                       // the max_entries + 1 entries taking part in the split, child nodes or tuples.
+    Bounds *entry_bounds;                 // MBR of each entry.
+    struct BoundDefiner *point_bounds;    // storage for the degenerate MBRs of tuples when a leaf node is split.
+    int *remaining;                       // indices of the entries not yet assigned to a group, in scan order.
+    int numofremaining;                   // number of entries not yet assigned to a group.
+    int *groups[2];                       // indices of the entries assigned to each group, in assignment order.
+    int group_size[2];                    // number of entries assigned to each group.
+    struct BoundDefiner *group_bounds[2]; // MBR of each group.
+    struct SplitSortKey *sort_keys;       // entries sorted along one axis, used by the R* split.
+    struct BoundDefiner *prefix_bounds;   // MBR of the first i + 1 sorted entries, used by the R* split.
+    struct BoundDefiner *suffix_bounds;   // MBR of the sorted entries from i onwards, used by the R* split.
+};
+
+struct SplitSortKey // an entry of the split array with its sort key along one axis.
+{
+    long long key;  // lower (or upper) boundary of the entry along the axis.
+    long long key2; // the other boundary, breaking ties.
+    int entry;      // index of the entry in the split array.
+};
+
+struct SplitArray *newSplitArray(int max_entries, int numofdimensions)
+{
+    struct SplitArray *splitArray = malloc(sizeof(struct SplitArray)); // allocates memory for a new SplitArray struct using malloc().
+    int num_of_entries = max_entries + 1;                              // a split always involves the max_entries entries of the full node plus the new one.
+    splitArray->entries = malloc(sizeof(void *) * num_of_entries);
+    splitArray->entry_bounds = malloc(sizeof(Bounds) * num_of_entries);
+    splitArray->point_bounds = malloc(sizeof(struct BoundDefiner) * numofdimensions * num_of_entries);
+    splitArray->remaining = malloc(sizeof(int) * num_of_entries);
+    for (int g = 0; g < 2; g++)
+    {
+        splitArray->groups[g] = malloc(sizeof(int) * num_of_entries);
+        splitArray->group_bounds[g] = malloc(sizeof(struct BoundDefiner) * numofdimensions);
+    }
+    splitArray->sort_keys = malloc(sizeof(struct SplitSortKey) * num_of_entries);
+    splitArray->prefix_bounds = malloc(sizeof(struct BoundDefiner) * numofdimensions * num_of_entries);
+    splitArray->suffix_bounds = malloc(sizeof(struct BoundDefiner) * numofdimensions * num_of_entries);
+    return splitArray; // returns a pointer to the newly created SplitArray struct.
+}
+
+void freeSplitArray(struct SplitArray *splitArray)
+{
+    free(splitArray->entries);
+    free(splitArray->entry_bounds);
+    free(splitArray->point_bounds);
+    free(splitArray->remaining);
+    for (int g = 0; g < 2; g++)
+    {
+        free(splitArray->groups[g]);
+        free(splitArray->group_bounds[g]);
+    }
+    free(splitArray->sort_keys);
+    free(splitArray->prefix_bounds);
+    free(splitArray->suffix_bounds);
+    free(splitArray);
+}
+
+long int getAreaOfBoundingBox(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) // calculates the area of the bounding box that contains two given MBRs without building it.
+{
+    long int area = 1;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        area *= (max(bounddefiners[i].dmax, bounddefiners2[i].dmax) - min(bounddefiners[i].dmin, bounddefiners2[i].dmin));
+    }
+    return area;
+}
+
+void removeNodeFromSplitArray(struct SplitArray *splitArray, int ind) // removes the entry at position ind from the entries not yet assigned to a group
+{
+    for (int j = ind; j < splitArray->numofremaining - 1; j++) // shifts each following entry one position to the left, effectively overwriting the entry at position ind.
+    {
+        splitArray->remaining[j] = splitArray->remaining[j + 1];
+    }
+    splitArray->numofremaining--; // updating number of remaining entries
+}
+
+void assignEntryToGroup(struct SplitArray *splitArray, int group, int ind, int numofdimensions) // assigns the entry at position ind of the remaining entries to a group and grows the MBR of the group.
+{
+    int entry = splitArray->remaining[ind];
+    Bounds entry_bounds = splitArray->entry_bounds[entry];
+    Bounds group_bounds = splitArray->group_bounds[group];
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        if (splitArray->group_size[group] == 0) // the first entry of a group defines its MBR.
+        {
+            group_bounds[i] = entry_bounds[i];
+        }
+        else
+        {
+            group_bounds[i].dmin = min(group_bounds[i].dmin, entry_bounds[i].dmin);
+            group_bounds[i].dmax = max(group_bounds[i].dmax, entry_bounds[i].dmax);
+        }
+    }
+    splitArray->groups[group][splitArray->group_size[group]++] = entry;
+    removeNodeFromSplitArray(splitArray, ind);
+}
+
+void assignSeeds(struct SplitArray *splitArray, int seed1, int seed2, int numofdimensions) // assigns the entry seed1 to the first group and the entry seed2 to the second group.
+{
+    for (int g = 1; g >= 0; g--) // the second seed is assigned first, which keeps the scan order of the remaining entries of the quadratic split.
+    {
+        int seed = (g == 0) ? seed1 : seed2;
+        for (int i = 0; i < splitArray->numofremaining; i++)
+        {
+            if (splitArray->remaining[i] == seed)
+            {
+                assignEntryToGroup(splitArray, g, i, numofdimensions);
+                break;
+            }
+        }
+    }
+}
+
+void pickSeed(int numofdimensions, struct SplitArray *splitArray) // used in the process of selecting two entries as seeds for splitting a node
+{
+    long int max_area_inclusion_difference = LONG_MIN;
+    int index1 = 0, index2 = 0;
+    for (int i = 0; i < splitArray->numofremaining; i++) // Loop through all the entries in the split array.
+    {
+        Bounds bounds_i = splitArray->entry_bounds[splitArray->remaining[i]];
+        for (int j = i + 1; j < splitArray->numofremaining; j++) //  Loop through all the entries in the split array again, but starting after the current value of i.
+        {
+            Bounds bounds_j = splitArray->entry_bounds[splitArray->remaining[j]];
+            // Calculate the difference in area of the bounding box that would be created if the two entries at indices i and j were merged and the areas of their original bounding boxes. This difference represents the maximum amount by which the new bounding box would be expanded if these two entries were chosen as seeds.
+            long int temp_area_difference = getAreaOfBoundingBox(numofdimensions, bounds_i, bounds_j) - getArea(numofdimensions, bounds_i) - getArea(numofdimensions, bounds_j);
+            if (temp_area_difference > max_area_inclusion_difference)
+            {
+                max_area_inclusion_difference = temp_area_difference;
+                index1 = i;
+                index2 = j;
+            }
+        }
+    }
+    assignSeeds(splitArray, splitArray->remaining[index1], splitArray->remaining[index2], numofdimensions);
+}
+
+void addChildNode2Parent(struct Node *parent_node, struct Node *child_node, int numofdimensions) // adds a child node to a given parent node
+{
+    parent_node->num_of_children_or_tuples++;                                          // updates the number of child nodes of the parent node.
+    parent_node->child_nodes[parent_node->num_of_children_or_tuples - 1] = child_node; // assigns the child node to the next free inline slot of the parent node.
+    child_node->parent = parent_node;                                                  // sets the parent of the child node to be the parent node.
+    if (parent_node->num_of_children_or_tuples == 1)
+    {
+        // sets the bounding box of the parent node to be the same as the bounding box of the child node.
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            parent_node->bounddefiners[i].dmax = child_node->bounddefiners[i].dmax;
+            parent_node->bounddefiners[i].dmin = child_node->bounddefiners[i].dmin;
+        }
+    }
+    else
+    {
+        // adjusts the bounding box of the parent node to accommodate the new child node by taking the minimum and maximum values of the bounding box dimensions.
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            parent_node->bounddefiners[i].dmax = max(child_node->bounddefiners[i].dmax, parent_node->bounddefiners[i].dmax);
+            parent_node->bounddefiners[i].dmin = min(child_node->bounddefiners[i].dmin, parent_node->bounddefiners[i].dmin);
+        }
+    }
+    if (parent_node->entry_mins != NULL) // SoA layout: mirrors the new entry, and the possibly enlarged MBR of the parent in the grandparent.
+    {
+        syncEntry(parent_node, parent_node->num_of_children_or_tuples - 1, numofdimensions);
+        syncBoundsToParent(parent_node, numofdimensions);
+    }
+}
+
+void pickNext(struct SplitArray *splitArray, int numofdimensions) // helper function used in the process of splitting a node as it helps to select which of the two groups the next entry from the split array should be added to.
+{
+    long int max_area_difference = LONG_MIN;
+    int group = 0; // group that will receive the next entry.
+    int index = 0; // position of the next entry among the remaining entries.
+    long int area_group1 = getArea(numofdimensions, splitArray->group_bounds[0]);
+    long int area_group2 = getArea(numofdimensions, splitArray->group_bounds[1]);
+    for (int i = 0; i < splitArray->numofremaining; i++) // iterates over each remaining entry in the split array.
+    {
+        // calculates the difference between the areas of the bounding boxes that would result if the entry were added to either group.
+        Bounds entry_bounds = splitArray->entry_bounds[splitArray->remaining[i]];
+        long int area4group1 = getAreaOfBoundingBox(numofdimensions, entry_bounds, splitArray->group_bounds[0]) - area_group1;
+        long int area4group2 = getAreaOfBoundingBox(numofdimensions, entry_bounds, splitArray->group_bounds[1]) - area_group2;
+        // selects the entry that results in the largest difference in area between the two groups.
+        if (labs(area4group1 - area4group2) > max_area_difference)
+        {
+            max_area_difference = labs(area4group1 - area4group2);
+            group = (area4group1 > area4group2) ? 1 : 0;
+            index = i;
+        }
+    }
+    // adds the selected entry to the chosen group, and removes it from the split array.
+    assignEntryToGroup(splitArray, group, index, numofdimensions);
+}
+
+void resetSplitArray(struct Rtree *rtree, struct SplitArray *splitArray) // marks all max_entries + 1 entries of the split array as unassigned.
+{
+    splitArray->numofremaining = rtree->max_entries + 1;
+    for (int i = 0; i < splitArray->numofremaining; i++)
+        splitArray->remaining[i] = i;
+    splitArray->group_size[0] = splitArray->group_size[1] = 0;
+}
+
+void quadraticSplit(struct Rtree *rtree, struct SplitArray *splitArray) // distributes the max_entries + 1 entries of the split array between two groups using Guttman's quadratic split.
+{
+    resetSplitArray(rtree, splitArray);
+
+    // Step 1: Call pickSeed
+    pickSeed(rtree->numofdimensions, splitArray);
+
+    // Step 2: Call pickNext if min_enties not fulfilled
+    for (int i = 0; i < rtree->max_entries - 1; i++)
+    {
+        if (splitArray->group_size[0] + splitArray->numofremaining == rtree->min_entries && splitArray->group_size[1] >= rtree->min_entries)
+        {
+            // If the first group needs every remaining entry to reach the minimum number of entries, then add the entry to the first group.
+            assignEntryToGroup(splitArray, 0, 0, rtree->numofdimensions);
+        }
+        else if (splitArray->group_size[1] + splitArray->numofremaining == rtree->min_entries && splitArray->group_size[0] >= rtree->min_entries)
+        {
+            // If the second group needs every remaining entry to reach the minimum number of entries, then add the entry to the second group.
+            assignEntryToGroup(splitArray, 1, 0, rtree->numofdimensions);
+        }
+        // If neither of the above conditions are true, call pickNext to determine which group to add the entry to.
+        else
+        {
+            pickNext(splitArray, rtree->numofdimensions);
+        }
+    }
+}
+
+void linearPickSeeds(int numofdimensions, struct SplitArray *splitArray) // picks as seeds the pair of entries with the greatest separation along any dimension, normalised by the width of the whole set.
+{
+    int num_of_entries = splitArray->numofremaining;
+    double best_separation = -1;
+    int seed1 = 0, seed2 = 1;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        int highest_low = 0; // entry with the highest lower boundary.
+        int set_min = INT_MAX, set_max = INT_MIN;
+        for (int j = 0; j < num_of_entries; j++)
+        {
+            Bounds bounds = splitArray->entry_bounds[j];
+            if (bounds[i].dmin > splitArray->entry_bounds[highest_low][i].dmin)
+                highest_low = j;
+            set_min = min(set_min, bounds[i].dmin);
+            set_max = max(set_max, bounds[i].dmax);
+        }
+        int lowest_high = (highest_low == 0) ? 1 : 0; // entry with the lowest upper boundary, other than highest_low.
+        for (int j = 0; j < num_of_entries; j++)
+        {
+            if (j != highest_low && splitArray->entry_bounds[j][i].dmax < splitArray->entry_bounds[lowest_high][i].dmax)
+                lowest_high = j;
+        }
+        double width = (double)set_max - set_min;
+        double separation = (width > 0) ? ((double)splitArray->entry_bounds[highest_low][i].dmin - splitArray->entry_bounds[lowest_high][i].dmax) / width : 0;
+        if (separation > best_separation)
+        {
+            best_separation = separation;
+            seed1 = lowest_high;
+            seed2 = highest_low;
+        }
+    }
+    assignSeeds(splitArray, seed1, seed2, numofdimensions);
+}
+
+void linearSplit(struct Rtree *rtree, struct SplitArray *splitArray) // distributes the entries of the split array between two groups using Guttman's linear split.
+{
+    int numofdimensions = rtree->numofdimensions;
+    resetSplitArray(rtree, splitArray);
+    linearPickSeeds(numofdimensions, splitArray);
+
+    while (splitArray->numofremaining > 0) // the remaining entries are assigned in order, each to the group whose MBR grows least.
+    {
+        int group;
+        if (splitArray->group_size[0] + splitArray->numofremaining <= rtree->min_entries) // the first group needs every remaining entry to reach min_entries.
+        {
+            group = 0;
+        }
+        else if (splitArray->group_size[1] + splitArray->numofremaining <= rtree->min_entries) // so does the second group.
+        {
+            group = 1;
+        }
+        else
+        {
+            Bounds entry_bounds = splitArray->entry_bounds[splitArray->remaining[0]];
+            long int area1 = getArea(numofdimensions, splitArray->group_bounds[0]);
+            long int area2 = getArea(numofdimensions, splitArray->group_bounds[1]);
+            long int enlargement1 = getAreaOfBoundingBox(numofdimensions, entry_bounds, splitArray->group_bounds[0]) - area1;
+            long int enlargement2 = getAreaOfBoundingBox(numofdimensions, entry_bounds, splitArray->group_bounds[1]) - area2;
+            if (enlargement1 != enlargement2) // ties are resolved by the smaller area, then by the fewer entries.
+                group = (enlargement1 < enlargement2) ? 0 : 1;
+            else if (area1 != area2)
+                group = (area1 < area2) ? 0 : 1;
+            else
+                group = (splitArray->group_size[0] <= splitArray->group_size[1]) ? 0 : 1;
+        }
+        assignEntryToGroup(splitArray, group, 0, numofdimensions);
+    }
+}
+
+int compareSplitSortKeys(const void *a, const void *b) // qsort comparator ordering split entries by their key, then by their second key.
+{
+    const struct SplitSortKey *key1 = a, *key2 = b;
+    if (key1->key != key2->key)
+        return (key1->key > key2->key) ? 1 : -1;
+    if (key1->key2 != key2->key2)
+        return (key1->key2 > key2->key2) ? 1 : -1;
+    return key1->entry - key2->entry;
+}
+
+void sortSplitEntries(struct SplitArray *splitArray, int num_of_entries, int axis, bool by_upper) // sorts the entries of the split array along an axis by their lower or upper boundary.
+{
+    for (int j = 0; j < num_of_entries; j++)
+    {
+        Bounds bounds = splitArray->entry_bounds[j];
+        splitArray->sort_keys[j].key = by_upper ? bounds[axis].dmax : bounds[axis].dmin;
+        splitArray->sort_keys[j].key2 = by_upper ? bounds[axis].dmin : bounds[axis].dmax;
+        splitArray->sort_keys[j].entry = j;
+    }
+    qsort(splitArray->sort_keys, num_of_entries, sizeof(struct SplitSortKey), compareSplitSortKeys);
+}
+
+void computeSplitPrefixSuffixBounds(struct SplitArray *splitArray, int num_of_entries, int numofdimensions) // computes the MBRs of every prefix and suffix of the sorted entries.
+{
+    for (int j = 0; j < num_of_entries; j++)
+    {
+        Bounds prefix = splitArray->prefix_bounds + j * numofdimensions;
+        memcpy(prefix, splitArray->entry_bounds[splitArray->sort_keys[j].entry], sizeof(struct BoundDefiner) * numofdimensions);
+        if (j > 0)
+            enlargeMBR(numofdimensions, prefix, prefix - numofdimensions);
+    }
+    for (int j = num_of_entries - 1; j >= 0; j--)
+    {
+        Bounds suffix = splitArray->suffix_bounds + j * numofdimensions;
+        memcpy(suffix, splitArray->entry_bounds[splitArray->sort_keys[j].entry], sizeof(struct BoundDefiner) * numofdimensions);
+        if (j < num_of_entries - 1)
+            enlargeMBR(numofdimensions, suffix, suffix + numofdimensions);
+    }
+}
+
+long int getMargin(int numofdimensions, Bounds bounddefiners) // calculates the margin of an MBR, the sum of its extents in every dimension.
+{
+    long int margin = 0;
+    for (int i = 0; i < numofdimensions; i++)
+        margin += (long int)bounddefiners[i].dmax - bounddefiners[i].dmin;
+    return margin;
+}
+
+long int getOverlapArea(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2) // calculates the area of the intersection of two MBRs, 0 if they are disjoint.
+{
+    long int area = 1;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        long int extent = (long int)min(bounddefiners[i].dmax, bounddefiners2[i].dmax) - max(bounddefiners[i].dmin, bounddefiners2[i].dmin);
+        if (extent < 0)
+            return 0;
+        area *= extent;
+    }
+    return area;
+}
+
+void rstarSplit(struct Rtree *rtree, struct SplitArray *splitArray) // distributes the entries of the split array between two groups using the R*-tree split.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_entries = rtree->max_entries + 1;
+    int m = rtree->min_entries;
+
+    // ChooseSplitAxis: the axis whose distributions have the smallest total margin.
+    int best_axis = 0;
+    long int best_margin = LONG_MAX;
+    for (int axis = 0; axis < numofdimensions; axis++)
+    {
+        long int margin = 0;
+        for (int upper = 0; upper < 2; upper++)
+        {
+            sortSplitEntries(splitArray, num_of_entries, axis, upper);
+            computeSplitPrefixSuffixBounds(splitArray, num_of_entries, numofdimensions);
+            for (int k = m; k <= num_of_entries - m; k++) // the first group holds the first k sorted entries.
+            {
+                margin += getMargin(numofdimensions, splitArray->prefix_bounds + (k - 1) * numofdimensions);
+                margin += getMargin(numofdimensions, splitArray->suffix_bounds + k * numofdimensions);
+            }
+        }
+        if (margin < best_margin)
+        {
+            best_margin = margin;
+            best_axis = axis;
+        }
+    }
+
+    // ChooseSplitIndex: along that axis, the distribution with the least overlap, ties resolved by the least total area.
+    long int best_overlap = LONG_MAX, best_area = LONG_MAX;
+    int best_upper = 0, best_k = m;
+    for (int upper = 0; upper < 2; upper++)
+    {
+        sortSplitEntries(splitArray, num_of_entries, best_axis, upper);
+        computeSplitPrefixSuffixBounds(splitArray, num_of_entries, numofdimensions);
+        for (int k = m; k <= num_of_entries - m; k++)
+        {
+            Bounds first = splitArray->prefix_bounds + (k - 1) * numofdimensions;
+            Bounds second = splitArray->suffix_bounds + k * numofdimensions;
+            long int overlap = getOverlapArea(numofdimensions, first, second);
+            long int area = getArea(numofdimensions, first) + getArea(numofdimensions, second);
+            if (overlap < best_overlap || (overlap == best_overlap && area < best_area))
+            {
+                best_overlap = overlap;
+                best_area = area;
+                best_upper = upper;
+                best_k = k;
+            }
+        }
+    }
+
+    sortSplitEntries(splitArray, num_of_entries, best_axis, best_upper);
+    resetSplitArray(rtree, splitArray);
+    splitArray->numofremaining = 0; // every entry is assigned directly from the sorted order.
+    for (int j = 0; j < num_of_entries; j++)
+    {
+        int group = (j < best_k) ? 0 : 1;
+        splitArray->groups[group][splitArray->group_size[group]++] = splitArray->sort_keys[j].entry;
+    }
+}
+
+void splitEntries(struct Rtree *rtree, struct SplitArray *splitArray) // distributes the entries of the split array between two groups with the split policy of the R-tree.
+{
+    switch (rtree->split_policy)
+    {
+    case SPLIT_LINEAR:
+        linearSplit(rtree, splitArray);
+        break;
+    case SPLIT_RSTAR:
+        rstarSplit(rtree, splitArray);
+        break;
+    default:
+        quadraticSplit(rtree, splitArray);
+        break;
+    }
+}
+
+void emptyNode(struct Node *node, int numofdimensions) // used to clear out the contents of a node, making it empty and ready to be reused. When a node becomes empty, it can be reused by splitting the contents of another node or by moving its contents to a parent node.
+{
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        node->bounddefiners[i].dmax = INT_MIN;
+        node->bounddefiners[i].dmin = INT_MAX;
+    }
+    node->num_of_children_or_tuples = 0;
+}
+
+struct Node *nodeSplit(struct Rtree *rtree, struct Node *parent_node, struct Node *child_node) // Splits a node in an R tree
+{
+    struct SplitArray *splitArray = rtree->splitArray; // will be used to store the child nodes that need to be split between the parent and the new split node.
+    splitArray->entries[0] = child_node;              // the new child node comes first, followed by the children of the parent node.
+    for (int i = 0; i < parent_node->num_of_children_or_tuples; i++)
+        splitArray->entries[i + 1] = parent_node->child_nodes[i];
+    for (int i = 0; i <= rtree->max_entries; i++)
+        splitArray->entry_bounds[i] = ((struct Node *)splitArray->entries[i])->bounddefiners;
+
+    splitEntries(rtree, splitArray);
+
+    COUNT_STAT(rtree->insert_counters.internal_splits, 1);
+    struct Node *split_node = new_node(rtree, false); // This node will be used as the new split node.
+    emptyNode(parent_node, rtree->numofdimensions);   // empties the parent node, necessary because the parent node will be used to store the first group after the split.
+    for (int i = 0; i < splitArray->group_size[0]; i++)
+        addChildNode2Parent(parent_node, splitArray->entries[splitArray->groups[0][i]], rtree->numofdimensions);
+    for (int i = 0; i < splitArray->group_size[1]; i++)
+        addChildNode2Parent(split_node, splitArray->entries[splitArray->groups[1][i]], rtree->numofdimensions);
+
+    split_node->parent = NULL; // sets the parent of split_node to NULL.
+    return split_node;         // Returns the newly created split_node.
+}
+
+struct Node *nodeSplit_leaf(struct Rtree *rtree, struct Node *leaf_node, int *tuple) // used to split a leaf node
+{
+    struct SplitArray *splitArray = rtree->splitArray;
+    int numofdimensions = rtree->numofdimensions;
+    for (int i = 0; i <= rtree->max_entries; i++) // the new tuple comes first, followed by the tuples of the leaf node. Each tuple gets a degenerate MBR, and each extent record its own.
+    {
+        int *entry = (i == 0) ? tuple : leaf_node->list_of_tuples[i - 1];
+        Bounds bounds = leaf_node->extent_entries ? getExtentBounds(entry) : splitArray->point_bounds + i * numofdimensions;
+        for (int j = 0; !leaf_node->extent_entries && j < numofdimensions; j++)
+        {
+            bounds[j].dmin = entry[j];
+            bounds[j].dmax = entry[j];
+        }
+        splitArray->entries[i] = entry;
+        splitArray->entry_bounds[i] = bounds;
+    }
+
+    splitEntries(rtree, splitArray);
+
+    COUNT_STAT(rtree->insert_counters.leaf_splits, 1);
+    struct Node *split_leaf_node = new_node(rtree, true);
+    emptyNode(leaf_node, numofdimensions); // Clear the contents of leaf node.
+    for (int i = 0; i < splitArray->group_size[0]; i++)
+        addTupleToLeafNode(numofdimensions, splitArray->entries[splitArray->groups[0][i]], leaf_node);
+    for (int i = 0; i < splitArray->group_size[1]; i++)
+        addTupleToLeafNode(numofdimensions, splitArray->entries[splitArray->groups[1][i]], split_leaf_node);
+
+    return split_leaf_node; // Returns the split leaf node.
+}
+
+// R*-tree insertion
+// Beckmann et al.'s insertion differs from Guttman's in two ways. Among the leaves, ChooseSubtree picks the one whose overlap with
+// its siblings grows least. An overflowing node is first relieved by reinserting the entries farthest from its centre, once per
+// level for every inserted tuple, and is only split when that level has already overflowed.
+
+#define REINSERT_FRACTION 0.3 // fraction of the maximum number of entries that forced reinsertion moves out of an overflowing node.
+
+struct ReinsertCandidate // an entry of an overflowing node with the distance of its centre from the centre of the node.
+{
+    double distance;
+    void *entry;
+};
+
+void insertEntryRstar(struct Rtree *rtree, void *entry, int level, unsigned long long *reinserted_levels); // inserts a tuple or a subtree into a node at the given level.
+
+void getEntryBounds(struct Rtree *rtree, void *entry, int level, Bounds bounddefiners) // stores the MBR of an entry of a node at the given level, a tuple at level 0 and a child node above it.
+{
+    for (int i = 0; i < rtree->numofdimensions; i++)
+    {
+        if (level == 0 && rtree->extent_entries)
+            bounddefiners[i] = getExtentBounds(entry)[i];
+        else if (level == 0)
+            bounddefiners[i].dmin = bounddefiners[i].dmax = ((int *)entry)[i];
+        else
+            bounddefiners[i] = ((struct Node *)entry)->bounddefiners[i];
+    }
+}
+
+void addEntryToNode(struct Rtree *rtree, struct Node *node, void *entry) // adds a tuple to a leaf node or a child node to an internal node, enlarging its MBR.
+{
+    if (is_leaf(node))
+        addTupleToLeafNode(rtree->numofdimensions, entry, node);
+    else
+        addChildNode2Parent(node, entry, rtree->numofdimensions);
+}
+
+void tightenPath(struct Node *node, int numofdimensions) // recomputes the MBR of a node whose entries changed, then those of its ancestors up to the first one that does not change.
+{
+    adjustNodeMBR(node, numofdimensions);
+    for (node = node->parent; node != NULL && adjustNodeMBR(node, numofdimensions); node = node->parent)
+        ;
+}
+
+struct Node *chooseSubtreeRstar(struct Rtree *rtree, Bounds bounddefiners, int level) // selects the node at the given level (leaves are level 0) to hold an entry with the given MBR.
+{
+    int numofdimensions = rtree->numofdimensions;
+    struct Node *node = rtree->root;
+    for (int node_level = getTreeHeight(rtree->root) - 1; node_level > level; node_level--)
+    {
+        int bestindex = 0;
+        long int bestoverlapenlargement = LONG_MAX, bestareaenlargement = LONG_MAX, bestarea = LONG_MAX;
+        for (int i = 0; i < node->num_of_children_or_tuples; i++) // least overlap enlargement when the children are leaves, then least area enlargement, then smallest area.
+        {
+            Bounds child_bounds = node->child_nodes[i]->bounddefiners;
+            long int area = getArea(numofdimensions, child_bounds);
+            long int areaenlargement = getAreaOfBoundingBox(numofdimensions, child_bounds, bounddefiners) - area;
+            long int overlapenlargement = 0;
+            if (node_level == 1 && areaenlargement > 0) // a child that already contains the entry gains no overlap.
+            {
+                struct BoundDefiner enlarged[numofdimensions];
+                memcpy(enlarged, child_bounds, sizeof(enlarged));
+                enlargeMBR(numofdimensions, enlarged, bounddefiners);
+                for (int j = 0; j < node->num_of_children_or_tuples; j++)
+                {
+                    if (j == i)
+                        continue;
+                    Bounds sibling_bounds = node->child_nodes[j]->bounddefiners;
+                    overlapenlargement += getOverlapArea(numofdimensions, enlarged, sibling_bounds) - getOverlapArea(numofdimensions, child_bounds, sibling_bounds);
+                }
+            }
+            if (overlapenlargement < bestoverlapenlargement ||
+                (overlapenlargement == bestoverlapenlargement && (areaenlargement < bestareaenlargement || (areaenlargement == bestareaenlargement && area < bestarea))))
+            {
+                bestoverlapenlargement = overlapenlargement;
+                bestareaenlargement = areaenlargement;
+                bestarea = area;
+                bestindex = i;
+            }
+        }
+        node = node->child_nodes[bestindex];
+    }
+    return node;
+}
+
+int compareReinsertCandidates(const void *a, const void *b) // orders reinsertion candidates by increasing distance from the centre of their node.
+{
+    double distance = ((const struct ReinsertCandidate *)a)->distance, distance2 = ((const struct ReinsertCandidate *)b)->distance;
+    return (distance > distance2) - (distance < distance2);
+}
+
+void forcedReinsert(struct Rtree *rtree, struct Node *node, void *entry, int level, unsigned long long *reinserted_levels) // removes the entries of a full node, including the arriving one, that lie farthest from its centre and inserts them again.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_entries = node->num_of_children_or_tuples + 1;
+    struct ReinsertCandidate candidates[num_of_entries]; // kept on the stack, since the reinsertions below may split nodes and reinsert at other levels.
+    struct BoundDefiner bounds[numofdimensions];
+    long long centre[numofdimensions]; // twice the centre of the MBR of the node once it includes the arriving entry.
+
+    getEntryBounds(rtree, entry, level, bounds);
+    for (int i = 0; i < numofdimensions; i++)
+        centre[i] = (long long)min(node->bounddefiners[i].dmin, bounds[i].dmin) + max(node->bounddefiners[i].dmax, bounds[i].dmax);
+    for (int j = 0; j < num_of_entries; j++)
+    {
+        void *candidate = entry;
+        if (j < node->num_of_children_or_tuples)
+            candidate = is_leaf(node) ? (void *)node->list_of_tuples[j] : (void *)node->child_nodes[j];
+        getEntryBounds(rtree, candidate, level, bounds);
+        double distance = 0;
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            double delta = (double)bounds[i].dmin + bounds[i].dmax - centre[i];
+            distance += delta * delta;
+        }
+        candidates[j].distance = distance;
+        candidates[j].entry = candidate;
+    }
+    qsort(candidates, num_of_entries, sizeof(struct ReinsertCandidate), compareReinsertCandidates);
+
+    int num_of_kept = num_of_entries - max(1, (int)(rtree->max_entries * REINSERT_FRACTION));
+    COUNT_STAT(rtree->insert_counters.forced_reinserts, 1);
+    COUNT_STAT(rtree->insert_counters.reinserted_entries, num_of_entries - num_of_kept);
+    emptyNode(node, numofdimensions);
+    for (int j = 0; j < num_of_kept; j++)
+        addEntryToNode(rtree, node, candidates[j].entry);
+    tightenPath(node, numofdimensions);
+    refreshAggregatesOnPath(rtree, node);
+    for (int j = num_of_kept; j < num_of_entries; j++) // close reinsert: the removed entries nearest the centre go first.
+        insertEntryRstar(rtree, candidates[j].entry, level, reinserted_levels);
+}
+
+void overflowTreatment(struct Rtree *rtree, struct Node *node, void *entry, int level, unsigned long long *reinserted_levels) // handles an entry arriving at a full node at the given level.
+{
+    if (node->parent != NULL && level < 64 && !(*reinserted_levels & (1ULL << level))) // the first overflow of a level below the root is treated by forced reinsertion.
+    {
+        *reinserted_levels |= 1ULL << level;
+        forcedReinsert(rtree, node, entry, level, reinserted_levels);
+        return;
+    }
+
+    struct Node *split_node = is_leaf(node) ? nodeSplit_leaf(rtree, node, entry) : nodeSplit(rtree, node, entry);
+    struct Node *parent_node = node->parent;
+    if (rtree->aggregates) // the entries of node were shared out between node and split_node.
+    {
+        updateAggregate(rtree, node);
+        updateAggregate(rtree, split_node);
+    }
+    if (parent_node == NULL)
+    {
+        growTreeIfRootSplit(rtree, split_node);
+    }
+    else if (parent_node->num_of_children_or_tuples < rtree->max_entries)
+    {
+        addChildNode2Parent(parent_node, split_node, rtree->numofdimensions);
+        tightenPath(parent_node, rtree->numofdimensions); // node may have shrunk, so the path is recomputed rather than enlarged.
+        refreshAggregatesOnPath(rtree, parent_node);
+    }
+    else // the split propagates, and the parent gets the same treatment one level up.
+    {
+        overflowTreatment(rtree, parent_node, split_node, level + 1, reinserted_levels);
+    }
+}
+
+void insertEntryRstar(struct Rtree *rtree, void *entry, int level, unsigned long long *reinserted_levels) // inserts a tuple (level 0) or a subtree into a node at the given level, treating overflows the R*-tree way.
+{
+    struct BoundDefiner bounds[rtree->numofdimensions];
+    getEntryBounds(rtree, entry, level, bounds);
+    struct Node *node = chooseSubtreeRstar(rtree, bounds, level);
+    if (node->num_of_children_or_tuples < rtree->max_entries)
+    {
+        addEntryToNode(rtree, node, entry);
+        adjust_tree(rtree, node, NULL); // the node only grew, so its ancestors are enlarged.
+    }
+    else
+    {
+        overflowTreatment(rtree, node, entry, level, reinserted_levels);
+    }
+}
+
+void insertRstar(struct Rtree *rtree, int *tuple) // inserts a stored tuple into a non-empty R-tree with the R*-tree ChooseSubtree and forced reinsertion.
+{
+    unsigned long long reinserted_levels = 0; // bit i is set once an overflow at level i has been treated by reinsertion during this insertion.
+    insertEntryRstar(rtree, tuple, 0, &reinserted_levels);
+}
+
+// Concurrent access
+// A tree created with new_concurrent_rtree lets readers search while writers insert, following the R-link tree of Kornacker and
+// Banks. Every node carries a read-write latch, a right link to the sibling split off it, and the split stamp it was given by
+// its last split. A reader holds one latch at a time, and remembers the split sequence read under the latch of the parent of
+// each node it queues. A node stamped later than that has been split since, so the reader also follows its right link, which
+// leads to every entry that moved out of it. Writers are serialised by a mutex, and stamp a split while holding the latch of
+// the parent, so that a reader either sees the new sibling in the parent or sees the split stamp.
+// In concurrent mode only insertion and search may run at once. Deletes, updates, bulk loads and R*-tree insertion need the
+// tree to themselves.
+
+struct Rtree *new_concurrent_rtree(int max_entries, int min_entries, int numofdimensions) // creates an R-tree on which readers may search while writers insert.
+{
+    struct Rtree *rtree = new_rtree(max_entries, min_entries, numofdimensions);
+    rtree->concurrent = true;
+    rtree->node_arena.block_size += sizeof(pthread_rwlock_t); // the tree is still empty, so every node block can still make room for its latch.
+    pthread_mutex_init(&rtree->writer_lock, NULL);
+    pthread_rwlock_init(&rtree->root_latch, NULL);
+    atomic_init(&rtree->split_sequence, 0);
+    return rtree;
+}
+
+void latchParentExclusive(struct Rtree *rtree, struct Node *node) // takes the latch guarding the entry of a node: that of its parent, or the root latch for the root.
+{
+    pthread_rwlock_wrlock(node->parent != NULL ? node->parent->latch : &rtree->root_latch);
+}
+
+void unlatchParent(struct Rtree *rtree, struct Node *node) // releases the latch taken by latchParentExclusive.
+{
+    pthread_rwlock_unlock(node->parent != NULL ? node->parent->latch : &rtree->root_latch);
+}
+
+void linkSplitSibling(struct Rtree *rtree, struct Node *node, struct Node *split_node) // links the sibling split off a node into the right-link chain and stamps the split. The caller holds the latches of the node and of its parent.
+{
+    split_node->right_link = node->right_link;
+    split_node->split_stamp = node->split_stamp; // readers that queued the node before its earlier splits still follow the chain past the new sibling.
+    node->right_link = split_node;
+    node->split_stamp = atomic_fetch_add(&rtree->split_sequence, 1) + 1;
+}
+
+void concurrentInsertStoredTuple(struct Rtree *rtree, int *tuple) // inserts a stored tuple while readers may be searching. Every node is changed under its exclusive latch, and the tree is never left unsearchable.
+{
+    int numofdimensions = rtree->numofdimensions;
+    pthread_mutex_lock(&rtree->writer_lock); // writers only ever read the tree without latches, which is safe as no other writer runs.
+    if (rtree->root == NULL)
+    {
+        struct Node *root = new_node(rtree, true);
+        addTupleToLeafNode(numofdimensions, tuple, root);
+        pthread_rwlock_wrlock(&rtree->root_latch);
+        rtree->root = root;
+        pthread_rwlock_unlock(&rtree->root_latch);
+        pthread_mutex_unlock(&rtree->writer_lock);
+        return;
+    }
+
+    struct Node *node = chooseLeafForTree(rtree, tuple);
+    struct Node *split_node = NULL;
+    if (node->num_of_children_or_tuples < rtree->max_entries)
+    {
+        pthread_rwlock_wrlock(node->latch);
+        addTupleToLeafNode(numofdimensions, tuple, node);
+        pthread_rwlock_unlock(node->latch);
+    }
+    else
+    {
+        latchParentExclusive(rtree, node); // held until the new sibling is entered in the parent.
+        pthread_rwlock_wrlock(node->latch);
+        split_node = nodeSplit_leaf(rtree, node, tuple);
+        linkSplitSibling(rtree, node, split_node);
+        pthread_rwlock_unlock(node->latch);
+    }
+
+    while (split_node != NULL) // the parent of node is latched: the split is absorbed there, or propagates one level up.
+    {
+        struct Node *parent_node = node->parent;
+        if (parent_node == NULL) // the root was split, so a new root is published under the root latch.
+        {
+            growTreeIfRootSplit(rtree, split_node);
+            pthread_rwlock_unlock(&rtree->root_latch);
+            pthread_mutex_unlock(&rtree->writer_lock);
+            return;
+        }
+        if (parent_node->num_of_children_or_tuples < rtree->max_entries)
+        {
+            addChildNode2Parent(parent_node, split_node, numofdimensions); // also enlarges the parent by the MBR of the new sibling.
+            enlargeMBR(numofdimensions, parent_node->bounddefiners, node->bounddefiners); // the new entry may have stayed in the split node instead.
+            pthread_rwlock_unlock(parent_node->latch);
+            split_node = NULL;
+        }
+        else
+        {
+            latchParentExclusive(rtree, parent_node);
+            split_node = nodeSplit(rtree, parent_node, split_node);
+            linkSplitSibling(rtree, parent_node, split_node);
+            pthread_rwlock_unlock(parent_node->latch);
+        }
+        node = parent_node;
+    }
+
+    // An insertion only ever grows the union of the entries of a node, so the ancestors are enlarged until one already contains the change.
+    for (struct Node *parent_node = node->parent; parent_node != NULL; node = parent_node, parent_node = node->parent)
+    {
+        pthread_rwlock_wrlock(parent_node->latch);
+        bool changed = enlargeMBR(numofdimensions, parent_node->bounddefiners, node->bounddefiners);
+        pthread_rwlock_unlock(parent_node->latch);
+        if (!changed)
+            break;
+    }
+    pthread_mutex_unlock(&rtree->writer_lock);
+}
+
+struct ConcurrentSearchFrame // a node queued by a concurrent search.
+{
+    struct Node *node;      // node to visit.
+    unsigned long sequence; // split sequence read under the latch of the node that led to it.
+};
+
+long int concurrentSearch(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context) // streams every tuple in the given bounds to the visitor while writers may be inserting. Tuples inserted during the search may or may not be found, every other tuple is found exactly once.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int capacity = 64, top = 0;
+    struct ConcurrentSearchFrame *stack = malloc(sizeof(struct ConcurrentSearchFrame) * capacity); // grows with right-link detours, so it is not bounded by the height.
+    int *found[rtree->max_entries]; // tuples of the current leaf, handed to the visitor once its latch is released.
+    long int numofresults = 0;
+
+    pthread_rwlock_rdlock(&rtree->root_latch);
+    if (rtree->root != NULL)
+    {
+        stack[0].node = rtree->root;
+        stack[0].sequence = atomic_load(&rtree->split_sequence);
+        top = 1;
+    }
+    pthread_rwlock_unlock(&rtree->root_latch);
+
+    while (top > 0)
+    {
+        struct ConcurrentSearchFrame frame = stack[--top];
+        struct Node *node = frame.node;
+        int num_of_found = 0;
+        pthread_rwlock_rdlock(node->latch);
+        if (top + 1 + node->num_of_children_or_tuples > capacity) // room for the right link and every child.
+        {
+            capacity = 2 * (top + 1 + rtree->max_entries);
+            stack = realloc(stack, sizeof(struct ConcurrentSearchFrame) * capacity);
+        }
+        if (node->split_stamp > frame.sequence && node->right_link != NULL) // the node was split after it was queued, so some of its entries moved right.
+        {
+            stack[top].node = node->right_link;
+            stack[top++].sequence = frame.sequence;
+        }
+        if (overlaps(numofdimensions, bounddefiners, node->bounddefiners))
+        {
+            if (is_leaf(node))
+            {
+                for (int i = 0; i < node->num_of_children_or_tuples; i++)
+                    if (checkIfTupleInBounds(bounddefiners, node->list_of_tuples[i], numofdimensions))
+                        found[num_of_found++] = node->list_of_tuples[i];
+            }
+            else
+            {
+                unsigned long sequence = atomic_load(&rtree->split_sequence); // read under the latch of the parent, see the section comment.
+                for (int i = 0; i < node->num_of_children_or_tuples; i++) // the MBR of a child is only read under its own latch, once it is visited.
+                {
+                    stack[top].node = node->child_nodes[i];
+                    stack[top++].sequence = sequence;
+                }
+            }
+        }
+        pthread_rwlock_unlock(node->latch);
+
+        for (int i = 0; i < num_of_found; i++)
+        {
+            numofresults++;
+            if (visitor != NULL && !visitor(found[i], context)) // the visitor asked to stop.
+            {
+                free(stack);
+                return numofresults;
+            }
+        }
+    }
+    free(stack);
+    return numofresults;
+}
+
+void freeNodeLatches(struct Node *node) // destroys the latches of a concurrent subtree.
+{
+    for (int i = 0; !is_leaf(node) && i < node->num_of_children_or_tuples; i++)
+        freeNodeLatches(node->child_nodes[i]);
+    pthread_rwlock_destroy(node->latch);
+}
+
+// Deletion
+// Guttman's Delete: FindLeaf locates the leaf holding the tuple, the tuple is removed, and CondenseTree walks back up to the root
+// removing underfull nodes and tightening MBRs. The entries of removed nodes are reinserted at their original level, and the
+// root is shortened while it has a single child.
+
+bool tuplesEqual(int *tuple, int *tuple2, int numofdimensions) // checks whether two tuples have the same coordinates.
+{
+    return memcmp(tuple, tuple2, sizeof(int) * numofdimensions) == 0;
+}
+
+struct Node *findLeaf(struct Rtree *rtree, int *tuple, int *index) // finds the leaf holding a tuple with the given coordinates and stores its position in index. Returns NULL if there is none.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (rtree->root == NULL || !checkIfTupleInBounds(rtree->root->bounddefiners, tuple, numofdimensions))
+        return NULL;
+
+    struct SearchFrame stack[getTreeHeight(rtree->root)]; // depth-first walk over the nodes whose MBR contains the tuple.
+    int top = 0;
+    stack[0].node = rtree->root;
+    stack[0].next_child = 0;
+    while (top >= 0)
+    {
+        struct SearchFrame *frame = &stack[top];
+        struct Node *node = frame->node;
+        if (is_leaf(node))
+        {
+            for (int i = 0; i < node->num_of_children_or_tuples; i++)
+            {
+                if (tuplesEqual(node->list_of_tuples[i], tuple, numofdimensions))
+                {
+                    *index = i;
+                    return node;
+                }
+            }
+            top--;
+        }
+        else if (frame->next_child == node->num_of_children_or_tuples)
+        {
+            top--;
+        }
+        else
+        {
+            struct Node *child = node->child_nodes[frame->next_child++];
+            if (checkIfTupleInBounds(child->bounddefiners, tuple, numofdimensions))
+            {
+                top++;
+                stack[top].node = child;
+                stack[top].next_child = 0;
+            }
+        }
+    }
+    return NULL;
+}
+
+void removeEntryFromNode(struct Node *node, int index, int numofdimensions) // removes the entry at the given index of a node, shifting the following entries left.
+{
+    for (int i = index; i < node->num_of_children_or_tuples - 1; i++)
+    {
+        if (is_leaf(node))
+            node->list_of_tuples[i] = node->list_of_tuples[i + 1];
+        else
+            node->child_nodes[i] = node->child_nodes[i + 1];
+    }
+    for (int i = 0; node->entry_mins != NULL && i < numofdimensions; i++) // SoA layout: the per-dimension arrays are shifted the same way.
+    {
+        int *mins = node->entry_mins + i * node->entry_stride, *maxs = node->entry_maxs + i * node->entry_stride;
+        memmove(mins + index, mins + index + 1, sizeof(int) * (node->num_of_children_or_tuples - 1 - index));
+        if (maxs != mins)
+            memmove(maxs + index, maxs + index + 1, sizeof(int) * (node->num_of_children_or_tuples - 1 - index));
+    }
+    node->num_of_children_or_tuples--;
+}
+
+struct Node *chooseNodeAtLevel(struct Rtree *rtree, Bounds bounddefiners, int level) // selects the node at the given level (leaves are level 0) whose MBR needs the least enlargement to include the given MBR.
+{
+    int numofdimensions = rtree->numofdimensions;
+    struct Node *node = rtree->root;
+    for (int node_level = getTreeHeight(rtree->root) - 1; node_level > level; node_level--)
+    {
+        int minareaindex = 0;
+        long int minareaenlargement = LONG_MAX, minarea = LONG_MAX;
+        for (int i = 0; i < node->num_of_children_or_tuples; i++) // least area enlargement, ties broken by the smallest area.
+        {
+            Bounds child_bounds = node->child_nodes[i]->bounddefiners;
+            long int area = getArea(numofdimensions, child_bounds);
+            long int areaenlargement = getAreaOfBoundingBox(numofdimensions, child_bounds, bounddefiners) - area;
+            if (areaenlargement < minareaenlargement || (areaenlargement == minareaenlargement && area < minarea))
+            {
+                minareaenlargement = areaenlargement;
+                minarea = area;
+                minareaindex = i;
+            }
+        }
+        node = node->child_nodes[minareaindex];
+    }
+    return node;
+}
+
+void insertNodeAtLevel(struct Rtree *rtree, struct Node *node, int level) // reinserts a subtree whose root is at the given level, keeping every leaf at the same depth.
+{
+    struct Node *parent_node = chooseNodeAtLevel(rtree, node->bounddefiners, level + 1);
+    struct Node *split_node = NULL;
+    if (parent_node->num_of_children_or_tuples < rtree->max_entries)
+        addChildNode2Parent(parent_node, node, rtree->numofdimensions);
+    else
+        split_node = nodeSplit(rtree, parent_node, node);
+    growTreeIfRootSplit(rtree, adjust_tree(rtree, parent_node, split_node));
+}
+
+void condenseTree(struct Rtree *rtree, struct Node *leaf_node) // removes underfull nodes on the path from a leaf to the root, tightens the MBRs and reinserts the orphaned entries.
+{
+    int height = getTreeHeight(rtree->root);
+    struct Node *eliminated[height]; // at most one node is eliminated per level, so the array is indexed by level.
+    for (int level = 0; level < height; level++)
+        eliminated[level] = NULL;
+
+    struct Node *node = leaf_node;
+    struct Node *lowest_kept = NULL; // aggregate trees: the lowest node of the path that stays, whose count and those of its ancestors dropped.
+    for (int level = 0; node->parent != NULL; level++)
+    {
+        struct Node *parent_node = node->parent;
+        if (node->num_of_children_or_tuples < rtree->min_entries) // the node is underfull, so it is removed and its entries will be reinserted.
+        {
+            for (int i = 0; i < parent_node->num_of_children_or_tuples; i++)
+            {
+                if (parent_node->child_nodes[i] == node)
+                {
+                    removeEntryFromNode(parent_node, i, rtree->numofdimensions);
+                    break;
+                }
+            }
+            eliminated[level] = node;
+        }
+        else
+        {
+            if (lowest_kept == NULL)
+                lowest_kept = node;
+            if (!adjustNodeMBR(node, rtree->numofdimensions)) // the MBR did not change, so neither do the MBRs or entry counts above it.
+            {
+                node = NULL;
+                break;
+            }
+        }
+        node = parent_node;
+    }
+    if (node != NULL) // the walk reached the root.
+        adjustNodeMBR(node, rtree->numofdimensions);
+    refreshAggregatesOnPath(rtree, (lowest_kept != NULL) ? lowest_kept : rtree->root);
+
+    for (int level = height - 1; level >= 0; level--) // reinserts the orphaned entries, highest level first so that the levels they need exist.
+    {
+        struct Node *orphan = eliminated[level];
+        if (orphan == NULL)
+            continue;
+        for (int i = 0; i < orphan->num_of_children_or_tuples; i++)
+        {
+            if (is_leaf(orphan))
+                insertStoredTuple(rtree, orphan->list_of_tuples[i]);
+            else
+                insertNodeAtLevel(rtree, orphan->child_nodes[i], level - 1);
+        }
+        free_node(rtree, orphan);
+    }
+
+    while (rtree->root != NULL && !is_leaf(rtree->root) && rtree->root->num_of_children_or_tuples == 1) // shortens the tree while the root has a single child.
+    {
+        struct Node *old_root = rtree->root;
+        rtree->root = old_root->child_nodes[0];
+        rtree->root->parent = NULL;
+        free_node(rtree, old_root);
+    }
+    if (rtree->root != NULL && rtree->root->num_of_children_or_tuples == 0) // the last tuple was deleted.
+    {
+        free_node(rtree, rtree->root);
+        rtree->root = NULL;
+    }
+}
+
+int *removeTuple(struct Rtree *rtree, int *tuple) // removes a tuple with the given coordinates from the R-tree and returns its stored copy, or NULL if there is none.
+{
+    int index;
+    struct Node *leaf_node = findLeaf(rtree, tuple, &index);
+    if (leaf_node == NULL)
+        return NULL;
+    int *stored_tuple = leaf_node->list_of_tuples[index];
+    removeEntryFromNode(leaf_node, index, rtree->numofdimensions);
+    condenseTree(rtree, leaf_node);
+    return stored_tuple;
+}
+
+bool delete_tuple(struct Rtree *rtree, int *tuple) // deletes one tuple with the given coordinates from the R-tree. Returns false if there is none.
+{
+    if (rtree->extent_entries) // extent records are not found by coordinates.
+        return false;
+    flush_buffers(rtree); // FindLeaf only looks in the leaves.
+    int *stored_tuple = removeTuple(rtree, tuple);
+    if (stored_tuple == NULL)
+        return false;
+    if (rtree->query_cache != NULL)
+        invalidateQueryCacheAtTuple(rtree, tuple);
+    releaseTuple(&rtree->tuple_pool, stored_tuple);
+    return true;
+}
+
+bool update_tuple(struct Rtree *rtree, int *old_tuple, int *new_tuple) // moves one tuple from old_tuple to new_tuple. Returns false if no tuple has the old coordinates.
+{
+    if (rtree->extent_entries) // extent records are not found by coordinates.
+        return false;
+    flush_buffers(rtree); // FindLeaf only looks in the leaves.
+    int numofdimensions = rtree->numofdimensions;
+    int index;
+    struct Node *leaf_node = findLeaf(rtree, old_tuple, &index);
+    if (leaf_node == NULL)
+        return false;
+    int *stored_tuple = leaf_node->list_of_tuples[index];
+    if (rtree->query_cache != NULL) // the tuple leaves the windows holding its old position and joins those holding the new one.
+    {
+        invalidateQueryCacheAtTuple(rtree, old_tuple);
+        invalidateQueryCacheAtTuple(rtree, new_tuple);
+    }
+
+    if (checkIfTupleInBounds(leaf_node->bounddefiners, new_tuple, numofdimensions)) // the tuple stays inside its leaf, so it is moved in place.
+    {
+        memcpy(stored_tuple, new_tuple, sizeof(int) * numofdimensions);
+        syncEntry(leaf_node, index, numofdimensions);
+        for (struct Node *node = leaf_node; node != NULL && adjustNodeMBR(node, numofdimensions); node = node->parent) // the old position may have defined the MBR, so the path is tightened until an MBR stays the same.
+            ;
+        refreshAggregatesOnPath(rtree, leaf_node); // the aggregated value may be one of the coordinates that moved.
+        return true;
+    }
+
+    removeEntryFromNode(leaf_node, index, rtree->numofdimensions); // otherwise it is deleted and reinserted, reusing its slot in the tuple pool.
+    condenseTree(rtree, leaf_node);
+    memcpy(stored_tuple, new_tuple, sizeof(int) * numofdimensions);
+    insertStoredTuple(rtree, stored_tuple);
+    return true;
+}
+
+int read_next_tuple(FILE *file, int numofdimensions, int *tuple) // reads the next tuple from the file into tuple. Returns 1 on a complete tuple, 0 at end of file and -1 on an incomplete tuple.
+{
+    int count = 0, value;
+    while (count < numofdimensions && fscanf(file, "%d", &value) == 1) // reads one integer per dimension.
+    {
+        tuple[count++] = value;
+    }
+    if (count == numofdimensions)
+        return 1;
+    if (count == 0)
+        return 0;
+    printf("Error: Tuple count is less than the number of dimensions (%d < %d)\n", count, numofdimensions);
+    return -1;
+}
+
+int read_tuples_and_insert(struct Rtree *rtree, const char *filename) //  reads tuples from a file and inserts them into an R-tree data structure
+{
+    FILE *file = fopen(filename, "r"); // opens the specified file in read mode and assigns a file pointer to file.
+    if (file == NULL)
+    { // file failed to open
+        printf("Error opening file: %s\n", strerror(errno));
+        return 1;
+    }
+
+    int *tuple = malloc(sizeof(int) * rtree->numofdimensions); // a single buffer is reused for every tuple, since insert() copies it into the tuple pool.
+    if (tuple == NULL)
+    {
+        printf("Error allocating memory");
+        fclose(file);
+        return 1;
+    }
+
+    int status;
+    while ((status = read_next_tuple(file, rtree->numofdimensions, tuple)) != 0) // reads the tuples from the file line by line.
+    {
+        // If a complete tuple with the correct number of dimensions is read, the insert() function is called to insert the tuple into the R-tree.
+        if (status == 1)
+        {
+            insert(rtree, tuple);
+        }
+    }
+
+    free(tuple);
+    fclose(file);
+    return 0;
+}
+
+// Bulk loading
+// Instead of inserting tuples one at a time, all tuples are sorted once and packed into full leaves, and the upper
+// levels are then built bottom-up by packing the nodes of the level below in the same way.
+// BULK_STR orders entries with Sort-Tile-Recursive, BULK_HILBERT orders them by the Hilbert value of their centers.
+
+enum BulkLoadMethod
+{
+    BULK_NONE,   // tuples are inserted one by one with insert().
+    BULK_STR,    // Sort-Tile-Recursive packing.
+    BULK_HILBERT // Hilbert curve packing.
+};
+
+struct BulkEntry // an entry being packed during a bulk load, either a tuple (leaf level) or a node (upper levels).
+{
+    unsigned long long key; // sort key of the entry for the current ordering pass.
+    int *tuple;             // tuple of the entry if packing the leaf level, else NULL.
+    struct Node *node;      // node of the entry if packing an upper level, else NULL.
+};
+
+long long getBulkEntryCenter(struct BulkEntry *entry, int dimension) // returns twice the center of the entry in the given dimension, so that it stays an integer.
+{
+    if (entry->tuple != NULL)
+        return 2 * (long long)entry->tuple[dimension];
+    return (long long)entry->node->bounddefiners[dimension].dmin + entry->node->bounddefiners[dimension].dmax;
+}
+
+int compareBulkEntries(const void *a, const void *b) // qsort comparator ordering bulk entries by their key.
+{
+    unsigned long long key1 = ((const struct BulkEntry *)a)->key;
+    unsigned long long key2 = ((const struct BulkEntry *)b)->key;
+    return (key1 > key2) - (key1 < key2);
+}
+
+void sortTileRecursive(struct BulkEntry *entries, int num_of_entries, int dimension, int numofdimensions, int max_entries) // orders entries so that consecutive runs of max_entries form the STR tiles.
+{
+    for (int i = 0; i < num_of_entries; i++) // the center is offset by 2^32 so that it can be compared as an unsigned key.
+    {
+        entries[i].key = (unsigned long long)(getBulkEntryCenter(&entries[i], dimension) + (1LL << 32));
+    }
+    qsort(entries, num_of_entries, sizeof(struct BulkEntry), compareBulkEntries);
+    if (dimension == numofdimensions - 1) // the last dimension only orders the entries inside a slab.
+        return;
+
+    // splits the entries into S slabs of whole pages along this dimension, where S is the (d - dimension)th root of the page count.
+    int num_of_pages = (num_of_entries + max_entries - 1) / max_entries;
+    int num_of_slabs = (int)ceil(pow((double)num_of_pages, 1.0 / (numofdimensions - dimension)));
+    int slab_size = ((num_of_pages + num_of_slabs - 1) / num_of_slabs) * max_entries;
+    for (int start = 0; start < num_of_entries; start += slab_size)
+    {
+        sortTileRecursive(entries + start, min(slab_size, num_of_entries - start), dimension + 1, numofdimensions, max_entries);
+    }
+}
+
+unsigned long long getHilbertIndex(unsigned int *coords, int numofdimensions, int bits) // converts coordinates of `bits` bits each into their index along the Hilbert curve (Skilling's algorithm).
+{
+    unsigned int most_significant = 1U << (bits - 1);
+    for (unsigned int q = most_significant; q > 1; q >>= 1) // inverse undo of the excess work.
+    {
+        unsigned int p = q - 1;
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            if (coords[i] & q)
+            {
+                coords[0] ^= p;
+            }
+            else
+            {
+                unsigned int t = (coords[0] ^ coords[i]) & p;
+                coords[0] ^= t;
+                coords[i] ^= t;
+            }
+        }
+    }
+    for (int i = 1; i < numofdimensions; i++) // gray encoding.
+        coords[i] ^= coords[i - 1];
+    unsigned int t = 0;
+    for (unsigned int q = most_significant; q > 1; q >>= 1)
+    {
+        if (coords[numofdimensions - 1] & q)
+            t ^= q - 1;
+    }
+    for (int i = 0; i < numofdimensions; i++)
+        coords[i] ^= t;
+
+    unsigned long long index = 0; // interleaves the transposed bits into a single index.
+    for (int b = bits - 1; b >= 0; b--)
+    {
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            index = (index << 1) | ((coords[i] >> b) & 1U);
+        }
+    }
+    return index;
+}
+
+void sortHilbertOnGrid(struct BulkEntry *entries, int num_of_entries, int numofdimensions, int bits) // orders entries by the Hilbert index of their centers on a grid of 2^bits cells per dimension.
+{
+    long long *low = malloc(sizeof(long long) * numofdimensions);
+    long long *high = malloc(sizeof(long long) * numofdimensions);
+    unsigned int *coords = malloc(sizeof(unsigned int) * numofdimensions);
+    for (int j = 0; j < numofdimensions; j++) // finds the extent of the centers in each dimension to normalise them onto the curve's grid.
+    {
+        low[j] = LLONG_MAX;
+        high[j] = LLONG_MIN;
+        for (int i = 0; i < num_of_entries; i++)
+        {
+            long long center = getBulkEntryCenter(&entries[i], j);
+            if (center < low[j])
+                low[j] = center;
+            if (center > high[j])
+                high[j] = center;
+        }
+    }
+    double grid_max = (double)((1ULL << bits) - 1);
+    for (int i = 0; i < num_of_entries; i++)
+    {
+        for (int j = 0; j < numofdimensions; j++)
+        {
+            long long extent = high[j] - low[j];
+            coords[j] = (extent == 0) ? 0 : (unsigned int)((double)(getBulkEntryCenter(&entries[i], j) - low[j]) / (double)extent * grid_max);
+        }
+        entries[i].key = getHilbertIndex(coords, numofdimensions, bits);
+    }
+    qsort(entries, num_of_entries, sizeof(struct BulkEntry), compareBulkEntries);
+    free(low);
+    free(high);
+    free(coords);
+}
+
+void sortHilbert(struct BulkEntry *entries, int num_of_entries, int numofdimensions) // orders entries by the Hilbert index of their centers.
+{
+    int bits = min(31, 64 / numofdimensions); // bits per dimension so that the whole index fits in 64 bits.
+    if (bits < 1)
+        bits = 1;
+    sortHilbertOnGrid(entries, num_of_entries, numofdimensions, bits);
+}
+
+int getBulkGroupSize(int remaining, int max_entries, int min_entries) // returns the size of the next packed node, keeping the last node at or above min_entries.
+{
+    if (remaining <= max_entries)
+        return remaining;
+    if (remaining - max_entries < min_entries) // a full node would leave an underfull last node, so leave exactly min_entries for it instead.
+        return remaining - min_entries;
+    return max_entries;
+}
+
+int packBulkLevel(struct Rtree *rtree, struct BulkEntry *entries, int num_of_entries, bool leaf_level, enum BulkLoadMethod method) // sorts the entries of one level and packs consecutive runs of them into new nodes, which overwrite the front of entries. Returns the number of nodes.
+{
+    if (method == BULK_STR)
+        sortTileRecursive(entries, num_of_entries, 0, rtree->numofdimensions, rtree->max_entries);
+    else
+        sortHilbert(entries, num_of_entries, rtree->numofdimensions);
+
+    int num_of_nodes = 0;
+    for (int start = 0; start < num_of_entries;) // the nodes overwrite the front of the entries array, which is already consumed.
+    {
+        int group_size = getBulkGroupSize(num_of_entries - start, rtree->max_entries, rtree->min_entries);
+        struct Node *node = new_node(rtree, leaf_level);
+        for (int i = start; i < start + group_size; i++)
+        {
+            if (leaf_level)
+                addTupleToLeafNode(rtree->numofdimensions, entries[i].tuple, node);
+            else
+                addChildNode2Parent(node, entries[i].node, rtree->numofdimensions);
+        }
+        start += group_size;
+        entries[num_of_nodes].tuple = NULL;
+        entries[num_of_nodes].node = node;
+        num_of_nodes++;
+    }
+    return num_of_nodes;
+}
+
+bool bulk_load(struct Rtree *rtree, int *coordinates, int num_of_tuples, enum BulkLoadMethod method) // builds the R-tree from num_of_tuples tuples stored back to back in coordinates by packing them bottom-up. Returns false on an extent tree, which only takes points through insert_extent.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (rtree->extent_entries)
+        return false;
+    if (num_of_tuples == 0)
+        return true;
+    if (rtree->root != NULL || method == BULK_NONE) // packing needs an empty tree, otherwise the tuples are inserted one by one.
+    {
+        for (int i = 0; i < num_of_tuples; i++)
+            insert(rtree, coordinates + (size_t)i * numofdimensions);
+        return true;
+    }
+
+    clearQueryCache(rtree); // every cached window found nothing, and may now hold any of the tuples.
+    int *tuples = reserveTuples(&rtree->tuple_pool, num_of_tuples, numofdimensions); // the tuples are copied into a single contiguous chunk of the tuple pool.
+    memcpy(tuples, coordinates, sizeof(int) * numofdimensions * (size_t)num_of_tuples);
+    struct BulkEntry *entries = malloc(sizeof(struct BulkEntry) * num_of_tuples);
+    for (int i = 0; i < num_of_tuples; i++)
+    {
+        entries[i].tuple = tuples + (size_t)i * numofdimensions;
+        entries[i].node = NULL;
+    }
+    int num_of_entries = num_of_tuples;
+    bool leaf_level = true;
+
+    while (1) // packs one level per iteration until a single node remains.
+    {
+        num_of_entries = packBulkLevel(rtree, entries, num_of_entries, leaf_level, method);
+        leaf_level = false;
+        if (num_of_entries == 1)
+            break;
+    }
+
+    rtree->root = entries[0].node;
+    free(entries);
+    refreshAggregates(rtree, rtree->root);
+    return true;
+}
+
+int *read_tuples(const char *filename, int numofdimensions, int *num_of_tuples) // reads every tuple of a file back to back into one buffer. Returns NULL if the file cannot be read.
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        printf("Error opening file: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    int capacity = 1024;
+    int *coordinates = malloc(sizeof(int) * numofdimensions * (size_t)capacity);
+    if (coordinates == NULL)
+    {
+        printf("Error allocating memory");
+        fclose(file);
+        return NULL;
+    }
+    *num_of_tuples = 0;
+    int status;
+    while ((status = read_next_tuple(file, numofdimensions, coordinates + (size_t)*num_of_tuples * numofdimensions)) != 0)
+    {
+        if (status != 1)
+            continue;
+        if (++*num_of_tuples == capacity) // grows the buffer geometrically, keeping room for the next tuple.
+        {
+            capacity *= 2;
+            coordinates = realloc(coordinates, sizeof(int) * numofdimensions * (size_t)capacity);
+        }
+    }
+    fclose(file);
+    return coordinates;
+}
+
+int read_tuples_and_bulk_load(struct Rtree *rtree, const char *filename, enum BulkLoadMethod method) // reads all tuples from a file and bulk loads them into the R-tree.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, rtree->numofdimensions, &num_of_tuples);
+    if (coordinates == NULL)
+        return 1;
+    bulk_load(rtree, coordinates, num_of_tuples, method);
+    free(coordinates);
+    return 0;
+}
+
+// Batched insertion
+// insert_batch inserts many tuples in one pass down the tree. The batch is sorted along the Hilbert curve, so that nearby tuples
+// are next to each other, and every node hands each of its children the whole run of tuples that chose it, using the leaf
+// choice of chooseLeaf against child MBRs that grow as tuples are assigned. A node that overflows is split once, however many
+// entries it gained: its entries are ordered into sort-tile-recursive tiles and cut into as few evenly filled nodes as hold them. Each
+// touched node recomputes its MBR once, after all of its children are done, instead of once per tuple.
+
+struct NodeList // growable list of nodes created by a batched insertion.
+{
+    struct Node **nodes; // the nodes.
+    int num_of_nodes;    // number of nodes in the list.
+    int capacity;        // number of nodes the list can hold.
+};
+
+void appendToNodeList(struct NodeList *list, struct Node *node) // adds a node to the end of a list.
+{
+    if (list->num_of_nodes == list->capacity)
+    {
+        list->capacity = (list->capacity == 0) ? 8 : 2 * list->capacity;
+        list->nodes = realloc(list->nodes, sizeof(struct Node *) * list->capacity);
+    }
+    list->nodes[list->num_of_nodes++] = node;
+}
+
+void splitNodeAsGroup(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, int num_of_entries, struct NodeList *siblings) // refills a node with the first run of the entries in STR order, and as many new siblings as the rest need, each filled to the same level.
+{
+    int numofdimensions = rtree->numofdimensions;
+    bool leaf_level = is_leaf(node);
+    int num_of_nodes = (num_of_entries + rtree->max_entries - 1) / rtree->max_entries; // evenly filled, every node holds more than max_entries / 2 entries, so at least min_entries.
+    if (leaf_level)
+        COUNT_STAT(rtree->insert_counters.leaf_splits, num_of_nodes - 1);
+    else
+        COUNT_STAT(rtree->insert_counters.internal_splits, num_of_nodes - 1);
+    sortTileRecursive(entries, num_of_entries, 0, numofdimensions, (num_of_entries + num_of_nodes - 1) / num_of_nodes);
+    emptyNode(node, numofdimensions);
+    int start = 0;
+    for (int k = 0; k < num_of_nodes; k++)
+    {
+        int group_size = num_of_entries / num_of_nodes + (k < num_of_entries % num_of_nodes);
+        struct Node *group_node = node;
+        if (k > 0)
+        {
+            group_node = new_node(rtree, leaf_level);
+            appendToNodeList(siblings, group_node);
+        }
+        for (int i = start; i < start + group_size; i++)
+        {
+            if (leaf_level)
+                addTupleToLeafNode(numofdimensions, entries[i].tuple, group_node);
+            else
+                addChildNode2Parent(group_node, entries[i].node, numofdimensions);
+        }
+        start += group_size;
+    }
+}
+
+ALWAYS_INLINE void assignBatchToChildrenInDimensions(int numofdimensions, struct BulkEntry *entries, int num_of_entries, struct BoundDefiner *bounds_of_children, int num_of_children, int *counts) // sets the key of every entry to the index of the child chosen for it and counts the entries of each child in counts[index + 1], inlined into one copy per dimension kernel.
+{
+    for (int i = 0; i < num_of_entries; i++)
+    {
+        int *tuple = entries[i].tuple;
+        long int minarea = LONG_MAX, minareaenlargedoninclusion = LONG_MAX;
+        int minareaindex = 0;
+        for (int j = 0; j < num_of_children; j++)
+        {
+            Bounds bounds = bounds_of_children + j * numofdimensions;
+            long int areaenlargedoninclusion = getAreaEnlargedOnInclusion(numofdimensions, bounds, tuple);
+            if (areaenlargedoninclusion < minareaenlargedoninclusion)
+            {
+                minareaenlargedoninclusion = areaenlargedoninclusion;
+                minareaindex = j;
+            }
+            else if (areaenlargedoninclusion == minareaenlargedoninclusion)
+            {
+                long int area = getArea(numofdimensions, bounds);
+                if (area < minarea)
+                {
+                    minarea = area;
+                    minareaindex = j;
+                }
+            }
+        }
+        Bounds chosen = bounds_of_children + minareaindex * numofdimensions;
+        for (int k = 0; k < numofdimensions; k++)
+        {
+            chosen[k].dmin = min(chosen[k].dmin, tuple[k]);
+            chosen[k].dmax = max(chosen[k].dmax, tuple[k]);
+        }
+        entries[i].key = minareaindex; // the Hilbert keys are no longer needed once the batch is sorted.
+        counts[minareaindex + 1]++;
+    }
+}
+
+void assignBatchToChildren(int numofdimensions, struct BulkEntry *entries, int num_of_entries, struct BoundDefiner *bounds_of_children, int num_of_children, int *counts) // assigns a batch to the children of a node for any number of dimensions.
+{
+    assignBatchToChildrenInDimensions(numofdimensions, entries, num_of_entries, bounds_of_children, num_of_children, counts);
+}
+
+void assignBatchToChildren2D(struct BulkEntry *entries, int num_of_entries, struct BoundDefiner *bounds_of_children, int num_of_children, int *counts) // assignBatchToChildren specialised for 2 dimensions.
+{
+    assignBatchToChildrenInDimensions(2, entries, num_of_entries, bounds_of_children, num_of_children, counts);
+}
+
+void assignBatchToChildren3D(struct BulkEntry *entries, int num_of_entries, struct BoundDefiner *bounds_of_children, int num_of_children, int *counts) // assignBatchToChildren specialised for 3 dimensions.
+{
+    assignBatchToChildrenInDimensions(3, entries, num_of_entries, bounds_of_children, num_of_children, counts);
+}
+
+void groupBatchByChild(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, struct BulkEntry *scratch, int num_of_entries, int *group_start) // assigns every tuple of a run to a child of an internal node with the rule of chooseLeaf, and reorders the run so that the tuples of child j are entries[group_start[j]] to entries[group_start[j + 1] - 1], keeping their order within each group.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int count = node->num_of_children_or_tuples;
+
+    // The tuples are assigned against copies of the child MBRs enlarged as tuples are assigned, so that a tuple sees the children
+    // as the tuples before it would have left them.
+    struct BoundDefiner child_bounds[count * numofdimensions];
+    for (int j = 0; j < count; j++)
+        memcpy(child_bounds + j * numofdimensions, node->child_nodes[j]->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+    memset(group_start, 0, sizeof(int) * (count + 1));
+    switch (rtree->dimension_kernel)
+    {
+    case KERNEL_2D:
+        assignBatchToChildren2D(entries, num_of_entries, child_bounds, count, group_start);
+        break;
+    case KERNEL_3D:
+        assignBatchToChildren3D(entries, num_of_entries, child_bounds, count, group_start);
+        break;
+    default:
+        assignBatchToChildren(numofdimensions, entries, num_of_entries, child_bounds, count, group_start);
+        break;
+    }
+
+    for (int j = 0; j < count; j++)
+        group_start[j + 1] += group_start[j];
+    int next[count];
+    memcpy(next, group_start, sizeof(next));
+    for (int i = 0; i < num_of_entries; i++)
+        scratch[next[entries[i].key]++] = entries[i];
+    memcpy(entries, scratch, sizeof(struct BulkEntry) * num_of_entries); // the children reuse the scratch of their own runs.
+}
+
+void absorbNewChildren(struct Rtree *rtree, struct Node *node, struct NodeList *new_children, struct NodeList *siblings) // adds the nodes split off the children of an internal node to it, splitting it as a group if they do not fit, and recomputes its MBR. New siblings of the node are appended to siblings.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int count = node->num_of_children_or_tuples;
+    if (count + new_children->num_of_nodes <= rtree->max_entries)
+    {
+        for (int i = 0; i < new_children->num_of_nodes; i++)
+            addChildNode2Parent(node, new_children->nodes[i], numofdimensions);
+        adjustNodeMBR(node, numofdimensions); // once for the whole batch, as the children may have shrunk when split.
+    }
+    else
+    {
+        struct BulkEntry *all = malloc(sizeof(struct BulkEntry) * (count + new_children->num_of_nodes)); // the children of the node followed by the new ones.
+        for (int i = 0; i < count; i++)
+            all[i] = (struct BulkEntry){0, NULL, node->child_nodes[i]};
+        for (int i = 0; i < new_children->num_of_nodes; i++)
+            all[count + i] = (struct BulkEntry){0, NULL, new_children->nodes[i]};
+        splitNodeAsGroup(rtree, node, all, count + new_children->num_of_nodes, siblings);
+        free(all);
+    }
+    free(new_children->nodes);
+}
+
+void updateSplitAggregates(struct Rtree *rtree, struct Node *node, struct NodeList *siblings, int first_sibling) // aggregate trees: recomputes the aggregates of a node whose entries changed and of the siblings split off it, from siblings[first_sibling] on.
+{
+    if (!rtree->aggregates)
+        return;
+    updateAggregate(rtree, node);
+    for (int i = first_sibling; i < siblings->num_of_nodes; i++)
+        updateAggregate(rtree, siblings->nodes[i]);
+}
+
+void insertBatchIntoNode(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, struct BulkEntry *scratch, int num_of_entries, struct NodeList *siblings) // inserts a run of tuples into the subtree of a node, using as much of scratch as there are tuples. New siblings of the node, if it was split, are appended to siblings.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int count = node->num_of_children_or_tuples;
+    int first_sibling = siblings->num_of_nodes;
+    if (is_leaf(node))
+    {
+        if (count + num_of_entries <= rtree->max_entries)
+        {
+            for (int i = 0; i < num_of_entries; i++)
+                addTupleToLeafNode(numofdimensions, entries[i].tuple, node);
+        }
+        else
+        {
+            struct BulkEntry *all = malloc(sizeof(struct BulkEntry) * (count + num_of_entries)); // the tuples of the leaf followed by the new ones.
+            for (int i = 0; i < count; i++)
+                all[i] = (struct BulkEntry){0, node->list_of_tuples[i], NULL};
+            memcpy(all + count, entries, sizeof(struct BulkEntry) * num_of_entries);
+            splitNodeAsGroup(rtree, node, all, count + num_of_entries, siblings);
+            free(all);
+        }
+        updateSplitAggregates(rtree, node, siblings, first_sibling);
+        return;
+    }
+
+    int group_start[count + 1];
+    groupBatchByChild(rtree, node, entries, scratch, num_of_entries, group_start);
+    struct NodeList new_children = {NULL, 0, 0};
+    for (int j = 0; j < count; j++)
+        if (group_start[j + 1] > group_start[j])
+            insertBatchIntoNode(rtree, node->child_nodes[j], entries + group_start[j], scratch + group_start[j], group_start[j + 1] - group_start[j], &new_children);
+    absorbNewChildren(rtree, node, &new_children, siblings);
+    updateSplitAggregates(rtree, node, siblings, first_sibling); // only the nodes on the paths the batch took, bottom-up, as the children were updated first.
+}
+
+void growTreeFromRootSiblings(struct Rtree *rtree, struct NodeList *siblings) // the root was split into one or more siblings, so a new root takes them all, splitting again until they fit. Releases the list.
+{
+    int numofdimensions = rtree->numofdimensions;
+    while (siblings->num_of_nodes > 0)
+    {
+        COUNT_STAT(rtree->insert_counters.root_splits, 1);
+        struct Node *new_root = new_node(rtree, false);
+        int num_of_children = siblings->num_of_nodes + 1;
+        struct BulkEntry *all = malloc(sizeof(struct BulkEntry) * num_of_children);
+        all[0] = (struct BulkEntry){0, NULL, rtree->root};
+        for (int i = 0; i < siblings->num_of_nodes; i++)
+            all[i + 1] = (struct BulkEntry){0, NULL, siblings->nodes[i]};
+        siblings->num_of_nodes = 0;
+        if (num_of_children <= rtree->max_entries)
+        {
+            for (int i = 0; i < num_of_children; i++)
+                addChildNode2Parent(new_root, all[i].node, numofdimensions);
+        }
+        else
+        {
+            splitNodeAsGroup(rtree, new_root, all, num_of_children, siblings);
+        }
+        free(all);
+        rtree->root = new_root;
+        updateSplitAggregates(rtree, new_root, siblings, 0);
+    }
+    free(siblings->nodes);
+}
+
+void insertStoredBatch(struct Rtree *rtree, struct BulkEntry *entries, int num_of_entries) // inserts a run of tuples already held by the tuple pool in one pass down the tree, after sorting them along the Hilbert curve.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int bits = 1; // the batch only has to be grouped by locality, so a grid of about as many cells as tuples will do, and each bit costs a round of the Hilbert transform.
+    while (bits < min(31, 64 / numofdimensions) && (1LL << (bits * numofdimensions)) < num_of_entries)
+        bits++;
+    sortHilbertOnGrid(entries, num_of_entries, numofdimensions, bits);
+
+    if (rtree->root == NULL)
+        rtree->root = new_node(rtree, true);
+    struct BulkEntry *scratch = malloc(sizeof(struct BulkEntry) * num_of_entries);
+    struct NodeList siblings = {NULL, 0, 0};
+    insertBatchIntoNode(rtree, rtree->root, entries, scratch, num_of_entries, &siblings);
+    free(scratch);
+    growTreeFromRootSiblings(rtree, &siblings);
+}
+
+bool insert_batch(struct Rtree *rtree, int *coordinates, int num_of_tuples) // inserts num_of_tuples tuples stored back to back in coordinates in one pass down the tree. The tuples are copied into the tuple pool of the tree. Returns false on an extent tree, which takes insert_extent.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (rtree->extent_entries)
+        return false;
+    if (num_of_tuples <= 0)
+        return true;
+    if (rtree->concurrent || rtree->insert_policy == INSERT_RSTAR) // forced reinsertion and latching work one tuple at a time.
+    {
+        for (int i = 0; i < num_of_tuples; i++)
+            insert(rtree, coordinates + (size_t)i * numofdimensions);
+        return true;
+    }
+
+    for (int i = 0; rtree->query_cache != NULL && i < num_of_tuples; i++)
+        invalidateQueryCacheAtTuple(rtree, coordinates + (size_t)i * numofdimensions);
+    flush_buffers(rtree); // the batch is routed by the MBRs of the children, which the buffers would otherwise leave loose.
+    int *tuples = reserveTuples(&rtree->tuple_pool, num_of_tuples, numofdimensions);
+    memcpy(tuples, coordinates, sizeof(int) * numofdimensions * (size_t)num_of_tuples);
+    struct BulkEntry *entries = malloc(sizeof(struct BulkEntry) * num_of_tuples);
+    for (int i = 0; i < num_of_tuples; i++)
+        entries[i] = (struct BulkEntry){0, tuples + (size_t)i * numofdimensions, NULL};
+    insertStoredBatch(rtree, entries, num_of_tuples);
+    free(entries);
+    return true;
+}
+
+// Buffered insertion
+// With a buffer capacity set by set_write_buffer, insert() leaves each tuple in a buffer at the root instead of walking to a leaf.
+// An internal node whose buffer fills up hands the whole buffer to its children in one batch: each child gets the run of tuples
+// that chose it, which joins the buffer of the child, or for the parents of leaves is inserted into the leaves with the batched
+// insertion above. A child whose buffer overflows is flushed the same way, so splits and MBR updates happen once per flush rather
+// than once per tuple. The MBR of every node covers the tuples waiting in its buffer, so searches reach them by scanning the
+// buffers of the internal nodes on their path. Operations that look a tuple up in its leaf, or that depend on the exact MBRs of
+// the children, call flush_buffers first.
+
+void appendPendingTuples(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, int num_of_entries) // adds tuples to the buffer of an internal node that has room for them, enlarging its MBR. The MBRs of its ancestors already cover the tuples.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (node->pending_tuples == NULL)
+        node->pending_tuples = malloc(sizeof(int *) * rtree->buffer_capacity);
+    bool changed = false;
+    for (int i = 0; i < num_of_entries; i++)
+    {
+        int *tuple = entries[i].tuple;
+        node->pending_tuples[node->num_of_pending_tuples++] = tuple;
+        for (int k = 0; k < numofdimensions; k++)
+        {
+            if (tuple[k] < node->bounddefiners[k].dmin)
+            {
+                node->bounddefiners[k].dmin = tuple[k];
+                changed = true;
+            }
+            if (tuple[k] > node->bounddefiners[k].dmax)
+            {
+                node->bounddefiners[k].dmax = tuple[k];
+                changed = true;
+            }
+        }
+    }
+    rtree->num_of_pending_tuples += num_of_entries;
+    if (changed)
+        syncBoundsToParent(node, numofdimensions);
+}
+
+void pushIntoBufferedNode(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, int num_of_entries, struct NodeList *siblings) // hands a run of tuples to a node: they join its buffer if it has room, otherwise the buffer and the run are flushed to its children. New siblings of the node, if it was split, are appended to siblings.
+{
+    if (!is_leaf(node) && node->num_of_pending_tuples + num_of_entries <= rtree->buffer_capacity)
+    {
+        appendPendingTuples(rtree, node, entries, num_of_entries);
+        return;
+    }
+
+    int num_of_flushed = node->num_of_pending_tuples + num_of_entries;
+    if (!is_leaf(node))
+        COUNT_STAT(rtree->insert_counters.buffer_flushes, 1);
+    struct BulkEntry *flushed = malloc(sizeof(struct BulkEntry) * num_of_flushed); // the buffer of the node followed by the run.
+    struct BulkEntry *scratch = malloc(sizeof(struct BulkEntry) * num_of_flushed);
+    for (int i = 0; i < node->num_of_pending_tuples; i++)
+        flushed[i] = (struct BulkEntry){0, node->pending_tuples[i], NULL};
+    memcpy(flushed + node->num_of_pending_tuples, entries, sizeof(struct BulkEntry) * num_of_entries);
+    rtree->num_of_pending_tuples -= node->num_of_pending_tuples;
+    node->num_of_pending_tuples = 0;
+
+    if (is_leaf(node) || is_leaf(node->child_nodes[0])) // leaves have no buffers, so the tuples go straight into them.
+    {
+        insertBatchIntoNode(rtree, node, flushed, scratch, num_of_flushed, siblings);
+    }
+    else
+    {
+        int count = node->num_of_children_or_tuples;
+        int group_start[count + 1];
+        groupBatchByChild(rtree, node, flushed, scratch, num_of_flushed, group_start);
+        struct NodeList new_children = {NULL, 0, 0};
+        for (int j = 0; j < count; j++)
+            if (group_start[j + 1] > group_start[j])
+                pushIntoBufferedNode(rtree, node->child_nodes[j], flushed + group_start[j], group_start[j + 1] - group_start[j], &new_children);
+        absorbNewChildren(rtree, node, &new_children, siblings);
+    }
+    free(scratch);
+    free(flushed);
+}
+
+void bufferedInsert(struct Rtree *rtree, int *tuple) // inserts a stored tuple into the buffer of the root, flushing buffers that fill up.
+{
+    if (rtree->root == NULL)
+        rtree->root = new_node(rtree, true);
+    struct BulkEntry entry = {0, tuple, NULL};
+    struct NodeList siblings = {NULL, 0, 0};
+    pushIntoBufferedNode(rtree, rtree->root, &entry, 1, &siblings);
+    growTreeFromRootSiblings(rtree, &siblings);
+}
+
+void collectPendingTuples(struct Rtree *rtree, struct Node *node, struct BulkEntry *entries, long int *num_of_entries) // moves the tuples waiting in the subtree of a node into entries and releases the buffers, tightening every MBR bottom-up.
+{
+    if (is_leaf(node))
+        return;
+    for (int j = 0; j < node->num_of_children_or_tuples; j++)
+        collectPendingTuples(rtree, node->child_nodes[j], entries, num_of_entries);
+    for (int i = 0; i < node->num_of_pending_tuples; i++)
+        entries[(*num_of_entries)++] = (struct BulkEntry){0, node->pending_tuples[i], NULL};
+    free(node->pending_tuples);
+    node->pending_tuples = NULL;
+    node->num_of_pending_tuples = 0;
+    adjustNodeMBR(node, rtree->numofdimensions); // the MBR no longer has to cover the buffer.
+}
+
+void flush_buffers(struct Rtree *rtree) // pushes every tuple waiting in a node buffer down to the leaves, as one batched insertion.
+{
+    if (rtree->num_of_pending_tuples == 0)
+        return;
+    struct BulkEntry *entries = malloc(sizeof(struct BulkEntry) * rtree->num_of_pending_tuples);
+    long int num_of_entries = 0;
+    collectPendingTuples(rtree, rtree->root, entries, &num_of_entries);
+    rtree->num_of_pending_tuples = 0;
+    insertStoredBatch(rtree, entries, (int)num_of_entries);
+    free(entries);
+}
+
+void freePendingBuffers(struct Node *node) // releases the buffers of a node and its subtree. Tuples still waiting in them stay in the tuple pool but leave the tree.
+{
+    if (is_leaf(node))
+        return;
+    free(node->pending_tuples);
+    node->pending_tuples = NULL;
+    for (int j = 0; j < node->num_of_children_or_tuples; j++)
+        freePendingBuffers(node->child_nodes[j]);
+}
+
+void set_write_buffer(struct Rtree *rtree, int buffer_capacity) // sets how many tuples an internal node buffers before flushing them to its children. 0 turns buffering off. Pending tuples are flushed first. Concurrent trees and --insert rstar always insert straight into the leaves.
+{
+    flush_buffers(rtree);
+    if (rtree->root != NULL && buffer_capacity != rtree->buffer_capacity) // the buffers were allocated for the old capacity.
+        freePendingBuffers(rtree->root);
+    rtree->buffer_capacity = (buffer_capacity > 0) ? buffer_capacity : 0;
+}
+
+// Parallel ingest
+// parallelIngest bulk loads a file through a pipeline whose stages each run on a worker pool. The file is read in byte ranges,
+// cut into chunks at whitespace and parsed with a hand-written integer parser, and the values are gathered into the tuple pool.
+// The tuples are then partitioned into one slab per thread along the first dimension, with splitters taken from a sample, and
+// each thread packs its slab bottom-up into its own subtree. Every subtree is packed the same number of levels, so the tops
+// all sit at the same height, and they are then packed together under a common root in the same way.
+
+struct IngestTimings // seconds spent in each stage of parallelIngest.
+{
+    double read;      // reading the file into memory.
+    double parse;     // parsing the chunks and gathering the values into the tuple pool.
+    double partition; // sampling splitters and scattering the tuples into slabs.
+    double build;     // packing the subtrees.
+    double stitch;    // packing the tops of the subtrees under a common root.
+};
+
+struct IngestPipeline // shared state of the stages of parallelIngest.
+{
+    struct Rtree *rtree;               // tree being loaded.
+    enum BulkLoadMethod method;        // packing used inside and above the subtrees.
+    const char *filename;              // file being loaded.
+    int num_of_threads;                // workers of the pool, also the number of chunks and of slabs.
+    char *text;                        // contents of the file.
+    long long text_size;               // size of the file in bytes.
+    bool read_failed;                  // whether a worker could not read its byte range.
+    long long *chunk_begin;            // num_of_threads + 1 offsets into text, cut at whitespace so that no value straddles two chunks.
+    int **chunk_values;                // values parsed from each chunk.
+    long long *chunk_num_of_values;    // number of values parsed from each chunk.
+    bool *chunk_malformed;             // whether parsing of a chunk stopped at a malformed value.
+    long long *value_offsets;          // index in the whole file of the first value of each chunk.
+    long long num_of_values;           // number of values kept, a whole number of tuples.
+    int *tuples;                       // tuples in the tuple pool of the tree.
+    int num_of_tuples;                 // number of tuples.
+    struct BulkEntry *entries;         // one entry per tuple in file order, then the slabs back to back.
+    struct BulkEntry *slab_entries;    // entries scattered into their slabs.
+    int *splitters;                    // num_of_threads - 1 ascending first coordinates separating the slabs.
+    int *slab_counts;                  // entries of each worker's range falling into each slab, num_of_threads by num_of_threads.
+    int *slab_begin;                   // num_of_threads + 1 offsets of the slabs in slab_entries.
+    int num_of_levels;                 // levels packed inside every subtree.
+    struct Rtree **subtrees;           // tree of each worker, owning the nodes of its subtree until they are stitched.
+    int *num_of_tops;                  // number of nodes at the top of each subtree, at the front of its slab.
+};
+
+bool isIngestSpace(char c) // matches the characters isspace accepts in the C locale.
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+void readIngestChunk(void *argument, int worker_index) // read stage: reads one byte range of the file into the text buffer.
+{
+    struct IngestPipeline *pipeline = argument;
+    long long begin = pipeline->text_size * worker_index / pipeline->num_of_threads;
+    long long end = pipeline->text_size * (worker_index + 1) / pipeline->num_of_threads;
+    FILE *file = fopen(pipeline->filename, "rb"); // every worker reads through its own stream.
+    if (file == NULL || fseek(file, (long)begin, SEEK_SET) != 0 || fread(pipeline->text + begin, 1, end - begin, file) != (size_t)(end - begin))
+        pipeline->read_failed = true;
+    if (file != NULL)
+        fclose(file);
+}
+
+void parseIngestChunk(void *argument, int worker_index) // parse stage: parses the values of one chunk. Like fscanf("%d"), a value is an optional sign followed by digits, and parsing stops at anything else.
+{
+    struct IngestPipeline *pipeline = argument;
+    const char *p = pipeline->text + pipeline->chunk_begin[worker_index];
+    const char *end = pipeline->text + pipeline->chunk_begin[worker_index + 1];
+    int *values = malloc(sizeof(int) * ((end - p) / 2 + 1)); // every value takes at least one digit and one separator.
+    long long num_of_values = 0;
+    bool malformed = false;
+    while (p < end)
+    {
+        while (p < end && isIngestSpace(*p))
+            p++;
+        if (p == end)
+            break;
+        bool negative = (*p == '-');
+        if (*p == '-' || *p == '+')
+            p++;
+        if (p == end || *p < '0' || *p > '9')
+        {
+            malformed = true;
+            break;
+        }
+        long long value = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+            if (value <= INT_MAX) // saturates instead of overflowing, the value no longer fits in an int anyway.
+                value = value * 10 + (*p - '0');
+        values[num_of_values++] = (int)(negative ? -value : value);
+    }
+    pipeline->chunk_values[worker_index] = values;
+    pipeline->chunk_num_of_values[worker_index] = num_of_values;
+    pipeline->chunk_malformed[worker_index] = malformed;
+}
+
+void gatherIngestValues(void *argument, int worker_index) // parse stage: copies the values of one chunk to their place in the tuple pool.
+{
+    struct IngestPipeline *pipeline = argument;
+    long long offset = pipeline->value_offsets[worker_index];
+    long long count = pipeline->chunk_num_of_values[worker_index];
+    if (offset + count > pipeline->num_of_values) // only a whole number of tuples is kept.
+        count = (offset < pipeline->num_of_values) ? pipeline->num_of_values - offset : 0;
+    if (count > 0)
+        memcpy(pipeline->tuples + offset, pipeline->chunk_values[worker_index], sizeof(int) * count);
+    free(pipeline->chunk_values[worker_index]);
+}
+
+int compareInts(const void *a, const void *b) // qsort comparator ordering ints ascending.
+{
+    int first = *(const int *)a, second = *(const int *)b;
+    return (first > second) - (first < second);
+}
+
+int getIngestSlab(struct IngestPipeline *pipeline, int coordinate) // returns the slab holding a first coordinate, by binary search over the splitters.
+{
+    int low = 0, high = pipeline->num_of_threads - 1;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (coordinate < pipeline->splitters[middle])
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+void countIngestSlabs(void *argument, int worker_index) // partition stage: creates the entries of one range of tuples and counts them per slab.
+{
+    struct IngestPipeline *pipeline = argument;
+    int numofdimensions = pipeline->rtree->numofdimensions;
+    int *counts = pipeline->slab_counts + worker_index * pipeline->num_of_threads;
+    int begin = (int)((long long)pipeline->num_of_tuples * worker_index / pipeline->num_of_threads);
+    int end = (int)((long long)pipeline->num_of_tuples * (worker_index + 1) / pipeline->num_of_threads);
+    memset(counts, 0, sizeof(int) * pipeline->num_of_threads);
+    for (int i = begin; i < end; i++)
+    {
+        pipeline->entries[i].tuple = pipeline->tuples + (size_t)i * numofdimensions;
+        pipeline->entries[i].node = NULL;
+        counts[getIngestSlab(pipeline, pipeline->entries[i].tuple[0])]++;
+    }
+}
+
+void scatterIngestSlabs(void *argument, int worker_index) // partition stage: moves the entries of one range of tuples into their slabs.
+{
+    struct IngestPipeline *pipeline = argument;
+    int num_of_threads = pipeline->num_of_threads;
+    int next[num_of_threads]; // next free position of each slab reserved for this worker.
+    for (int slab = 0; slab < num_of_threads; slab++)
+    {
+        next[slab] = pipeline->slab_begin[slab];
+        for (int w = 0; w < worker_index; w++)
+            next[slab] += pipeline->slab_counts[w * num_of_threads + slab];
+    }
+    int begin = (int)((long long)pipeline->num_of_tuples * worker_index / num_of_threads);
+    int end = (int)((long long)pipeline->num_of_tuples * (worker_index + 1) / num_of_threads);
+    for (int i = begin; i < end; i++)
+        pipeline->slab_entries[next[getIngestSlab(pipeline, pipeline->entries[i].tuple[0])]++] = pipeline->entries[i];
+}
+
+void buildIngestSubtree(void *argument, int worker_index) // build stage: packs the slab of one worker num_of_levels levels up, allocating its nodes from a tree of its own.
+{
+    struct IngestPipeline *pipeline = argument;
+    struct Rtree *rtree = pipeline->rtree;
+    int num_of_entries = pipeline->slab_begin[worker_index + 1] - pipeline->slab_begin[worker_index];
+    pipeline->subtrees[worker_index] = NULL;
+    if (num_of_entries == 0 || pipeline->num_of_levels == 0)
+    {
+        pipeline->num_of_tops[worker_index] = num_of_entries;
+        return;
+    }
+    struct Rtree *subtree = new_rtree_with_layout(rtree->max_entries, rtree->min_entries, rtree->numofdimensions, rtree->node_layout);
+    for (int level = 0; level < pipeline->num_of_levels; level++)
+        num_of_entries = packBulkLevel(subtree, pipeline->slab_entries + pipeline->slab_begin[worker_index], num_of_entries, level == 0, pipeline->method);
+    pipeline->subtrees[worker_index] = subtree;
+    pipeline->num_of_tops[worker_index] = num_of_entries;
+}
+
+void adoptNodeArena(struct NodeArena *arena, struct NodeArena *other) // moves the slabs of another arena with the same block size into this one, leaving the other empty. Blocks the other never handed out go to the free list.
+{
+    if (other->num_of_slabs == 0)
+        return;
+    for (int i = other->used_in_last_slab; i < NODES_PER_SLAB; i++) // the last slab of the other arena stops being the one allocated from.
+    {
+        struct Node *node = (struct Node *)(other->slabs[other->num_of_slabs - 1] + other->block_size * i);
+        node->parent = arena->free_list;
+        arena->free_list = node;
+    }
+    while (other->free_list != NULL)
+    {
+        struct Node *node = other->free_list;
+        other->free_list = node->parent;
+        node->parent = arena->free_list;
+        arena->free_list = node;
+    }
+    arena->slabs = realloc(arena->slabs, sizeof(char *) * (arena->num_of_slabs + other->num_of_slabs));
+    if (arena->num_of_slabs > 0) // the adopted slabs go in front of the last slab, which stays the one allocated from.
+    {
+        arena->slabs[arena->num_of_slabs + other->num_of_slabs - 1] = arena->slabs[arena->num_of_slabs - 1];
+        memcpy(arena->slabs + arena->num_of_slabs - 1, other->slabs, sizeof(char *) * other->num_of_slabs);
+    }
+    else
+    {
+        memcpy(arena->slabs, other->slabs, sizeof(char *) * other->num_of_slabs);
+        arena->used_in_last_slab = NODES_PER_SLAB; // every block of the last slab is either in use or on the free list.
+    }
+    arena->num_of_slabs += other->num_of_slabs;
+    other->num_of_slabs = 0;
+}
+
+int parallelIngest(struct Rtree *rtree, const char *filename, enum BulkLoadMethod method, int num_of_threads, struct IngestTimings *timings) // bulk loads a file into an empty R-tree with the parallel pipeline, filling in the time spent in each stage. Returns 1 if the file cannot be read.
+{
+    *timings = (struct IngestTimings){0, 0, 0, 0, 0};
+    if (rtree->root != NULL || rtree->concurrent || rtree->extent_entries || method == BULK_NONE || num_of_threads < 1) // the pipeline packs an empty point tree, anything else goes through the sequential path, which refuses extent trees.
+        return (method == BULK_NONE) ? read_tuples_and_insert(rtree, filename) : read_tuples_and_bulk_load(rtree, filename, method);
+
+    int numofdimensions = rtree->numofdimensions;
+    struct IngestPipeline pipeline = {.rtree = rtree, .method = method, .filename = filename, .num_of_threads = num_of_threads}; // the stages fill in the rest.
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL || fseek(file, 0, SEEK_END) != 0)
+    {
+        printf("Error opening file: %s\n", strerror(errno));
+        if (file != NULL)
+            fclose(file);
+        return 1;
+    }
+    pipeline.text_size = ftell(file);
+    fclose(file);
+    struct WorkerPool *pool = newWorkerPool(num_of_threads);
+
+    double start = getTimeInSeconds();
+    pipeline.text = malloc(pipeline.text_size + 1);
+    runOnWorkerPool(pool, readIngestChunk, &pipeline);
+    timings->read = getTimeInSeconds() - start;
+    if (pipeline.read_failed)
+    {
+        printf("Error reading file: %s\n", filename);
+        free(pipeline.text);
+        freeWorkerPool(pool);
+        return 1;
+    }
+
+    start = getTimeInSeconds();
+    pipeline.chunk_begin = malloc(sizeof(long long) * (num_of_threads + 1));
+    pipeline.chunk_values = malloc(sizeof(int *) * num_of_threads);
+    pipeline.chunk_num_of_values = malloc(sizeof(long long) * num_of_threads);
+    pipeline.chunk_malformed = malloc(sizeof(bool) * num_of_threads);
+    pipeline.value_offsets = malloc(sizeof(long long) * num_of_threads);
+    pipeline.chunk_begin[0] = 0;
+    pipeline.chunk_begin[num_of_threads] = pipeline.text_size;
+    for (int i = 1; i < num_of_threads; i++) // each cut moves forward to whitespace, so that it never splits a value.
+    {
+        long long cut = pipeline.text_size * i / num_of_threads;
+        if (cut < pipeline.chunk_begin[i - 1])
+            cut = pipeline.chunk_begin[i - 1];
+        while (cut < pipeline.text_size && !isIngestSpace(pipeline.text[cut]))
+            cut++;
+        pipeline.chunk_begin[i] = cut;
+    }
+    runOnWorkerPool(pool, parseIngestChunk, &pipeline);
+    pipeline.num_of_values = 0;
+    for (int i = 0; i < num_of_threads; i++) // values after the first malformed one are dropped, as the sequential reader stops there.
+    {
+        pipeline.value_offsets[i] = pipeline.num_of_values;
+        pipeline.num_of_values += pipeline.chunk_num_of_values[i];
+        if (pipeline.chunk_malformed[i])
+        {
+            for (int j = i + 1; j < num_of_threads; j++)
+                pipeline.value_offsets[j] = pipeline.num_of_values;
+            break;
+        }
+    }
+    if (pipeline.num_of_values % numofdimensions != 0)
+        printf("Error: Tuple count is less than the number of dimensions (%d < %d)\n", (int)(pipeline.num_of_values % numofdimensions), numofdimensions);
+    pipeline.num_of_tuples = (pipeline.num_of_values / numofdimensions > INT_MAX) ? INT_MAX : (int)(pipeline.num_of_values / numofdimensions);
+    pipeline.num_of_values = (long long)pipeline.num_of_tuples * numofdimensions;
+    pipeline.tuples = (pipeline.num_of_tuples > 0) ? reserveTuples(&rtree->tuple_pool, pipeline.num_of_tuples, numofdimensions) : NULL;
+    runOnWorkerPool(pool, gatherIngestValues, &pipeline);
+    free(pipeline.text);
+    free(pipeline.chunk_begin);
+    free(pipeline.chunk_values);
+    free(pipeline.chunk_num_of_values);
+    free(pipeline.chunk_malformed);
+    free(pipeline.value_offsets);
+    timings->parse = getTimeInSeconds() - start;
+    if (pipeline.num_of_tuples == 0)
+    {
+        freeWorkerPool(pool);
+        return 0;
+    }
+
+    start = getTimeInSeconds();
+    int num_of_samples = min(pipeline.num_of_tuples, 64 * num_of_threads);
+    int *samples = malloc(sizeof(int) * num_of_samples);
+    for (int i = 0; i < num_of_samples; i++) // evenly spaced tuples, the file order being as good as random for choosing splitters.
+        samples[i] = pipeline.tuples[(size_t)((long long)pipeline.num_of_tuples * i / num_of_samples) * numofdimensions];
+    qsort(samples, num_of_samples, sizeof(int), compareInts);
+    pipeline.splitters = malloc(sizeof(int) * num_of_threads);
+    for (int i = 0; i < num_of_threads - 1; i++)
+        pipeline.splitters[i] = samples[(long long)num_of_samples * (i + 1) / num_of_threads];
+    free(samples);
+    pipeline.entries = malloc(sizeof(struct BulkEntry) * pipeline.num_of_tuples);
+    pipeline.slab_entries = malloc(sizeof(struct BulkEntry) * pipeline.num_of_tuples);
+    pipeline.slab_counts = malloc(sizeof(int) * num_of_threads * num_of_threads);
+    pipeline.slab_begin = malloc(sizeof(int) * (num_of_threads + 1));
+    runOnWorkerPool(pool, countIngestSlabs, &pipeline);
+    pipeline.slab_begin[0] = 0;
+    for (int slab = 0; slab < num_of_threads; slab++)
+    {
+        pipeline.slab_begin[slab + 1] = pipeline.slab_begin[slab];
+        for (int w = 0; w < num_of_threads; w++)
+            pipeline.slab_begin[slab + 1] += pipeline.slab_counts[w * num_of_threads + slab];
+    }
+    runOnWorkerPool(pool, scatterIngestSlabs, &pipeline);
+    free(pipeline.entries);
+    free(pipeline.slab_counts);
+    free(pipeline.splitters);
+    timings->partition = getTimeInSeconds() - start;
+
+    // Every subtree is packed as many levels as the smallest slab allows while its top still needs more than one node, which keeps
+    // every node of every subtree at least min_entries full, since the larger slabs are at least as wide at every level.
+    start = getTimeInSeconds();
+    int smallest_slab = pipeline.num_of_tuples;
+    for (int slab = 0; slab < num_of_threads; slab++)
+        if (pipeline.slab_begin[slab + 1] > pipeline.slab_begin[slab])
+            smallest_slab = min(smallest_slab, pipeline.slab_begin[slab + 1] - pipeline.slab_begin[slab]);
+    pipeline.num_of_levels = 0;
+    for (int width = smallest_slab; width > rtree->max_entries; width = (width + rtree->max_entries - 1) / rtree->max_entries)
+        pipeline.num_of_levels++;
+    pipeline.subtrees = malloc(sizeof(struct Rtree *) * num_of_threads);
+    pipeline.num_of_tops = malloc(sizeof(int) * num_of_threads);
+    runOnWorkerPool(pool, buildIngestSubtree, &pipeline);
+    freeWorkerPool(pool);
+    timings->build = getTimeInSeconds() - start;
+
+    start = getTimeInSeconds();
+    int num_of_entries = 0;
+    for (int slab = 0; slab < num_of_threads; slab++) // gathers the tops of the subtrees at the front, slab by slab, and hands their nodes to the tree.
+    {
+        memmove(pipeline.slab_entries + num_of_entries, pipeline.slab_entries + pipeline.slab_begin[slab], sizeof(struct BulkEntry) * pipeline.num_of_tops[slab]);
+        num_of_entries += pipeline.num_of_tops[slab];
+        struct Rtree *subtree = pipeline.subtrees[slab];
+        if (subtree == NULL)
+            continue;
+        adoptNodeArena(&rtree->node_arena, &subtree->node_arena);
+        free_rtree(subtree);
+    }
+    bool leaf_level = (pipeline.num_of_levels == 0);
+    do // packs the tops level by level until a single node remains.
+    {
+        num_of_entries = packBulkLevel(rtree, pipeline.slab_entries, num_of_entries, leaf_level, method);
+        leaf_level = false;
+    } while (num_of_entries > 1);
+    rtree->root = pipeline.slab_entries[0].node;
+    clearQueryCache(rtree);
+    refreshAggregates(rtree, rtree->root); // the subtrees were built by trees of their own, which kept no aggregates.
+    timings->stitch = getTimeInSeconds() - start;
+
+    free(pipeline.slab_entries);
+    free(pipeline.slab_begin);
+    free(pipeline.subtrees);
+    free(pipeline.num_of_tops);
+    return 0;
+}
+
+// Binary tree files
+// saveRtree writes the tree to a pointer-free file that mapRtreeFile maps read-only and searches in place, so a saved index is
+// queryable as soon as it is mapped, without parsing or allocating. The file starts with a header page, followed by one fixed
+// size record per node in breadth-first order, the root first. Records are packed so that none straddles a page boundary, or
+// take whole pages when larger than one. A record holds a leaf flag, the number of entries and the MBR of the node, followed by
+// the coordinates of each tuple in a leaf, or by the MBR and file offset of each child in an internal node, so a search reads
+// a child only once its MBR overlaps the window. Values are stored in native byte order, which the header records.
+
+#define RTREE_FILE_MAGIC "RTREEBIN"   // first bytes of every tree file.
+#define RTREE_FILE_VERSION 1          // version of the file layout written by saveRtree.
+#define RTREE_FILE_BYTE_ORDER 0x01020304U // reads back differently on a machine of the other byte order.
+#define RTREE_FILE_MAX_HEIGHT 64      // deepest tree a file may describe. Every internal node has at least two children, so no tree that fits in memory comes close.
+
+struct RtreeFileHeader // first page of a tree file.
+{
+    char magic[8];                 // RTREE_FILE_MAGIC.
+    uint32_t version;              // RTREE_FILE_VERSION.
+    uint32_t byte_order;           // RTREE_FILE_BYTE_ORDER as written by the saving machine.
+    uint32_t numofdimensions;      // number of dimensions of the tuples.
+    uint32_t max_entries;          // fan-out of the saved tree, which fixes the size of a node record.
+    uint32_t min_entries;          // minimum fill of the saved tree.
+    uint32_t height;               // number of levels, 0 for an empty tree.
+    uint32_t node_size;            // size in bytes of one node record.
+    uint32_t reserved;             // zero, keeps the 64-bit fields aligned.
+    uint64_t num_of_nodes;         // number of node records.
+    uint64_t num_of_tuples;        // number of tuples in the leaves.
+    uint64_t root_offset;          // offset of the root record, 0 for an empty tree.
+    uint64_t file_size;            // size of the whole file in bytes, a multiple of the page size.
+    uint64_t checksum;             // getFileChecksum of the whole file, taken with this field set to 0.
+};
+
+struct FileNode // start of a node record. The MBR of the node and the entries follow.
+{
+    uint32_t leaf;        // 1 for a leaf, 0 for an internal node.
+    uint32_t num_entries; // number of tuples or children.
+};
+
+struct MappedRtree // a tree file mapped into memory and searched in place.
+{
+    const char *base;                     // start of the mapping.
+    size_t size;                          // size of the mapping in bytes.
+    const struct RtreeFileHeader *header; // header page of the file.
+    int numofdimensions;                  // number of dimensions of the tuples.
+};
+
+size_t getFileNodeSize(int max_entries, int numofdimensions) // returns the size of a node record: the record header and MBR, followed by max_entries child entries, the larger kind of entry.
+{
+    size_t entry_size = sizeof(struct BoundDefiner) * numofdimensions + sizeof(uint64_t);
+    size_t size = sizeof(struct FileNode) + sizeof(struct BoundDefiner) * numofdimensions + entry_size * max_entries;
+    return (size + 7) & ~(size_t)7;
+}
+
+uint64_t getFileNodeOffset(uint64_t index, size_t node_size) // returns the offset of the record of the node with the given breadth-first index.
+{
+    if (node_size > PAGE_SIZE_BYTES) // every record starts its own run of pages.
+        return PAGE_SIZE_BYTES + index * ((node_size + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES) * PAGE_SIZE_BYTES;
+    uint64_t nodes_per_page = PAGE_SIZE_BYTES / node_size;
+    return PAGE_SIZE_BYTES + (index / nodes_per_page) * PAGE_SIZE_BYTES + (index % nodes_per_page) * node_size;
+}
+
+uint64_t getFileChecksum(const char *data, size_t size, uint64_t checksum) // continues a checksum over size bytes, a multiple of 8, eight bytes at a time.
+{
+    for (size_t i = 0; i < size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(uint64_t));
+        checksum = (checksum ^ word) * 1099511628211ULL; // FNV-1a, on words instead of bytes.
+        checksum ^= checksum >> 29;
+    }
+    return checksum;
+}
+
+uint64_t getTreeFileChecksum(const char *data, size_t size) // checksums a whole tree file, as if the checksum field of its header were 0.
+{
+    struct RtreeFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    header.checksum = 0;
+    uint64_t checksum = getFileChecksum((const char *)&header, sizeof(header), 1469598103934665603ULL);
+    return getFileChecksum(data + sizeof(header), size - sizeof(header), checksum);
+}
+
+int saveRtree(struct Rtree *rtree, const char *filename) // writes the R-tree to a binary tree file. Returns 1 if the file cannot be written.
+{
+    if (rtree->extent_entries) // leaf records of tree files hold points.
+    {
+        printf("Extent trees cannot be saved to a tree file\n");
+        return 1;
+    }
+    flush_buffers(rtree); // tree files only hold tuples in leaf records.
+    int numofdimensions = rtree->numofdimensions;
+    size_t node_size = getFileNodeSize(rtree->max_entries, numofdimensions);
+    long int num_of_nodes = 0, num_of_tuples = 0;
+    struct Node **order = NULL; // the nodes in breadth-first order. The children of a node are consecutive, so each child index follows from a running count.
+    if (rtree->root != NULL)
+    {
+        long int capacity = 1024;
+        order = malloc(sizeof(struct Node *) * capacity);
+        order[num_of_nodes++] = rtree->root;
+        for (long int i = 0; i < num_of_nodes; i++)
+        {
+            struct Node *node = order[i];
+            if (is_leaf(node))
+            {
+                num_of_tuples += node->num_of_children_or_tuples;
+                continue;
+            }
+            if (num_of_nodes + node->num_of_children_or_tuples > capacity)
+            {
+                capacity = 2 * (num_of_nodes + node->num_of_children_or_tuples);
+                order = realloc(order, sizeof(struct Node *) * capacity);
+            }
+            for (int j = 0; j < node->num_of_children_or_tuples; j++)
+                order[num_of_nodes++] = node->child_nodes[j];
+        }
+    }
+
+    uint64_t file_size = (num_of_nodes == 0) ? PAGE_SIZE_BYTES : getFileNodeOffset(num_of_nodes - 1, node_size) + node_size;
+    file_size = (file_size + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES * PAGE_SIZE_BYTES;
+    char *data = calloc(file_size, 1);
+    if (data == NULL)
+    {
+        printf("Error allocating memory");
+        free(order);
+        return 1;
+    }
+    long int next_child = 1; // breadth-first index of the first child of the next internal node.
+    for (long int i = 0; i < num_of_nodes; i++)
+    {
+        struct Node *node = order[i];
+        struct FileNode *record = (struct FileNode *)(data + getFileNodeOffset(i, node_size));
+        record->leaf = is_leaf(node);
+        record->num_entries = node->num_of_children_or_tuples;
+        memcpy(record + 1, node->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+        char *entry = (char *)(record + 1) + sizeof(struct BoundDefiner) * numofdimensions;
+        for (int j = 0; j < node->num_of_children_or_tuples; j++)
+        {
+            if (is_leaf(node))
+            {
+                memcpy(entry, node->list_of_tuples[j], sizeof(int) * numofdimensions);
+                entry += sizeof(int) * numofdimensions;
+            }
+            else
+            {
+                uint64_t child_offset = getFileNodeOffset(next_child++, node_size);
+                memcpy(entry, node->child_nodes[j]->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+                memcpy(entry + sizeof(struct BoundDefiner) * numofdimensions, &child_offset, sizeof(uint64_t));
+                entry += sizeof(struct BoundDefiner) * numofdimensions + sizeof(uint64_t);
+            }
+        }
+    }
+
+    struct RtreeFileHeader *header = (struct RtreeFileHeader *)data;
+    memcpy(header->magic, RTREE_FILE_MAGIC, sizeof(header->magic));
+    header->version = RTREE_FILE_VERSION;
+    header->byte_order = RTREE_FILE_BYTE_ORDER;
+    header->numofdimensions = numofdimensions;
+    header->max_entries = rtree->max_entries;
+    header->min_entries = rtree->min_entries;
+    header->height = (rtree->root == NULL) ? 0 : getTreeHeight(rtree->root);
+    header->node_size = node_size;
+    header->num_of_nodes = num_of_nodes;
+    header->num_of_tuples = num_of_tuples;
+    header->root_offset = (num_of_nodes == 0) ? 0 : getFileNodeOffset(0, node_size);
+    header->file_size = file_size;
+    header->checksum = getTreeFileChecksum(data, file_size);
+    free(order);
+
+    FILE *file = fopen(filename, "wb");
+    bool written = (file != NULL && fwrite(data, 1, file_size, file) == file_size);
+    if (file != NULL && fclose(file) != 0)
+        written = false;
+    if (!written)
+        printf("Error writing file: %s\n", strerror(errno));
+    free(data);
+    return written ? 0 : 1;
+}
+
+struct MappedRtree *mapRtreeFile(const char *filename, bool verify_checksum) // maps a tree file read-only after checking its header, and its checksum if asked, which reads the whole file. Returns NULL if the file is missing, truncated or not a tree file.
+{
+    int descriptor = open(filename, O_RDONLY);
+    if (descriptor < 0)
+    {
+        printf("Error opening file: %s\n", strerror(errno));
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || (size_t)status.st_size < sizeof(struct RtreeFileHeader))
+    {
+        printf("Error: %s is not a tree file\n", filename);
+        close(descriptor);
+        return NULL;
+    }
+    void *base = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor); // the mapping stays valid without the descriptor.
+    if (base == MAP_FAILED)
+    {
+        printf("Error mapping file: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    const struct RtreeFileHeader *header = base;
+    const char *problem = NULL;
+    if (memcmp(header->magic, RTREE_FILE_MAGIC, sizeof(header->magic)) != 0)
+        problem = "not a tree file";
+    else if (header->byte_order != RTREE_FILE_BYTE_ORDER)
+        problem = "written on a machine of the other byte order";
+    else if (header->version != RTREE_FILE_VERSION)
+        problem = "unsupported version";
+    else if (header->file_size != (uint64_t)status.st_size || header->numofdimensions < 1 || header->max_entries < 2 ||
+             header->node_size != getFileNodeSize(header->max_entries, header->numofdimensions) ||
+             (header->num_of_nodes > 0 && getFileNodeOffset(header->num_of_nodes - 1, header->node_size) + header->node_size > header->file_size))
+        problem = "truncated or inconsistent header";
+    else if ((header->num_of_nodes == 0) ? header->height != 0
+                                         : (header->root_offset != getFileNodeOffset(0, header->node_size) || header->height < 1 ||
+                                            header->height > RTREE_FILE_MAX_HEIGHT || header->height > header->num_of_nodes)) // saveRtree always puts the root first, and searches size their stack by the height.
+        problem = "inconsistent root or height";
+    else if (verify_checksum && getTreeFileChecksum(base, header->file_size) != header->checksum)
+        problem = "checksum mismatch";
+    if (problem != NULL)
+    {
+        printf("Error: %s: %s\n", filename, problem);
+        munmap(base, status.st_size);
+        return NULL;
+    }
+
+    struct MappedRtree *mapped = malloc(sizeof(struct MappedRtree));
+    mapped->base = base;
+    mapped->size = status.st_size;
+    mapped->header = header;
+    mapped->numofdimensions = header->numofdimensions;
+    return mapped;
+}
+
+void unmapRtreeFile(struct MappedRtree *mapped) // releases a mapped tree file.
+{
+    if (mapped == NULL)
+        return;
+    munmap((void *)mapped->base, mapped->size);
+    free(mapped);
+}
+
+long int searchMappedRtree(struct MappedRtree *mapped, Bounds bounddefiners, SearchVisitor visitor, void *context) // streams every tuple of a mapped tree file in the given bounds to the visitor. The tuples point into the read-only mapping. With a NULL visitor only counts them.
+{
+    const struct RtreeFileHeader *header = mapped->header;
+    int numofdimensions = mapped->numofdimensions;
+    size_t mbr_size = sizeof(struct BoundDefiner) * numofdimensions;
+    long int numofresults = 0;
+    if (header->num_of_nodes == 0 || !overlaps(numofdimensions, bounddefiners, (Bounds)(mapped->base + header->root_offset + sizeof(struct FileNode))))
+        return 0;
+
+    size_t capacity = (size_t)header->height * header->max_entries + 1; // a depth-first stack holds at most the children of one node per level.
+    uint64_t *stack = malloc(sizeof(uint64_t) * capacity);                // the fan-out comes from the file, so the stack is not put on the call stack.
+    size_t top = 0;
+    stack[top++] = header->root_offset;
+    while (top > 0)
+    {
+        const struct FileNode *record = (const struct FileNode *)(mapped->base + stack[--top]);
+        const char *entry = (const char *)(record + 1) + mbr_size;
+        int num_entries = min(record->num_entries, header->max_entries); // a damaged record cannot send the search outside of the node.
+        if (record->leaf)
+        {
+            for (int i = 0; i < num_entries; i++, entry += sizeof(int) * numofdimensions)
+            {
+                if (checkIfTupleInBounds(bounddefiners, (int *)entry, numofdimensions))
+                {
+                    numofresults++;
+                    if (visitor != NULL && !visitor((int *)entry, context))
+                    {
+                        free(stack);
+                        return numofresults;
+                    }
+                }
+            }
+            continue;
+        }
+        for (int i = 0; i < num_entries; i++, entry += mbr_size + sizeof(uint64_t))
+        {
+            uint64_t child_offset;
+            memcpy(&child_offset, entry + mbr_size, sizeof(uint64_t));
+            if (overlaps(numofdimensions, bounddefiners, (Bounds)entry) && top < capacity && child_offset >= PAGE_SIZE_BYTES &&
+                child_offset + header->node_size <= header->file_size) // offsets are checked, so that a damaged file cannot send the search outside of the mapping.
+                stack[top++] = child_offset;
+        }
+    }
+    free(stack);
+    return numofresults;
+}
+
+// Paged storage
+// A PagedRtree keeps its nodes in a file of PAGE_SIZE_BYTES pages, one node per page, and reaches them only through a buffer
+// pool of a fixed number of frames, so the tree can be far larger than memory. Page 0 holds the header, and every other page a
+// node record laid out as in a tree file, with children referenced by page number. A page is pinned while it is used and can
+// only be evicted once unpinned; dirty pages are written back when evicted and when the tree is closed. The pool evicts the
+// least recently used unpinned page, or follows CLOCK, which approximates LRU with one reference bit per frame.
+// Insertion follows Guttman's algorithm as insert() does, with the leaf choice of chooseLeaf and the splits of splitEntries.
+
+#define PAGED_FILE_MAGIC "RTREEPAG" // first bytes of every paged tree file.
+#define PAGED_FILE_VERSION 1        // version of the paged file layout.
+#define NO_PAGE UINT64_MAX          // page number of a free buffer frame.
+
+enum BufferPolicy // how the buffer pool picks the page to evict.
+{
+    BUFFER_LRU,  // the least recently used unpinned page.
+    BUFFER_CLOCK // the first unpinned page the clock hand finds without its reference bit, clearing the bits it passes.
+};
+
+struct BufferPoolStats // counters used to size a buffer pool.
+{
+    unsigned long long hits;      // pins of a page already in the pool.
+    unsigned long long misses;    // pins that had to read the page, or set up a new one.
+    unsigned long long evictions; // pages dropped from the pool to make room.
+    unsigned long long writes;    // dirty pages written back to the file.
+};
+
+struct BufferFrame // one page-sized slot of the buffer pool.
+{
+    uint64_t page;  // page held by the frame, NO_PAGE if none.
+    int pin_count;  // number of users of the page, which cannot be evicted while pinned.
+    bool dirty;     // whether the page changed since it was read.
+    bool reference; // CLOCK: set when the page is pinned, cleared by the passing hand.
+    int lru_prev;   // LRU: next more recently used frame, -1 at the head.
+    int lru_next;   // LRU: next less recently used frame, -1 at the tail.
+};
+
+struct BufferPool // fixed set of page frames in front of a paged tree file.
+{
+    int descriptor;            // file holding the pages.
+    enum BufferPolicy policy;  // eviction policy.
+    int num_of_frames;         // number of frames.
+    char *data;                // num_of_frames pages back to back.
+    struct BufferFrame *frames; // state of each frame.
+    int *frame_of_page;        // frame holding each page, -1 if the page is not in the pool.
+    uint64_t page_capacity;    // number of pages frame_of_page can describe.
+    int num_of_used_frames;    // frames that have held a page, the others are still free.
+    int lru_head;              // LRU: most recently used frame.
+    int lru_tail;              // LRU: least recently used frame.
+    int clock_hand;            // CLOCK: next frame to consider.
+    struct BufferPoolStats stats; // hit, miss, eviction and write counters.
+};
+
+struct PagedFileHeader // page 0 of a paged tree file.
+{
+    char magic[8];          // PAGED_FILE_MAGIC.
+    uint32_t version;       // PAGED_FILE_VERSION.
+    uint32_t byte_order;    // RTREE_FILE_BYTE_ORDER as written by the saving machine.
+    uint32_t numofdimensions; // number of dimensions of the tuples.
+    uint32_t max_entries;   // fan-out, at most getPagedFanout.
+    uint32_t min_entries;   // minimum fill.
+    uint32_t height;        // number of levels, 0 for an empty tree.
+    uint64_t root_page;     // page of the root, 0 for an empty tree.
+    uint64_t num_of_pages;  // pages in the file, including the header page.
+    uint64_t num_of_tuples; // number of tuples in the tree.
+};
+
+struct PagedRtree // an R-tree whose nodes live in a file of pages behind a buffer pool.
+{
+    struct PagedFileHeader header; // header of the file, written back when the tree is closed.
+    struct BufferPool pool;        // buffer pool through which every page is reached.
+    struct Rtree *shape;           // empty in-memory tree lending its shape, split policy and split scratch space to the splits.
+    char *split_entries;           // copies of the max_entries + 1 entries of a node being split.
+};
+
+int getPagedFanout(int numofdimensions) // largest fan-out whose node record fits in one page.
+{
+    int max_entries = 2;
+    while (getFileNodeSize(max_entries + 1, numofdimensions) <= PAGE_SIZE_BYTES)
+        max_entries++;
+    return max_entries;
+}
+
+size_t getPagedEntrySize(struct PagedRtree *tree, bool leaf) // size in bytes of an entry of a leaf or of an internal node.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    return leaf ? sizeof(int) * numofdimensions : sizeof(struct BoundDefiner) * numofdimensions + sizeof(uint64_t);
+}
+
+char *getPagedEntry(struct PagedRtree *tree, struct FileNode *record, int index) // returns an entry of a node record: the coordinates of a tuple, or the MBR of a child followed by its page number.
+{
+    return (char *)(record + 1) + sizeof(struct BoundDefiner) * tree->header.numofdimensions + getPagedEntrySize(tree, record->leaf) * index;
+}
+
+uint64_t getPagedChild(struct PagedRtree *tree, struct FileNode *record, int index) // returns the page of a child of an internal node record.
+{
+    uint64_t page;
+    memcpy(&page, getPagedEntry(tree, record, index) + sizeof(struct BoundDefiner) * tree->header.numofdimensions, sizeof(uint64_t));
+    return page;
+}
+
+int getPagedNumEntries(struct PagedRtree *tree, struct FileNode *record) // returns the number of entries of a node record, at most the fan-out, so that a damaged record cannot send a search or an insertion past the end of its page.
+{
+    return (record->num_entries < tree->header.max_entries) ? (int)record->num_entries : (int)tree->header.max_entries; // compared unsigned, as a count past INT_MAX would turn negative.
+}
+
+bool isPagedChildValid(struct PagedRtree *tree, uint64_t page) // checks that a child page number read from a record names a node page of the file.
+{
+    return page > 0 && page < tree->header.num_of_pages;
+}
+
+void recalculatePagedMBR(struct PagedRtree *tree, struct FileNode *record) // recomputes the MBR of a node record from its entries.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    Bounds bounddefiners = (Bounds)(record + 1);
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        bounddefiners[i].dmin = INT_MAX;
+        bounddefiners[i].dmax = INT_MIN;
+    }
+    for (int j = 0; j < getPagedNumEntries(tree, record); j++)
+    {
+        char *entry = getPagedEntry(tree, record, j);
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            int low = record->leaf ? ((int *)entry)[i] : ((Bounds)entry)[i].dmin;
+            int high = record->leaf ? ((int *)entry)[i] : ((Bounds)entry)[i].dmax;
+            bounddefiners[i].dmin = min(bounddefiners[i].dmin, low);
+            bounddefiners[i].dmax = max(bounddefiners[i].dmax, high);
+        }
+    }
+}
+
+void initBufferPool(struct BufferPool *pool, int descriptor, int num_of_frames, enum BufferPolicy policy) // sets up an empty buffer pool over an open file.
+{
+    pool->descriptor = descriptor;
+    pool->policy = policy;
+    pool->num_of_frames = num_of_frames;
+    pool->data = malloc((size_t)PAGE_SIZE_BYTES * num_of_frames);
+    pool->frames = malloc(sizeof(struct BufferFrame) * num_of_frames);
+    for (int i = 0; i < num_of_frames; i++)
+        pool->frames[i] = (struct BufferFrame){NO_PAGE, 0, false, false, -1, -1};
+    pool->page_capacity = 0;
+    pool->frame_of_page = NULL;
+    pool->num_of_used_frames = 0;
+    pool->lru_head = pool->lru_tail = -1;
+    pool->clock_hand = 0;
+    pool->stats = (struct BufferPoolStats){0, 0, 0, 0};
+}
+
+void unlinkLruFrame(struct BufferPool *pool, int frame) // LRU: takes a frame out of the recency list.
+{
+    struct BufferFrame *state = &pool->frames[frame];
+    if (state->lru_prev >= 0)
+        pool->frames[state->lru_prev].lru_next = state->lru_next;
+    else if (pool->lru_head == frame)
+        pool->lru_head = state->lru_next;
+    if (state->lru_next >= 0)
+        pool->frames[state->lru_next].lru_prev = state->lru_prev;
+    else if (pool->lru_tail == frame)
+        pool->lru_tail = state->lru_prev;
+    state->lru_prev = state->lru_next = -1;
+}
+
+void touchBufferFrame(struct BufferPool *pool, int frame) // records a use of a frame for the eviction policy.
+{
+    if (pool->policy == BUFFER_CLOCK)
+    {
+        pool->frames[frame].reference = true;
+        return;
+    }
+    unlinkLruFrame(pool, frame); // moves the frame to the head of the recency list.
+    pool->frames[frame].lru_next = pool->lru_head;
+    if (pool->lru_head >= 0)
+        pool->frames[pool->lru_head].lru_prev = frame;
+    pool->lru_head = frame;
+    if (pool->lru_tail < 0)
+        pool->lru_tail = frame;
+}
+
+bool writeBufferFrame(struct BufferPool *pool, int frame) // writes a dirty frame back to its page. Returns false on an I/O error.
+{
+    struct BufferFrame *state = &pool->frames[frame];
+    if (!state->dirty)
+        return true;
+    if (pwrite(pool->descriptor, pool->data + (size_t)frame * PAGE_SIZE_BYTES, PAGE_SIZE_BYTES, (off_t)state->page * PAGE_SIZE_BYTES) != PAGE_SIZE_BYTES)
+    {
+        printf("Error writing page %llu: %s\n", (unsigned long long)state->page, strerror(errno));
+        return false;
+    }
+    state->dirty = false;
+    pool->stats.writes++;
+    return true;
+}
+
+int findVictimFrame(struct BufferPool *pool) // returns a frame to reuse, evicting its page if needed. Returns -1 if every frame is pinned.
+{
+    if (pool->num_of_used_frames < pool->num_of_frames)
+        return pool->num_of_used_frames++;
+    int victim = -1;
+    if (pool->policy == BUFFER_LRU)
+    {
+        for (int frame = pool->lru_tail; frame >= 0 && victim < 0; frame = pool->frames[frame].lru_prev)
+            if (pool->frames[frame].pin_count == 0)
+                victim = frame;
+    }
+    else
+    {
+        for (int step = 0; step < 2 * pool->num_of_frames && victim < 0; step++) // two sweeps clear every reference bit on the way.
+        {
+            struct BufferFrame *state = &pool->frames[pool->clock_hand];
+            if (state->pin_count == 0 && !state->reference)
+                victim = pool->clock_hand;
+            else if (state->pin_count == 0)
+                state->reference = false;
+            pool->clock_hand = (pool->clock_hand + 1) % pool->num_of_frames;
+        }
+    }
+    if (victim < 0)
+        return -1;
+    if (pool->frames[victim].page != NO_PAGE) // a frame left empty by a failed read holds nothing to evict.
+    {
+        writeBufferFrame(pool, victim);
+        pool->frame_of_page[pool->frames[victim].page] = -1;
+        pool->stats.evictions++;
+    }
+    return victim;
+}
+
+struct FileNode *pinPage(struct PagedRtree *tree, uint64_t page, bool fresh) // pins a page in the buffer pool and returns its record. A fresh page was just allocated, so it is not read from the file. Returns NULL if every frame is pinned or the page cannot be read.
+{
+    struct BufferPool *pool = &tree->pool;
+    if (page >= pool->page_capacity) // the page table grows with the file.
+    {
+        uint64_t capacity = (pool->page_capacity == 0) ? 1024 : pool->page_capacity;
+        while (capacity <= page)
+            capacity *= 2;
+        pool->frame_of_page = realloc(pool->frame_of_page, sizeof(int) * capacity);
+        for (uint64_t i = pool->page_capacity; i < capacity; i++)
+            pool->frame_of_page[i] = -1;
+        pool->page_capacity = capacity;
+    }
+    int frame = pool->frame_of_page[page];
+    if (frame >= 0)
+    {
+        pool->stats.hits++;
+    }
+    else
+    {
+        pool->stats.misses++;
+        frame = findVictimFrame(pool);
+        if (frame < 0)
+        {
+            printf("Error: every page of the buffer pool is pinned\n");
+            return NULL;
+        }
+        char *data = pool->data + (size_t)frame * PAGE_SIZE_BYTES;
+        if (fresh)
+        {
+            memset(data, 0, PAGE_SIZE_BYTES);
+        }
+        else if (pread(pool->descriptor, data, PAGE_SIZE_BYTES, (off_t)page * PAGE_SIZE_BYTES) != PAGE_SIZE_BYTES)
+        {
+            printf("Error reading page %llu: %s\n", (unsigned long long)page, strerror(errno));
+            pool->frames[frame].page = NO_PAGE;
+            return NULL;
+        }
+        pool->frames[frame] = (struct BufferFrame){page, 0, fresh, false, pool->frames[frame].lru_prev, pool->frames[frame].lru_next};
+        pool->frame_of_page[page] = frame;
+    }
+    pool->frames[frame].pin_count++;
+    touchBufferFrame(pool, frame);
+    return (struct FileNode *)(pool->data + (size_t)frame * PAGE_SIZE_BYTES);
+}
+
+void unpinPage(struct PagedRtree *tree, uint64_t page, bool dirty) // releases a pin taken by pinPage, marking the page dirty if it was changed.
+{
+    struct BufferFrame *state = &tree->pool.frames[tree->pool.frame_of_page[page]];
+    state->pin_count--;
+    state->dirty |= dirty;
+}
+
+struct FileNode *allocatePage(struct PagedRtree *tree, bool leaf, uint64_t *page) // appends an empty node page to the file and returns it pinned.
+{
+    *page = tree->header.num_of_pages++;
+    struct FileNode *record = pinPage(tree, *page, true);
+    if (record == NULL)
+        return NULL;
+    record->leaf = leaf;
+    record->num_entries = 0;
+    recalculatePagedMBR(tree, record);
+    return record;
+}
+
+bool writePagedHeader(struct PagedRtree *tree) // writes the header page. Returns false on an I/O error.
+{
+    char page[PAGE_SIZE_BYTES] = {0};
+    memcpy(page, &tree->header, sizeof(tree->header));
+    return pwrite(tree->pool.descriptor, page, PAGE_SIZE_BYTES, 0) == PAGE_SIZE_BYTES;
+}
+
+struct PagedRtree *openPagedRtreeFile(const char *filename, bool create, int numofdimensions, int max_entries, int min_entries, int num_of_frames, enum BufferPolicy policy) // opens a paged tree file, or creates an empty one with the given shape, behind a buffer pool of num_of_frames pages. Returns NULL if the file cannot be used.
+{
+    int descriptor = create ? open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644) : open(filename, O_RDWR);
+    if (descriptor < 0)
+    {
+        printf("Error opening file: %s\n", strerror(errno));
+        return NULL;
+    }
+    struct PagedRtree *tree = malloc(sizeof(struct PagedRtree));
+    if (create)
+    {
+        memset(&tree->header, 0, sizeof(tree->header));
+        memcpy(tree->header.magic, PAGED_FILE_MAGIC, sizeof(tree->header.magic));
+        tree->header.version = PAGED_FILE_VERSION;
+        tree->header.byte_order = RTREE_FILE_BYTE_ORDER;
+        tree->header.numofdimensions = numofdimensions;
+        tree->header.max_entries = max_entries;
+        tree->header.min_entries = min_entries;
+        tree->header.num_of_pages = 1;
+    }
+    const char *problem = NULL;
+    if (!create && pread(descriptor, &tree->header, sizeof(tree->header), 0) != sizeof(tree->header))
+        problem = "not a paged tree file";
+    else if (memcmp(tree->header.magic, PAGED_FILE_MAGIC, sizeof(tree->header.magic)) != 0)
+        problem = "not a paged tree file";
+    else if (tree->header.byte_order != RTREE_FILE_BYTE_ORDER || tree->header.version != PAGED_FILE_VERSION)
+        problem = "written on a machine of the other byte order or by another version";
+    else if (tree->header.numofdimensions < 1 || tree->header.max_entries < 2 || (int)tree->header.max_entries > getPagedFanout(tree->header.numofdimensions) ||
+             tree->header.min_entries < 1 || tree->header.min_entries > tree->header.max_entries / 2)
+        problem = "invalid tree shape for a page";
+    else if (tree->header.num_of_pages < 1 || ((tree->header.height == 0) ? tree->header.root_page != 0
+                                                                          : (tree->header.height > RTREE_FILE_MAX_HEIGHT || tree->header.height >= tree->header.num_of_pages ||
+                                                                             !isPagedChildValid(tree, tree->header.root_page)))) // searches size their stack by the height.
+        problem = "inconsistent root or height";
+    if (problem != NULL)
+    {
+        printf("Error: %s: %s\n", filename, problem);
+        close(descriptor);
+        free(tree);
+        return NULL;
+    }
+    initBufferPool(&tree->pool, descriptor, max(num_of_frames, 4), policy); // an insertion pins up to three pages at once.
+    tree->shape = new_rtree(tree->header.max_entries, tree->header.min_entries, tree->header.numofdimensions);
+    tree->split_entries = malloc(getPagedEntrySize(tree, false) * (tree->header.max_entries + 1));
+    return tree;
+}
+
+int closePagedRtree(struct PagedRtree *tree) // writes back every dirty page and the header, then releases the tree. Returns 1 on an I/O error.
+{
+    if (tree == NULL)
+        return 0;
+    bool written = true;
+    for (int frame = 0; frame < tree->pool.num_of_used_frames; frame++)
+        written &= writeBufferFrame(&tree->pool, frame);
+    written &= writePagedHeader(tree);
+    written &= (close(tree->pool.descriptor) == 0);
+    free(tree->pool.data);
+    free(tree->pool.frames);
+    free(tree->pool.frame_of_page);
+    free_rtree(tree->shape);
+    free(tree->split_entries);
+    free(tree);
+    return written ? 0 : 1;
+}
+
+int chooseLeafPaged(struct PagedRtree *tree, int *tuple, uint64_t *path, int *path_index) // chooseLeaf over pages: fills in the page of every node on the way from the root to the chosen leaf, and the entry taken in each. Returns -1 on an I/O error.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    path[0] = tree->header.root_page;
+    for (int level = 0; level + 1 < (int)tree->header.height; level++)
+    {
+        struct FileNode *record = pinPage(tree, path[level], false);
+        if (record == NULL)
+            return -1;
+        long int minarea = LONG_MAX, minareaenlargedoninclusion = LONG_MAX;
+        int minareaindex = 0;
+        int num_entries = getPagedNumEntries(tree, record);
+        for (int i = 0; i < num_entries; i++) // least area enlargement, ties broken by least area, as in chooseLeaf.
+        {
+            Bounds child_bounds = (Bounds)getPagedEntry(tree, record, i);
+            long int areaenlargedoninclusion = getAreaEnlargedOnInclusion(numofdimensions, child_bounds, tuple);
+            if (areaenlargedoninclusion < minareaenlargedoninclusion)
+            {
+                minareaenlargedoninclusion = areaenlargedoninclusion;
+                minareaindex = i;
+            }
+            else if (areaenlargedoninclusion == minareaenlargedoninclusion)
+            {
+                long int area = getArea(numofdimensions, child_bounds);
+                if (area < minarea)
+                {
+                    minarea = area;
+                    minareaindex = i;
+                }
+            }
+        }
+        path_index[level] = minareaindex;
+        path[level + 1] = getPagedChild(tree, record, minareaindex);
+        unpinPage(tree, path[level], false);
+        if (num_entries == 0 || !isPagedChildValid(tree, path[level + 1])) // a damaged internal node leads nowhere.
+            return -1;
+    }
+    return 0;
+}
+
+uint64_t splitPagedNode(struct PagedRtree *tree, struct FileNode *record, char *new_entry) // splits a full node record together with one more entry: the node keeps one group and a new page takes the other. Returns the new page, left unpinned, or NO_PAGE on an I/O error.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    int max_entries = tree->header.max_entries;
+    size_t entry_size = getPagedEntrySize(tree, record->leaf);
+    struct SplitArray *splitArray = tree->shape->splitArray;
+    memcpy(tree->split_entries, new_entry, entry_size); // the new entry comes first, followed by those of the node, as in nodeSplit.
+    memcpy(tree->split_entries + entry_size, getPagedEntry(tree, record, 0), entry_size * max_entries);
+    for (int i = 0; i <= max_entries; i++)
+    {
+        char *entry = tree->split_entries + entry_size * i;
+        if (record->leaf) // each tuple gets a degenerate MBR.
+        {
+            Bounds bounds = splitArray->point_bounds + i * numofdimensions;
+            for (int j = 0; j < numofdimensions; j++)
+                bounds[j].dmin = bounds[j].dmax = ((int *)entry)[j];
+            splitArray->entry_bounds[i] = bounds;
+        }
+        else
+        {
+            splitArray->entry_bounds[i] = (Bounds)entry;
+        }
+    }
+    splitEntries(tree->shape, splitArray);
+
+    uint64_t split_page;
+    struct FileNode *split_record = allocatePage(tree, record->leaf, &split_page);
+    if (split_record == NULL)
+        return NO_PAGE;
+    record->num_entries = splitArray->group_size[0];
+    for (int i = 0; i < splitArray->group_size[0]; i++)
+        memcpy(getPagedEntry(tree, record, i), tree->split_entries + entry_size * splitArray->groups[0][i], entry_size);
+    split_record->num_entries = splitArray->group_size[1];
+    for (int i = 0; i < splitArray->group_size[1]; i++)
+        memcpy(getPagedEntry(tree, split_record, i), tree->split_entries + entry_size * splitArray->groups[1][i], entry_size);
+    recalculatePagedMBR(tree, record);
+    recalculatePagedMBR(tree, split_record);
+    unpinPage(tree, split_page, true);
+    return split_page;
+}
+
+int insertPaged(struct PagedRtree *tree, int *tuple) // inserts a tuple into a paged R-tree. Returns 1 on an I/O error.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    int height = tree->header.height;
+    if (height == 0) // the first tuple starts a root leaf.
+    {
+        struct FileNode *root = allocatePage(tree, true, &tree->header.root_page);
+        if (root == NULL)
+            return 1;
+        tree->header.height = height = 1;
+        unpinPage(tree, tree->header.root_page, true);
+    }
+    uint64_t path[height];
+    int path_index[height];
+    if (chooseLeafPaged(tree, tuple, path, path_index) != 0)
+        return 1;
+
+    // Walks back up from the leaf. entry holds the entry to add to the node of the current level, a tuple in the leaf and then
+    // the MBR and page of a new sibling, and child_bounds the MBR of the node of the level below, refreshed in its parent.
+    char entry[getPagedEntrySize(tree, false)];
+    memcpy(entry, tuple, sizeof(int) * numofdimensions);
+    bool pending = true; // whether entry still has to be added.
+    struct BoundDefiner child_bounds[numofdimensions];
+    for (int level = height - 1; level >= 0; level--)
+    {
+        struct FileNode *record = pinPage(tree, path[level], false);
+        if (record == NULL)
+            return 1;
+        record->num_entries = getPagedNumEntries(tree, record); // a damaged count is clamped before entries are added or split.
+        bool changed = pending;
+        if (level < height - 1) // refreshes the entry of the child on the path, whose MBR changed.
+        {
+            Bounds entry_bounds = (Bounds)getPagedEntry(tree, record, path_index[level]);
+            changed |= (memcmp(entry_bounds, child_bounds, sizeof(child_bounds)) != 0);
+            memcpy(entry_bounds, child_bounds, sizeof(child_bounds));
+        }
+        uint64_t split_page = NO_PAGE;
+        if (pending && (int)record->num_entries < (int)tree->header.max_entries)
+        {
+            memcpy(getPagedEntry(tree, record, record->num_entries++), entry, getPagedEntrySize(tree, record->leaf));
+        }
+        else if (pending)
+        {
+            split_page = splitPagedNode(tree, record, entry);
+            if (split_page == NO_PAGE)
+                return 1;
+        }
+        recalculatePagedMBR(tree, record);
+        memcpy(child_bounds, record + 1, sizeof(child_bounds));
+        unpinPage(tree, path[level], changed);
+        pending = (split_page != NO_PAGE);
+        if (pending) // the new sibling becomes the entry to add one level up.
+        {
+            struct FileNode *split_record = pinPage(tree, split_page, false);
+            if (split_record == NULL)
+                return 1;
+            memcpy(entry, split_record + 1, sizeof(child_bounds));
+            memcpy(entry + sizeof(child_bounds), &split_page, sizeof(uint64_t));
+            unpinPage(tree, split_page, false);
+        }
+        else if (!changed) // nothing changed here, so nothing changes above.
+        {
+            break;
+        }
+    }
+
+    if (pending) // the root was split, so a new root takes the old one and its sibling.
+    {
+        uint64_t root_page;
+        struct FileNode *root = allocatePage(tree, false, &root_page);
+        if (root == NULL)
+            return 1;
+        char *root_entry = getPagedEntry(tree, root, 0);
+        memcpy(root_entry, child_bounds, sizeof(child_bounds));
+        memcpy(root_entry + sizeof(child_bounds), &tree->header.root_page, sizeof(uint64_t));
+        memcpy(getPagedEntry(tree, root, 1), entry, getPagedEntrySize(tree, false));
+        root->num_entries = 2;
+        recalculatePagedMBR(tree, root);
+        unpinPage(tree, root_page, true);
+        tree->header.root_page = root_page;
+        tree->header.height++;
+    }
+    tree->header.num_of_tuples++;
+    return 0;
+}
+
+long int searchPaged(struct PagedRtree *tree, Bounds bounddefiners, SearchVisitor visitor, void *context) // streams every tuple of a paged R-tree in the given bounds to the visitor, which sees each tuple while its leaf is pinned. With a NULL visitor only counts them. Returns -1 on an I/O error.
+{
+    int numofdimensions = tree->header.numofdimensions;
+    if (tree->header.height == 0)
+        return 0;
+    size_t capacity = (size_t)tree->header.height * tree->header.max_entries + 1; // a depth-first stack holds at most the children of one node per level.
+    uint64_t *stack = malloc(sizeof(uint64_t) * capacity);
+    size_t top = 0;
+    long int numofresults = 0;
+    stack[top++] = tree->header.root_page;
+    while (top > 0)
+    {
+        uint64_t page = stack[--top];
+        struct FileNode *record = pinPage(tree, page, false);
+        if (record == NULL)
+        {
+            free(stack);
+            return -1;
+        }
+        bool stop = false;
+        int num_entries = getPagedNumEntries(tree, record);
+        if (record->leaf)
+        {
+            for (int i = 0; i < num_entries && !stop; i++)
+            {
+                int *entry_tuple = (int *)getPagedEntry(tree, record, i);
+                if (checkIfTupleInBounds(bounddefiners, entry_tuple, numofdimensions))
+                {
+                    numofresults++;
+                    stop = (visitor != NULL && !visitor(entry_tuple, context));
+                }
+            }
+        }
+        else if (page != tree->header.root_page || overlaps(numofdimensions, bounddefiners, (Bounds)(record + 1)))
+        {
+            for (int i = 0; i < num_entries; i++)
+            {
+                uint64_t child_page = getPagedChild(tree, record, i);
+                if (overlaps(numofdimensions, bounddefiners, (Bounds)getPagedEntry(tree, record, i)) && top < capacity &&
+                    isPagedChildValid(tree, child_page)) // page numbers are checked, so that a damaged file cannot send the search astray.
+                    stack[top++] = child_page;
+            }
+        }
+        unpinPage(tree, page, false);
+        if (stop)
+            break;
+    }
+    free(stack);
+    return numofresults;
+}
+
+void free_rtree(struct Rtree *rtree) // releases the R-tree together with all of its nodes and tuples, slab by slab.
+{
+    if (rtree == NULL)
+        return;
+
+    if (rtree->buffer_capacity > 0 && rtree->root != NULL)
+        freePendingBuffers(rtree->root);
+    if (rtree->concurrent)
+    {
+        if (rtree->root != NULL)
+            freeNodeLatches(rtree->root);
+        pthread_mutex_destroy(&rtree->writer_lock);
+        pthread_rwlock_destroy(&rtree->root_latch);
+    }
+    for (int i = 0; i < rtree->node_arena.num_of_slabs; i++)
+        free(rtree->node_arena.slabs[i]);
+    free(rtree->node_arena.slabs);
+    for (int i = 0; i < rtree->tuple_pool.num_of_chunks; i++)
+        free(rtree->tuple_pool.chunks[i]);
+    free(rtree->tuple_pool.chunks);
+    free(rtree->tuple_pool.free_tuples);
+    freeSplitArray(rtree->splitArray);
+    freeQueryCache(rtree->query_cache);
+    free(rtree);
+}
+
+// Statistics
+// getTreeStatistics walks the tree on demand and describes every level: its nodes, their fill, the total area and margin of their
+// MBRs, and how much siblings overlap, which is what a range query pays for. The insert counters kept in the tree and the query
+// counters filled by searchTuplesInGivenBoundsWithCounters show where the work went. dumpTreeStatistics writes all of it as one
+// line of JSON. Building with -DRTREE_NO_STATS compiles the counters out, and they then read 0.
+
+struct LevelStatistics // shape of one level of the tree.
+{
+    long int num_of_nodes;   // nodes on the level.
+    long int num_of_entries; // children of the nodes, or tuples for the leaves.
+    double total_area;       // sum of the areas of the MBRs of the nodes.
+    double total_margin;     // sum of the margins of the MBRs of the nodes.
+    double sibling_overlap;  // sum, over every pair of nodes with the same parent, of the area of the intersection of their MBRs.
+};
+
+struct TreeStatistics // shape of the whole tree, from getTreeStatistics.
+{
+    int height;                     // number of levels, 0 for an empty tree.
+    struct LevelStatistics *levels; // one per level, leaves first, so that levels[height - 1] is the root. Released by freeTreeStatistics.
+};
+
+void collectLevelStatistics(struct Rtree *rtree, struct Node *node, int level, struct LevelStatistics *levels) // adds a node, at the given level with leaves at 0, and its subtree to the statistics of their levels.
+{
+    int numofdimensions = rtree->numofdimensions;
+    struct LevelStatistics *statistics = &levels[level];
+    statistics->num_of_nodes++;
+    statistics->num_of_entries += node->num_of_children_or_tuples;
+    statistics->total_area += getArea(numofdimensions, node->bounddefiners);
+    statistics->total_margin += getMargin(numofdimensions, node->bounddefiners);
+    if (is_leaf(node))
+        return;
+    for (int i = 0; i < node->num_of_children_or_tuples; i++)
+    {
+        for (int j = i + 1; j < node->num_of_children_or_tuples; j++)
+            levels[level - 1].sibling_overlap += getOverlapArea(numofdimensions, node->child_nodes[i]->bounddefiners, node->child_nodes[j]->bounddefiners);
+        collectLevelStatistics(rtree, node->child_nodes[i], level - 1, levels);
+    }
+}
+
+struct TreeStatistics getTreeStatistics(struct Rtree *rtree) // describes every level of the R-tree.
+{
+    struct TreeStatistics statistics = {0, NULL};
+    if (rtree->root == NULL)
+        return statistics;
+    statistics.height = getTreeHeight(rtree->root);
+    statistics.levels = calloc(statistics.height, sizeof(struct LevelStatistics));
+    collectLevelStatistics(rtree, rtree->root, statistics.height - 1, statistics.levels);
+    return statistics;
+}
+
+void freeTreeStatistics(struct TreeStatistics *statistics) // releases the levels of tree statistics.
+{
+    free(statistics->levels);
+    statistics->levels = NULL;
+    statistics->height = 0;
+}
+
+void dumpTreeStatistics(struct Rtree *rtree, FILE *out) // writes the level statistics and the insert counters of the R-tree as one line of JSON.
+{
+    struct TreeStatistics statistics = getTreeStatistics(rtree);
+    long int num_of_nodes = 0;
+    for (int level = 0; level < statistics.height; level++)
+        num_of_nodes += statistics.levels[level].num_of_nodes;
+    struct InsertCounters *counters = &rtree->insert_counters;
+    fprintf(out, "{\"height\": %d, \"nodes\": %ld, \"tuples\": %ld, \"pending_tuples\": %ld, \"max_entries\": %d, \"min_entries\": %d, \"dims\": %d, \"levels\": [",
+            statistics.height, num_of_nodes, statistics.height > 0 ? statistics.levels[0].num_of_entries + rtree->num_of_pending_tuples : 0, rtree->num_of_pending_tuples,
+            rtree->max_entries, rtree->min_entries, rtree->numofdimensions);
+    for (int level = 0; level < statistics.height; level++)
+    {
+        struct LevelStatistics *l = &statistics.levels[level];
+        fprintf(out, "%s{\"level\": %d, \"nodes\": %ld, \"entries\": %ld, \"fill\": %.4f, \"area\": %.6g, \"margin\": %.6g, \"sibling_overlap\": %.6g}", level > 0 ? ", " : "",
+                level, l->num_of_nodes, l->num_of_entries, (double)l->num_of_entries / ((double)l->num_of_nodes * rtree->max_entries), l->total_area, l->total_margin, l->sibling_overlap);
+    }
+    fprintf(out, "], \"counters\": %s, \"leaf_splits\": %llu, \"internal_splits\": %llu, \"root_splits\": %llu, \"forced_reinserts\": %llu, \"reinserted_entries\": %llu, \"buffer_flushes\": %llu}\n",
+            RTREE_STATS_ENABLED ? "true" : "false", counters->leaf_splits, counters->internal_splits, counters->root_splits, counters->forced_reinserts, counters->reinserted_entries,
+            counters->buffer_flushes);
+    freeTreeStatistics(&statistics);
+}
+
+void dumpQueryCounters(struct QueryCounters *counters, FILE *out) // writes query counters as one line of JSON.
+{
+    fprintf(out, "{\"counters\": %s, \"nodes_visited\": %llu, \"leaves_scanned\": %llu, \"false_positive_hits\": %llu, \"results\": %llu}\n", RTREE_STATS_ENABLED ? "true" : "false",
+            counters->nodes_visited, counters->leaves_scanned, counters->false_positive_hits, counters->results);
+}
+
+int validateNode(struct Rtree *rtree, struct Node *node, int depth, int leaf_depth) // checks the invariants of a node and its subtree. Returns the number of violations found.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int violations = 0;
+    int count = node->num_of_children_or_tuples;
+    if (count > rtree->max_entries)
+        violations++;
+    if (node != rtree->root && count < rtree->min_entries) // only the root may hold fewer than min_entries entries.
+        violations++;
+    if (node == rtree->root && !is_leaf(node) && count < 2) // an internal root has at least two children.
+        violations++;
+    if (is_leaf(node) != (depth == leaf_depth)) // every leaf is at the same depth.
+        violations++;
+
+    if (node->num_of_pending_tuples > (is_leaf(node) ? 0 : rtree->buffer_capacity)) // buffered mode: only internal nodes buffer tuples, and never more than the capacity.
+        violations++;
+    for (int i = 0; i < numofdimensions; i++) // the MBR must be exactly the bounding box of the entries, and of the tuples waiting in the node.
+    {
+        int dmin = INT_MAX, dmax = INT_MIN;
+        for (int j = 0; j < count; j++)
+        {
+            if (node->extent_entries)
+            {
+                dmin = min(dmin, getExtentBounds(node->list_of_tuples[j])[i].dmin);
+                dmax = max(dmax, getExtentBounds(node->list_of_tuples[j])[i].dmax);
+                continue;
+            }
+            dmin = min(dmin, is_leaf(node) ? node->list_of_tuples[j][i] : node->child_nodes[j]->bounddefiners[i].dmin);
+            dmax = max(dmax, is_leaf(node) ? node->list_of_tuples[j][i] : node->child_nodes[j]->bounddefiners[i].dmax);
+        }
+        for (int j = 0; j < node->num_of_pending_tuples; j++)
+        {
+            dmin = min(dmin, node->pending_tuples[j][i]);
+            dmax = max(dmax, node->pending_tuples[j][i]);
+        }
+        if (count > 0 && (dmin != node->bounddefiners[i].dmin || dmax != node->bounddefiners[i].dmax))
+        {
+            violations++;
+            break;
+        }
+    }
+
+    bool mirrored = true; // SoA layout: the per-dimension arrays mirror the entries exactly.
+    for (int j = 0; node->entry_mins != NULL && j < count; j++)
+    {
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            int dmin = is_leaf(node) ? node->list_of_tuples[j][i] : node->child_nodes[j]->bounddefiners[i].dmin;
+            int dmax = is_leaf(node) ? node->list_of_tuples[j][i] : node->child_nodes[j]->bounddefiners[i].dmax;
+            mirrored &= node->entry_mins[i * node->entry_stride + j] == dmin && node->entry_maxs[i * node->entry_stride + j] == dmax;
+        }
+    }
+    if (!mirrored)
+        violations++;
+
+    if (rtree->aggregates) // aggregate trees: the aggregate of the node is that of its entries.
+    {
+        struct Aggregate aggregate = node->aggregate;
+        updateAggregate(rtree, node);
+        violations += memcmp(&aggregate, &node->aggregate, sizeof(struct Aggregate)) != 0;
+        node->aggregate = aggregate;
+    }
+
+    if (!is_leaf(node))
+    {
+        for (int j = 0; j < count; j++)
+        {
+            if (node->child_nodes[j]->parent != node)
+                violations++;
+            violations += validateNode(rtree, node->child_nodes[j], depth + 1, leaf_depth);
+        }
+    }
+    return violations;
+}
+
+int validate_rtree(struct Rtree *rtree) // checks entry counts, MBR tightness, parent pointers, leaf depths and aggregates over the whole R-tree. Returns the number of violations found.
+{
+    if (rtree->root == NULL)
+        return 0;
+    return validateNode(rtree, rtree->root, 0, getTreeHeight(rtree->root) - 1) + (rtree->root->parent != NULL);
+}
+
+int runMixedWorkload(struct Rtree *rtree, int num_of_operations) // applies random inserts, deletes and updates to the R-tree, validating it as it goes, and reports any violation or lost tuple. Returns 1 if there was any failed operation, violation or lost tuple.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (rtree->extent_entries) // the workload inserts, deletes and moves points.
+    {
+        printf("Mixed workload: extent trees only take insert_extent, skipped\n");
+        return 0;
+    }
+    if (rtree->root == NULL || num_of_operations <= 0)
+        return 0;
+    struct BoundDefiner everything[numofdimensions];
+    fillWholeSpace(everything, numofdimensions);
+    struct BoundDefiner space[numofdimensions]; // new tuples are drawn from the initial extent of the data.
+    memcpy(space, rtree->root->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+
+    long int num_of_tuples = countTuplesInBounds(rtree, everything); // a copy of every live tuple is kept to pick deletes and updates from.
+    long int capacity = num_of_tuples + num_of_operations;
+    int **found = malloc(sizeof(int *) * (num_of_tuples > 0 ? num_of_tuples : 1));
+    searchRtreeIntoBuffer(rtree, everything, found, num_of_tuples);
+    int *live = malloc(sizeof(int) * numofdimensions * capacity);
+    for (long int t = 0; t < num_of_tuples; t++)
+        memcpy(live + t * numofdimensions, found[t], sizeof(int) * numofdimensions);
+    free(found);
+
+    srand(7);
+    int inserts = 0, deletes = 0, updates = 0, failures = 0, violations = 0;
+    int tuple[numofdimensions];
+    for (int op = 1; op <= num_of_operations; op++)
+    {
+        int kind = (num_of_tuples == 0) ? 0 : rand() % 3;
+        if (kind == 0) // inserts a random tuple.
+        {
+            for (int i = 0; i < numofdimensions; i++)
+                tuple[i] = space[i].dmin + (int)((double)rand() / RAND_MAX * ((double)space[i].dmax - space[i].dmin));
+            insert(rtree, tuple);
+            memcpy(live + num_of_tuples * numofdimensions, tuple, sizeof(tuple));
+            num_of_tuples++;
+            inserts++;
+        }
+        else if (kind == 1) // deletes a random live tuple.
+        {
+            long int t = rand() % num_of_tuples;
+            if (!delete_tuple(rtree, live + t * numofdimensions))
+                failures++;
+            num_of_tuples--;
+            memcpy(live + t * numofdimensions, live + num_of_tuples * numofdimensions, sizeof(tuple));
+            deletes++;
+        }
+        else // moves a random live tuple by a small offset, which often keeps it inside its leaf.
+        {
+            long int t = rand() % num_of_tuples;
+            for (int i = 0; i < numofdimensions; i++)
+            {
+                long long width = (long long)space[i].dmax - space[i].dmin;
+                long long moved = live[t * numofdimensions + i] + (rand() % 201 - 100) * (width / 100000 + 1);
+                tuple[i] = (int)(moved < INT_MIN ? INT_MIN : (moved > INT_MAX ? INT_MAX : moved));
+            }
+            if (!update_tuple(rtree, live + t * numofdimensions, tuple))
+                failures++;
+            memcpy(live + t * numofdimensions, tuple, sizeof(tuple));
+            updates++;
+        }
+        if (op % 1000 == 0 || op == num_of_operations)
+            violations += validate_rtree(rtree);
+    }
+
+    long int num_in_tree = countTuplesInBounds(rtree, everything);
+    printf("Mixed workload: %d inserts, %d deletes, %d updates, %d failed operations, %d invariant violations, %ld tuples expected, %ld found\n",
+           inserts, deletes, updates, failures, violations, num_of_tuples, num_in_tree);
+    free(live);
+    return (failures > 0 || violations > 0 || num_in_tree != num_of_tuples) ? 1 : 0;
+}
+
+double getTimeInSeconds() // returns a monotonic timestamp used by the benchmarks.
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int benchmarkNearestNeighbours(struct Rtree *rtree, int k, int num_of_queries) // compares the best-first search against a brute force scan of every tuple, on random query points within the root MBR. Returns 1 if a query found different distances.
+{
+    if (rtree->root == NULL || k <= 0 || num_of_queries <= 0)
+        return 0;
+    int numofdimensions = rtree->numofdimensions;
+    struct BoundDefiner everything[numofdimensions]; // a window covering the whole space collects every tuple for the brute force scan.
+    fillWholeSpace(everything, numofdimensions);
+    long int num_of_tuples = countTuplesInBounds(rtree, everything);
+    int **all_tuples = malloc(sizeof(int *) * num_of_tuples);
+    searchRtreeIntoBuffer(rtree, everything, all_tuples, num_of_tuples);
+
+    int *points = malloc(sizeof(int) * numofdimensions * num_of_queries);
+    srand(1);
+    for (int q = 0; q < num_of_queries; q++)
+    {
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            Bounds root_bounds = rtree->root->bounddefiners;
+            points[q * numofdimensions + i] = root_bounds[i].dmin + (int)((double)rand() / RAND_MAX * ((double)root_bounds[i].dmax - root_bounds[i].dmin));
+        }
+    }
+
+    int **list_of_tuples = malloc(sizeof(int *) * k);
+    unsigned long long *distances = malloc(sizeof(unsigned long long) * k);
+    unsigned long long *brute_distances = malloc(sizeof(unsigned long long) * k);
+    int **brute_tuples = malloc(sizeof(int *) * k);
+    enum DistanceMetric metrics[2] = {DISTANCE_EUCLIDEAN_SQUARED, DISTANCE_MANHATTAN};
+    const char *metric_names[2] = {"euclidean", "manhattan"};
+    int status = 0;
+    for (int m = 0; m < 2; m++)
+    {
+        int mismatches = 0;
+        double tree_time = 0, brute_time = 0;
+        for (int q = 0; q < num_of_queries; q++)
+        {
+            int *point = points + q * numofdimensions;
+            double start = getTimeInSeconds();
+            int numofresults = nearestNeighbours(rtree, point, k, metrics[m], list_of_tuples, distances);
+            tree_time += getTimeInSeconds() - start;
+
+            start = getTimeInSeconds();
+            int numofbrute = 0;
+            for (long int t = 0; t < num_of_tuples; t++) // an extent is as far as its nearest point, as in the best-first search.
+            {
+                unsigned long long distance = rtree->extent_entries ? getMinDist(numofdimensions, getExtentBounds(all_tuples[t]), point, metrics[m]) : getTupleDistance(numofdimensions, all_tuples[t], point, metrics[m]);
+                offerCandidate(brute_tuples, brute_distances, &numofbrute, k, all_tuples[t], distance);
+            }
+            sortCandidates(brute_tuples, brute_distances, numofbrute);
+            brute_time += getTimeInSeconds() - start;
+
+            if (numofresults != numofbrute || memcmp(distances, brute_distances, sizeof(unsigned long long) * numofresults) != 0) // ties may be broken differently, so only the distances are compared.
+                mismatches++;
+        }
+        printf("kNN %s k=%d over %ld tuples: best-first %.2f us/query, brute force %.2f us/query, speedup %.1fx, %d mismatching queries\n",
+               metric_names[m], k, num_of_tuples, tree_time * 1e6 / num_of_queries, brute_time * 1e6 / num_of_queries, brute_time / tree_time, mismatches);
+        if (mismatches > 0)
+            status = 1;
+    }
+    free(all_tuples);
+    free(points);
+    free(list_of_tuples);
+    free(distances);
+    free(brute_tuples);
+    free(brute_distances);
+    return status;
+}
+
+long int countNodesVisited(int numofdimensions, Bounds bounddefiners, struct Node *node) // counts the nodes a range search over the given bounds visits below and including node.
+{
+    if (!overlaps(numofdimensions, bounddefiners, node->bounddefiners))
+        return 0;
+    long int visited = 1;
+    for (int i = 0; !is_leaf(node) && i < node->num_of_children_or_tuples; i++)
+        visited += countNodesVisited(numofdimensions, bounddefiners, node->child_nodes[i]);
+    return visited;
+}
+
+long int countNodes(struct Node *node) // counts the nodes below and including node.
+{
+    long int count = 1;
+    for (int i = 0; !is_leaf(node) && i < node->num_of_children_or_tuples; i++)
+        count += countNodes(node->child_nodes[i]);
+    return count;
+}
+
+Bounds makeQueryWindows(int *coordinates, int num_of_tuples, int numofdimensions, int num_of_queries) // returns num_of_queries reproducible random windows, each 1% of the data extent per dimension.
+{
+    struct BoundDefiner extent[numofdimensions]; // extent of the data, estimated from a sample of the tuples.
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        extent[i].dmin = INT_MAX;
+        extent[i].dmax = INT_MIN;
+        for (int t = 0; t < num_of_tuples; t += 97)
+        {
+            extent[i].dmin = min(extent[i].dmin, coordinates[(size_t)t * numofdimensions + i]);
+            extent[i].dmax = max(extent[i].dmax, coordinates[(size_t)t * numofdimensions + i]);
+        }
+    }
+    Bounds windows = malloc(sizeof(struct BoundDefiner) * numofdimensions * num_of_queries);
+    srand(1);
+    for (int q = 0; q < num_of_queries; q++)
+    {
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            double width = ((double)extent[i].dmax - extent[i].dmin) / 100;
+            windows[q * numofdimensions + i].dmin = extent[i].dmin + (int)((double)rand() / RAND_MAX * ((double)extent[i].dmax - extent[i].dmin - width));
+            windows[q * numofdimensions + i].dmax = windows[q * numofdimensions + i].dmin + (int)width;
+        }
+    }
+    return windows;
+}
+
+int benchmarkSplitPolicies(const char *filename, int max_entries, int min_entries, int numofdimensions, int num_of_queries) // builds the R-tree from a file with every split and insert policy, reporting insert throughput and the nodes visited by random window queries. Returns 1 if a tree broke an invariant.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    const char *policy_names[3] = {"quadratic", "linear", "rstar"};
+    const char *insert_names[2] = {"guttman", "rstar"};
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries); // the same windows are used for every policy.
+
+    for (int combination = 0; combination < 6; combination++)
+    {
+        int policy = combination / 2, insert_policy = combination % 2;
+        struct Rtree *rtree = new_rtree(max_entries, min_entries, numofdimensions);
+        rtree->split_policy = policy;
+        rtree->insert_policy = insert_policy;
+        double start = getTimeInSeconds();
+        for (int t = 0; t < num_of_tuples; t++)
+            insert(rtree, coordinates + (size_t)t * numofdimensions);
+        double insert_time = getTimeInSeconds() - start;
+
+        long int visited = 0, found = 0;
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            found += countTuplesInBounds(rtree, windows + q * numofdimensions);
+        double query_time = getTimeInSeconds() - start;
+        for (int q = 0; q < num_of_queries; q++)
+            visited += countNodesVisited(numofdimensions, windows + q * numofdimensions, rtree->root);
+
+        int violations = validate_rtree(rtree);
+        printf("split %-9s insert %-7s: %.0f inserts/s, height %d, %ld nodes, %.1f nodes visited/query, %.2f us/query, %.1f results/query, %d invariant violations\n",
+               policy_names[policy], insert_names[insert_policy], num_of_tuples / insert_time, getTreeHeight(rtree->root), countNodes(rtree->root),
+               (double)visited / num_of_queries, query_time * 1e6 / num_of_queries, (double)found / num_of_queries, violations);
+        if (violations > 0)
+            status = 1;
+        free_rtree(rtree);
+    }
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+int benchmarkFanouts(const char *filename, int numofdimensions, enum SplitPolicy split_policy, enum InsertPolicy insert_policy, int num_of_queries) // builds the R-tree from a file for fan-outs from 4 to 256, reporting build time, memory and query latency. Returns 1 if a tree broke an invariant.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+
+    for (int max_entries = 4; max_entries <= 256; max_entries *= 2)
+    {
+        struct Rtree *rtree = new_rtree(max_entries, getDefaultMinEntries(max_entries), numofdimensions);
+        rtree->split_policy = split_policy;
+        rtree->insert_policy = insert_policy;
+        double start = getTimeInSeconds();
+        for (int t = 0; t < num_of_tuples; t++)
+            insert(rtree, coordinates + (size_t)t * numofdimensions);
+        double build_time = getTimeInSeconds() - start;
+
+        long int visited = 0, found = 0;
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            found += countTuplesInBounds(rtree, windows + q * numofdimensions);
+        double query_time = getTimeInSeconds() - start;
+        for (int q = 0; q < num_of_queries; q++)
+            visited += countNodesVisited(numofdimensions, windows + q * numofdimensions, rtree->root);
+
+        long int num_of_nodes = countNodes(rtree->root);
+        double node_memory = (double)num_of_nodes * rtree->node_arena.block_size / 1024;       // bytes of the node blocks in use, in KiB.
+        double tuple_memory = (double)num_of_tuples * numofdimensions * sizeof(int) / 1024; // bytes of the stored coordinates, in KiB.
+        int violations = validate_rtree(rtree);
+        printf("M %3d m %3d: build %.3f s, height %d, %ld nodes, %.0f KiB nodes + %.0f KiB tuples, %.1f nodes visited/query, %.2f us/query, %.1f results/query, %d invariant violations\n",
+               max_entries, rtree->min_entries, build_time, getTreeHeight(rtree->root), num_of_nodes, node_memory, tuple_memory,
+               (double)visited / num_of_queries, query_time * 1e6 / num_of_queries, (double)found / num_of_queries, violations);
+        if (violations > 0)
+            status = 1;
+        free_rtree(rtree);
+    }
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+void benchmarkDimensionKernels(const char *filename, int max_entries, int min_entries, int numofdimensions, int num_of_queries) // compares the generic hot loops against the kernel specialised for the number of dimensions, on insertion and window search. Each figure is the best of 5 rounds.
+{
+    struct Rtree *rtree = new_rtree(max_entries, min_entries, numofdimensions);
+    enum DimensionKernel specialised = rtree->dimension_kernel;
+    free_rtree(rtree);
+    if (specialised == KERNEL_GENERIC)
+    {
+        printf("No specialised kernel for %d dimensions\n", numofdimensions);
+        return;
+    }
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return;
+    }
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+
+    const char *kernel_names[3] = {"generic", "2D", "3D"};
+    enum DimensionKernel kernels[2] = {KERNEL_GENERIC, specialised};
+    double insert_time[2] = {INFINITY, INFINITY}, query_time[2] = {INFINITY, INFINITY};
+    long int found = 0;
+    for (int round = 0; round < 5; round++) // the kernels alternate, so that both see the same machine conditions.
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            rtree = new_rtree(max_entries, min_entries, numofdimensions);
+            rtree->dimension_kernel = kernels[k];
+            double start = getTimeInSeconds();
+            for (int t = 0; t < num_of_tuples; t++)
+                insert(rtree, coordinates + (size_t)t * numofdimensions);
+            insert_time[k] = fmin(insert_time[k], getTimeInSeconds() - start);
+
+            found = 0;
+            start = getTimeInSeconds();
+            for (int q = 0; q < num_of_queries; q++)
+                found += countTuplesInBounds(rtree, windows + q * numofdimensions);
+            query_time[k] = fmin(query_time[k], getTimeInSeconds() - start);
+            free_rtree(rtree);
+        }
+    }
+    for (int k = 0; k < 2; k++)
+        printf("kernel %-7s: %.0f inserts/s, %.3f us/query, %.1f results/query\n", kernel_names[kernels[k]],
+               num_of_tuples / insert_time[k], query_time[k] * 1e6 / num_of_queries, (double)found / num_of_queries);
+    printf("speedup of the %s kernel: %.2fx insert, %.2fx search\n", kernel_names[specialised], insert_time[0] / insert_time[1], query_time[0] / query_time[1]);
+    free(windows);
+    free(coordinates);
+}
+
+int benchmarkNodeLayouts(const char *filename, int numofdimensions, enum SplitPolicy split_policy, enum InsertPolicy insert_policy, int num_of_queries) // compares the pointer and SoA node layouts on insertion and window search for fan-outs from 16 to 64. Each figure is the best of 3 rounds. Returns 1 if a tree broke an invariant or the layouts found different numbers of tuples.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+
+    printf("SoA kernels: %s\n", SIMD_KERNEL_NAME);
+    for (int max_entries = 16; max_entries <= 64; max_entries *= 2)
+    {
+        double insert_time[2] = {INFINITY, INFINITY}, query_time[2] = {INFINITY, INFINITY};
+        long int found[2] = {0, 0};
+        int violations[2] = {0, 0};
+        for (int round = 0; round < 3; round++) // the layouts alternate, so that both see the same machine conditions.
+        {
+            for (int layout = LAYOUT_POINTERS; layout <= LAYOUT_SOA; layout++)
+            {
+                struct Rtree *rtree = new_rtree_with_layout(max_entries, getDefaultMinEntries(max_entries), numofdimensions, layout);
+                rtree->split_policy = split_policy;
+                rtree->insert_policy = insert_policy;
+                double start = getTimeInSeconds();
+                for (int t = 0; t < num_of_tuples; t++)
+                    insert(rtree, coordinates + (size_t)t * numofdimensions);
+                insert_time[layout] = fmin(insert_time[layout], getTimeInSeconds() - start);
+
+                found[layout] = 0;
+                start = getTimeInSeconds();
+                for (int q = 0; q < num_of_queries; q++)
+                    found[layout] += countTuplesInBounds(rtree, windows + q * numofdimensions);
+                query_time[layout] = fmin(query_time[layout], getTimeInSeconds() - start);
+                violations[layout] = validate_rtree(rtree);
+                free_rtree(rtree);
+            }
+        }
+        int total_violations = violations[0] + violations[1] + (found[0] != found[1]);
+        printf("M %2d: pointers %.0f inserts/s %.3f us/query, SoA %.0f inserts/s %.3f us/query, speedup %.2fx insert %.2fx search, %.1f results/query, %d invariant violations\n",
+               max_entries, num_of_tuples / insert_time[0], query_time[0] * 1e6 / num_of_queries, num_of_tuples / insert_time[1], query_time[1] * 1e6 / num_of_queries,
+               insert_time[0] / insert_time[1], query_time[0] / query_time[1], (double)found[1] / num_of_queries, total_violations);
+        if (total_violations > 0)
+            status = 1;
+    }
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+int benchmarkThreads(struct Rtree *rtree, const char *filename, int max_threads) // measures how batches of queries and a single large range query scale from 1 to max_threads worker threads, checking every result against a sequential run. Returns 1 if a result differed from the sequential run.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0 || rtree->root == NULL || max_threads < 1)
+    {
+        free(coordinates);
+        return 0;
+    }
+    const int num_of_range_queries = 100000, num_of_knn_queries = 20000, k = 10, num_of_large_queries = 20;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_range_queries);
+    struct BatchQuery *range_queries = calloc(num_of_range_queries, sizeof(struct BatchQuery));
+    struct BatchQuery *knn_queries = calloc(num_of_knn_queries, sizeof(struct BatchQuery));
+    int **knn_tuples = malloc(sizeof(int *) * k * num_of_knn_queries);
+    unsigned long long *knn_distances = malloc(sizeof(unsigned long long) * k * num_of_knn_queries);
+    long int expected_range_results = 0;
+    unsigned long long expected_knn_distances = 0;
+    for (int q = 0; q < num_of_range_queries; q++) // range queries only count, so that the batch measures the search itself.
+    {
+        range_queries[q].type = BATCH_RANGE;
+        range_queries[q].bounddefiners = windows + q * numofdimensions;
+        expected_range_results += countTuplesInBounds(rtree, range_queries[q].bounddefiners);
+    }
+    for (int q = 0; q < num_of_knn_queries; q++) // the tuples of the file, in order, serve as query points.
+    {
+        knn_queries[q].type = BATCH_KNN;
+        knn_queries[q].point = coordinates + (size_t)(q % num_of_tuples) * numofdimensions;
+        knn_queries[q].k = k;
+        knn_queries[q].metric = DISTANCE_EUCLIDEAN_SQUARED;
+        knn_queries[q].list_of_tuples = knn_tuples + (size_t)q * k;
+        knn_queries[q].distances = knn_distances + (size_t)q * k;
+        int found = nearestNeighbours(rtree, knn_queries[q].point, k, DISTANCE_EUCLIDEAN_SQUARED, knn_queries[q].list_of_tuples, knn_queries[q].distances);
+        expected_knn_distances += knn_queries[q].distances[found - 1];
+    }
+    struct BoundDefiner large_window[numofdimensions]; // the middle half of the root MBR in every dimension.
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        long long extent = (long long)rtree->root->bounddefiners[i].dmax - rtree->root->bounddefiners[i].dmin;
+        large_window[i].dmin = (int)(rtree->root->bounddefiners[i].dmin + extent / 4);
+        large_window[i].dmax = (int)(rtree->root->bounddefiners[i].dmin + 3 * extent / 4);
+    }
+    long int expected_large_results = countTuplesInBounds(rtree, large_window);
+
+    double base_range = 0, base_knn = 0, base_large = 0;
+    int status = 0;
+    for (int num_of_threads = 1; num_of_threads <= max_threads; num_of_threads = (num_of_threads < max_threads && num_of_threads * 2 > max_threads) ? max_threads : num_of_threads * 2)
+    {
+        struct WorkerPool *pool = newWorkerPool(num_of_threads);
+        int mismatches = 0;
+
+        double start = getTimeInSeconds();
+        runQueryBatch(pool, rtree, range_queries, num_of_range_queries);
+        double range_time = getTimeInSeconds() - start;
+        long int range_results = 0;
+        for (int q = 0; q < num_of_range_queries; q++)
+            range_results += range_queries[q].num_of_results;
+        mismatches += (range_results != expected_range_results);
+
+        start = getTimeInSeconds();
+        runQueryBatch(pool, rtree, knn_queries, num_of_knn_queries);
+        double knn_time = getTimeInSeconds() - start;
+        unsigned long long knn_check = 0;
+        for (int q = 0; q < num_of_knn_queries; q++)
+            knn_check += knn_queries[q].distances[knn_queries[q].num_of_results - 1];
+        mismatches += (knn_check != expected_knn_distances);
+
+        start = getTimeInSeconds();
+        for (int r = 0; r < num_of_large_queries; r++)
+        {
+            int **found;
+            mismatches += (parallelSearchRtree(pool, rtree, large_window, &found) != expected_large_results);
+            free(found);
+        }
+        double large_time = (getTimeInSeconds() - start) / num_of_large_queries;
+        freeWorkerPool(pool);
+
+        if (num_of_threads == 1)
+        {
+            base_range = range_time;
+            base_knn = knn_time;
+            base_large = large_time;
+        }
+        printf("threads %2d: range %.0f queries/s (%.2fx), knn %.0f queries/s (%.2fx), large window %ld results in %.2f ms (%.2fx), %d mismatches\n",
+               num_of_threads, num_of_range_queries / range_time, base_range / range_time, num_of_knn_queries / knn_time, base_knn / knn_time,
+               expected_large_results, large_time * 1e3, base_large / large_time, mismatches);
+        if (mismatches > 0)
+            status = 1;
+    }
+    free(knn_tuples);
+    free(knn_distances);
+    free(range_queries);
+    free(knn_queries);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+struct ConcurrentBenchmark // shared state of the threads of benchmarkConcurrentAccess.
+{
+    struct Rtree *rtree;          // concurrent tree being filled and searched.
+    int *coordinates;             // tuples to insert, back to back.
+    int num_of_tuples;            // number of tuples in coordinates.
+    int num_of_writers;           // workers with an index below this insert, the others search.
+    Bounds windows;               // query windows of the readers.
+    int num_of_windows;           // number of windows.
+    long int queries_per_reader;  // queries each reader runs when no writer is running, 0 to run until the writers are done.
+    atomic_long next_tuple;       // index of the next tuple to insert, also the number of inserts started.
+    atomic_long inserted;         // number of inserts completed.
+    atomic_int writers_running;   // writers that have not finished yet.
+    atomic_long queries;          // queries run by all readers.
+    atomic_long violations;       // query results that break the guarantees of concurrentSearch.
+};
+
+struct ConcurrentCheck // visitor context collecting the results of one query of a reader.
+{
+    Bounds bounddefiners;  // window of the query.
+    int numofdimensions;   // number of dimensions of the tuples.
+    int **list_of_tuples;  // tuples found so far.
+    long int num_of_found; // number of tuples found so far.
+    long int capacity;     // capacity of list_of_tuples.
+    bool outside;          // whether a tuple outside the window was reported.
+};
+
+bool collectConcurrentResult(int *tuple, void *context) // SearchVisitor recording a result of a reader query.
+{
+    struct ConcurrentCheck *check = context;
+    if (!checkIfTupleInBounds(check->bounddefiners, tuple, check->numofdimensions))
+        check->outside = true;
+    if (check->num_of_found == check->capacity)
+    {
+        check->capacity *= 2;
+        check->list_of_tuples = realloc(check->list_of_tuples, sizeof(int *) * check->capacity);
+    }
+    check->list_of_tuples[check->num_of_found++] = tuple;
+    return true;
+}
+
+int compareTuplePointers(const void *a, const void *b) // qsort comparator ordering tuples by address, so that a tuple reported twice ends up adjacent.
+{
+    uintptr_t first = (uintptr_t)*(int *const *)a, second = (uintptr_t)*(int *const *)b;
+    return (first > second) - (first < second);
+}
+
+void runConcurrentBenchmarkJob(void *argument, int worker_index) // worker job of benchmarkConcurrentAccess: the first workers insert the tuples, the others search and check what they find.
+{
+    struct ConcurrentBenchmark *benchmark = argument;
+    struct Rtree *rtree = benchmark->rtree;
+    int numofdimensions = rtree->numofdimensions;
+    if (worker_index < benchmark->num_of_writers)
+    {
+        long int i;
+        while ((i = atomic_fetch_add(&benchmark->next_tuple, 1)) < benchmark->num_of_tuples)
+        {
+            insert(rtree, benchmark->coordinates + (size_t)i * numofdimensions);
+            atomic_fetch_add(&benchmark->inserted, 1);
+        }
+        atomic_fetch_sub(&benchmark->writers_running, 1);
+        return;
+    }
+
+    struct BoundDefiner whole_space[numofdimensions];
+    fillWholeSpace(whole_space, numofdimensions);
+    struct ConcurrentCheck check = {NULL, numofdimensions, malloc(sizeof(int *) * 1024), 0, 1024, false};
+    long int num_of_queries = 0, violations = 0;
+    for (long int q = worker_index; benchmark->queries_per_reader > 0 ? num_of_queries < benchmark->queries_per_reader : atomic_load(&benchmark->writers_running) > 0; q++)
+    {
+        bool whole = (q % 1024 == 0); // every 1024th query covers the whole space, so that its count can be checked against the inserts.
+        long int completed = atomic_load(&benchmark->inserted);
+        check.bounddefiners = whole ? whole_space : benchmark->windows + (q % benchmark->num_of_windows) * numofdimensions;
+        check.num_of_found = 0;
+        check.outside = false;
+        searchRtreeWithVisitor(rtree, check.bounddefiners, collectConcurrentResult, &check);
+        long int started = atomic_load(&benchmark->next_tuple);
+        num_of_queries++;
+
+        qsort(check.list_of_tuples, check.num_of_found, sizeof(int *), compareTuplePointers);
+        for (long int i = 1; i < check.num_of_found; i++)
+            violations += (check.list_of_tuples[i] == check.list_of_tuples[i - 1]);
+        violations += check.outside;
+        if (whole) // every insert completed before the query must be found, and nothing that had not started by its end.
+            violations += (check.num_of_found < completed || check.num_of_found > (started < benchmark->num_of_tuples ? started : benchmark->num_of_tuples));
+    }
+    free(check.list_of_tuples);
+    atomic_fetch_add(&benchmark->queries, num_of_queries);
+    atomic_fetch_add(&benchmark->violations, violations);
+}
+
+long int runConcurrentBenchmark(struct ConcurrentBenchmark *benchmark, int num_of_readers, int num_of_writers, long int queries_per_reader, double *elapsed) // runs the readers and writers given on the tree of the benchmark in a pool of their own, and returns the number of queries they ran.
+{
+    struct WorkerPool *pool = newWorkerPool(num_of_readers + num_of_writers);
+    benchmark->num_of_writers = num_of_writers;
+    benchmark->queries_per_reader = queries_per_reader;
+    atomic_store(&benchmark->writers_running, num_of_writers);
+    atomic_store(&benchmark->queries, 0);
+    double start = getTimeInSeconds();
+    runOnWorkerPool(pool, runConcurrentBenchmarkJob, benchmark);
+    *elapsed = getTimeInSeconds() - start;
+    freeWorkerPool(pool);
+    return atomic_load(&benchmark->queries);
+}
+
+int benchmarkConcurrentAccess(const char *filename, int max_entries, int min_entries, int numofdimensions, int num_of_readers, int num_of_writers) // measures insert and query throughput of a concurrent tree with writers alone, readers alone and both at once, checking every query result. Returns 1 if a query result or a final tree was wrong.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0 || num_of_readers < 1 || num_of_writers < 1)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    const int num_of_windows = 10000;
+    const long int queries_per_reader = 20000;
+    struct ConcurrentBenchmark benchmark = {.coordinates = coordinates, .num_of_tuples = num_of_tuples,
+                                           .windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_windows), .num_of_windows = num_of_windows};
+    struct BoundDefiner whole_space[numofdimensions];
+    fillWholeSpace(whole_space, numofdimensions);
+
+    for (int mixed = 0; mixed <= 1; mixed++) // writers alone and then readers alone on the filled tree, followed by both at once on a fresh tree.
+    {
+        benchmark.rtree = new_concurrent_rtree(max_entries, min_entries, numofdimensions);
+        atomic_init(&benchmark.next_tuple, 0);
+        atomic_init(&benchmark.inserted, 0);
+        atomic_init(&benchmark.violations, 0);
+        double insert_time, query_time;
+        if (!mixed)
+        {
+            runConcurrentBenchmark(&benchmark, 0, num_of_writers, 0, &insert_time);
+            long int num_of_queries = runConcurrentBenchmark(&benchmark, num_of_readers, 0, queries_per_reader, &query_time);
+            printf("writers %d alone: %.0f inserts/s, readers %d alone: %.0f queries/s, %ld violations\n", num_of_writers, num_of_tuples / insert_time,
+                   num_of_readers, num_of_queries / query_time, atomic_load(&benchmark.violations));
+        }
+        else
+        {
+            long int num_of_queries = runConcurrentBenchmark(&benchmark, num_of_readers, num_of_writers, 0, &insert_time);
+            printf("writers %d with readers %d: %.0f inserts/s, %.0f queries/s, %ld violations\n", num_of_writers, num_of_readers, num_of_tuples / insert_time,
+                   num_of_queries / insert_time, atomic_load(&benchmark.violations));
+        }
+        long int num_in_tree = countTuplesInBounds(benchmark.rtree, whole_space);
+        int invariant_violations = validate_rtree(benchmark.rtree);
+        printf("  final tree: %ld of %d tuples, %d invariant violations\n", num_in_tree, num_of_tuples, invariant_violations);
+        if (atomic_load(&benchmark.violations) > 0 || num_in_tree != num_of_tuples || invariant_violations > 0)
+            status = 1;
+        free_rtree(benchmark.rtree);
+    }
+    free(benchmark.windows);
+    free(coordinates);
+    return status;
+}
+
+struct TupleChecksum // visitor context of addToTupleChecksum.
+{
+    int numofdimensions;      // number of dimensions of the tuples.
+    unsigned long long total; // sum of the hashes of the tuples seen, independent of the order they come in.
+};
+
+bool addToTupleChecksum(int *tuple, void *context) // SearchVisitor adding the hash of a tuple to a checksum.
+{
+    struct TupleChecksum *checksum = context;
+    unsigned long long hash = 1469598103934665603ULL; // FNV-1a over the coordinates.
+    for (int i = 0; i < checksum->numofdimensions; i++)
+        hash = (hash ^ (unsigned int)tuple[i]) * 1099511628211ULL;
+    checksum->total += hash;
+    return true;
+}
+
+unsigned long long getTreeChecksum(struct Rtree *rtree) // returns a checksum of the tuples of the tree that does not depend on its shape.
+{
+    struct BoundDefiner whole_space[rtree->numofdimensions];
+    fillWholeSpace(whole_space, rtree->numofdimensions);
+    struct TupleChecksum checksum = {rtree->numofdimensions, 0};
+    searchRtreeWithVisitor(rtree, whole_space, addToTupleChecksum, &checksum);
+    return checksum.total;
+}
+
+void printIngestTimings(struct IngestTimings *timings) // prints the time spent in each stage of parallelIngest.
+{
+    printf("read %.3f s, parse %.3f s, partition %.3f s, build %.3f s, stitch %.3f s, total %.3f s",
+           timings->read, timings->parse, timings->partition, timings->build, timings->stitch,
+           timings->read + timings->parse + timings->partition + timings->build + timings->stitch);
+}
+
+int benchmarkIngest(const char *filename, int max_entries, int min_entries, int numofdimensions, enum NodeLayout node_layout, enum BulkLoadMethod method, int max_threads) // compares the sequential bulk load of a file with the parallel ingest pipeline on 1 to max_threads threads, checking that every tree holds the same tuples. Returns 1 if a tree broke an invariant, a pipeline failed or a tree holds different tuples.
+{
+    struct Rtree *rtree = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+    double start = getTimeInSeconds();
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    double read_time = getTimeInSeconds() - start;
+    if (coordinates == NULL)
+    {
+        free_rtree(rtree);
+        return 0;
+    }
+    start = getTimeInSeconds();
+    bulk_load(rtree, coordinates, num_of_tuples, method);
+    double build_time = getTimeInSeconds() - start;
+    free(coordinates);
+    unsigned long long expected_checksum = getTreeChecksum(rtree);
+    int violations = validate_rtree(rtree);
+    printf("sequential: read and parse %.3f s, build %.3f s, total %.3f s, %d tuples, %d invariant violations\n", read_time, build_time, read_time + build_time,
+           num_of_tuples, violations);
+    free_rtree(rtree);
+    int status = (violations > 0);
+
+    for (int num_of_threads = 1; num_of_threads <= max_threads; num_of_threads = (num_of_threads < max_threads && num_of_threads * 2 > max_threads) ? max_threads : num_of_threads * 2)
+    {
+        rtree = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+        struct IngestTimings timings;
+        if (parallelIngest(rtree, filename, method, num_of_threads, &timings) == 0)
+        {
+            violations = validate_rtree(rtree);
+            bool same = (getTreeChecksum(rtree) == expected_checksum);
+            printf("threads %2d: ", num_of_threads);
+            printIngestTimings(&timings);
+            printf(", %d invariant violations, %s tuples\n", violations, same ? "same" : "DIFFERENT");
+            if (violations > 0 || !same)
+                status = 1;
+        }
+        else
+        {
+            status = 1;
+        }
+        free_rtree(rtree);
+    }
+    return status;
+}
+
+int benchmarkBatchInsert(const char *filename, int max_entries, int min_entries, int numofdimensions, enum NodeLayout node_layout, enum SplitPolicy split_policy, int num_of_queries) // inserts the second half of a file into a tree holding the first half, with a loop of insert calls and with insert_batch for batch sizes from 16 to 16384, reporting insert throughput, query latency and checking that every tree holds the same tuples. Returns 1 if a tree broke an invariant or holds different tuples.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples < 2)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+    int num_of_base_tuples = num_of_tuples / 2, num_of_new_tuples = num_of_tuples - num_of_base_tuples;
+    int *new_coordinates = coordinates + (size_t)num_of_base_tuples * numofdimensions;
+    unsigned long long expected_checksum = 0;
+    double loop_time = 0;
+    for (int batch_size = 1; batch_size <= 16384; batch_size = (batch_size == 1) ? 16 : batch_size * 4) // batch size 1 is the loop of insert calls.
+    {
+        struct Rtree *rtree = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+        rtree->split_policy = split_policy;
+        for (int t = 0; t < num_of_base_tuples; t++)
+            insert(rtree, coordinates + (size_t)t * numofdimensions);
+        double start = getTimeInSeconds();
+        if (batch_size == 1)
+        {
+            for (int t = 0; t < num_of_new_tuples; t++)
+                insert(rtree, new_coordinates + (size_t)t * numofdimensions);
+        }
+        else
+        {
+            for (int t = 0; t < num_of_new_tuples; t += batch_size)
+                insert_batch(rtree, new_coordinates + (size_t)t * numofdimensions, (num_of_new_tuples - t < batch_size) ? num_of_new_tuples - t : batch_size);
+        }
+        double insert_time = getTimeInSeconds() - start;
+
+        long int found = 0;
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            found += countTuplesInBounds(rtree, windows + q * numofdimensions);
+        double query_time = getTimeInSeconds() - start;
+        unsigned long long checksum = getTreeChecksum(rtree);
+        if (batch_size == 1)
+        {
+            expected_checksum = checksum;
+            loop_time = insert_time;
+            printf("insert loop:  ");
+        }
+        else
+        {
+            printf("batch %5d: ", batch_size);
+        }
+        int violations = validate_rtree(rtree);
+        printf(" %.0f inserts/s, speedup %.2fx, %.3f us/query, %.1f results/query, %ld nodes, %d invariant violations, %s tuples\n", num_of_new_tuples / insert_time,
+               loop_time / insert_time, query_time * 1e6 / num_of_queries, (double)found / num_of_queries, countNodes(rtree->root), violations, checksum == expected_checksum ? "same" : "DIFFERENT");
+        if (violations > 0 || checksum != expected_checksum)
+            status = 1;
+        free_rtree(rtree);
+    }
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+int countQueryMismatches(struct Rtree *rtree, struct Rtree *reference, Bounds windows, int num_of_queries) // runs every window, and a 10 nearest neighbour query from its lower corner, on both trees. Returns the number of queries whose tuples, or neighbour distances, differ.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int mismatches = 0;
+    int *list_of_tuples[10];
+    unsigned long long distances[10], reference_distances[10];
+    for (int q = 0; q < num_of_queries; q++)
+    {
+        Bounds window = windows + q * numofdimensions;
+        struct TupleChecksum checksum = {numofdimensions, 0}, reference_checksum = {numofdimensions, 0};
+        long int found = searchRtreeWithVisitor(rtree, window, addToTupleChecksum, &checksum);
+        long int reference_found = searchRtreeWithVisitor(reference, window, addToTupleChecksum, &reference_checksum);
+        int point[numofdimensions];
+        for (int i = 0; i < numofdimensions; i++)
+            point[i] = window[i].dmin;
+        int numofresults = nearestNeighbours(rtree, point, 10, DISTANCE_EUCLIDEAN_SQUARED, list_of_tuples, distances);
+        int reference_numofresults = nearestNeighbours(reference, point, 10, DISTANCE_EUCLIDEAN_SQUARED, list_of_tuples, reference_distances);
+        if (found != reference_found || checksum.total != reference_checksum.total || numofresults != reference_numofresults ||
+            memcmp(distances, reference_distances, sizeof(unsigned long long) * numofresults) != 0) // ties may be broken differently, so only the distances are compared.
+            mismatches++;
+    }
+    return mismatches;
+}
+
+int benchmarkBufferedInsert(const char *filename, int max_entries, int min_entries, int numofdimensions, enum NodeLayout node_layout, enum SplitPolicy split_policy, int num_of_queries) // ingests a file with insert calls going straight to the leaves and in buffered mode with buffers of M to 256 M tuples, reporting ingest throughput, query latency with the buffers still full and after flushing them, and checking every query against the unbuffered tree. Returns 1 if a buffered tree broke an invariant or a query disagreed.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+    struct Rtree *reference = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+    reference->split_policy = split_policy;
+    double start = getTimeInSeconds();
+    for (int t = 0; t < num_of_tuples; t++)
+        insert(reference, coordinates + (size_t)t * numofdimensions);
+    double reference_time = getTimeInSeconds() - start;
+    start = getTimeInSeconds();
+    for (int q = 0; q < num_of_queries; q++)
+        countTuplesInBounds(reference, windows + q * numofdimensions);
+    double reference_query_time = getTimeInSeconds() - start;
+    printf("unbuffered:       %.0f inserts/s, %.3f us/query, %ld nodes\n", num_of_tuples / reference_time, reference_query_time * 1e6 / num_of_queries, countNodes(reference->root));
+
+    for (int factor = 1; factor <= 256; factor *= 4)
+    {
+        struct Rtree *rtree = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+        rtree->split_policy = split_policy;
+        set_write_buffer(rtree, factor * max_entries);
+        start = getTimeInSeconds();
+        for (int t = 0; t < num_of_tuples; t++)
+            insert(rtree, coordinates + (size_t)t * numofdimensions);
+        double insert_time = getTimeInSeconds() - start;
+        long int num_of_pending_tuples = rtree->num_of_pending_tuples;
+        int violations = validate_rtree(rtree);
+
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            countTuplesInBounds(rtree, windows + q * numofdimensions);
+        double buffered_query_time = getTimeInSeconds() - start;
+        int mismatches = countQueryMismatches(rtree, reference, windows, num_of_queries);
+
+        start = getTimeInSeconds();
+        flush_buffers(rtree);
+        double flush_time = getTimeInSeconds() - start;
+        violations += validate_rtree(rtree);
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            countTuplesInBounds(rtree, windows + q * numofdimensions);
+        double flushed_query_time = getTimeInSeconds() - start;
+        mismatches += countQueryMismatches(rtree, reference, windows, num_of_queries);
+
+        printf("buffer %3d x M: %.0f inserts/s, speedup %.2fx, %ld pending, %.3f us/query buffered, flush %.3f ms, %.3f us/query flushed, %ld nodes, %d invariant violations, %d mismatching queries\n",
+               factor, num_of_tuples / insert_time, reference_time / insert_time, num_of_pending_tuples, buffered_query_time * 1e6 / num_of_queries, flush_time * 1e3,
+               flushed_query_time * 1e6 / num_of_queries, countNodes(rtree->root), violations, mismatches);
+        if (violations > 0 || mismatches > 0)
+            status = 1;
+        free_rtree(rtree);
+    }
+    free_rtree(reference);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+// Workload benchmarks
+// --bench-workloads runs a fixed suite on generated point sets instead of a data file, so that runs are reproducible and can be
+// compared between releases. Each workload reports its throughput, the median and 99th percentile latency of one operation, and
+// the peak resident set size of the process so far, as one JSON object or CSV row per workload.
+
+enum Distribution // shape of a generated point set.
+{
+    DISTRIBUTION_UNIFORM,  // independent uniform coordinates.
+    DISTRIBUTION_GAUSSIAN, // Gaussian clusters around a few random centres.
+    DISTRIBUTION_SKEWED,   // uniform coordinates raised to a power, crowding the points towards the origin.
+    DISTRIBUTION_LINE,     // points along the main diagonal with a little noise.
+    NUM_OF_DISTRIBUTIONS
+};
+
+const char *distribution_names[NUM_OF_DISTRIBUTIONS] = {"uniform", "gaussian", "skewed", "line"};
+
+#define WORKLOAD_EXTENT 1000000 // generated coordinates lie in [0, WORKLOAD_EXTENT).
+#define WORKLOAD_CLUSTERS 16    // number of clusters of the Gaussian distribution.
+
+enum BenchFormat
+{
+    FORMAT_JSON,
+    FORMAT_CSV
+};
+
+struct WorkloadReport // where and how the results of the workload benchmarks are written.
+{
+    FILE *out;               // stream receiving the results.
+    enum BenchFormat format; // JSON objects or CSV rows.
+    int num_of_records;      // number of results written so far.
+    int num_of_violations;   // invariant violations found in the trees of all results so far.
+};
+
+double nextRandom(unsigned long long *state) // returns a uniform double in [0, 1) from a splitmix64 generator, so that generated sets do not depend on the C library.
+{
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double nextGaussian(unsigned long long *state) // returns a standard normal double, by the Box-Muller transform.
+{
+    double u = nextRandom(state), v = nextRandom(state);
+    return sqrt(-2 * log(1 - u)) * cos(6.283185307179586 * v);
+}
+
+int clampCoordinate(double value) // keeps a generated coordinate inside the extent.
+{
+    if (value < 0)
+        return 0;
+    if (value > WORKLOAD_EXTENT - 1)
+        return WORKLOAD_EXTENT - 1;
+    return (int)value;
+}
+
+int *generateTuples(enum Distribution distribution, int num_of_tuples, int numofdimensions, unsigned long long seed) // returns num_of_tuples tuples of the given distribution stored back to back. The same seed gives the same tuples.
+{
+    int *coordinates = malloc(sizeof(int) * numofdimensions * (size_t)num_of_tuples);
+    unsigned long long state = seed;
+    double centres[WORKLOAD_CLUSTERS][numofdimensions];
+    for (int c = 0; c < WORKLOAD_CLUSTERS; c++)
+        for (int i = 0; i < numofdimensions; i++)
+            centres[c][i] = nextRandom(&state) * WORKLOAD_EXTENT;
+    for (int t = 0; t < num_of_tuples; t++)
+    {
+        int *tuple = coordinates + (size_t)t * numofdimensions;
+        int cluster = (int)(nextRandom(&state) * WORKLOAD_CLUSTERS);
+        double position = nextRandom(&state) * WORKLOAD_EXTENT; // where the tuple lies along the line.
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            switch (distribution)
+            {
+            case DISTRIBUTION_GAUSSIAN:
+                tuple[i] = clampCoordinate(centres[cluster][i] + nextGaussian(&state) * WORKLOAD_EXTENT / 100);
+                break;
+            case DISTRIBUTION_SKEWED:
+                tuple[i] = clampCoordinate(pow(nextRandom(&state), 4) * WORKLOAD_EXTENT);
+                break;
+            case DISTRIBUTION_LINE:
+                tuple[i] = clampCoordinate(position + nextGaussian(&state) * WORKLOAD_EXTENT / 1000);
+                break;
+            default:
+                tuple[i] = clampCoordinate(nextRandom(&state) * WORKLOAD_EXTENT);
+                break;
+            }
+        }
+    }
+    return coordinates;
+}
+
+long int getPeakRssKilobytes() // returns the peak resident set size of the process so far, which only ever grows.
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // bytes on macOS.
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+int compareDoubles(const void *a, const void *b) // qsort comparator for increasing doubles.
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double getPercentile(double *sorted, long int num_of_values, double percentile) // returns the given percentile of sorted values, by the nearest rank.
+{
+    if (num_of_values == 0)
+        return 0;
+    long int rank = (long int)ceil(percentile / 100 * num_of_values);
+    return sorted[(rank > 0 ? rank : 1) - 1];
+}
+
+void writeWorkloadRecord(struct WorkloadReport *report, struct Rtree *rtree, const char *distribution, int num_of_tuples, const char *workload, long int num_of_operations,
+                         double seconds, double *latencies, double results_per_operation) // writes the result of one workload. latencies holds the seconds of each operation, and is sorted here, or is NULL when the workload is one operation.
+{
+    double p50 = seconds, p99 = seconds;
+    if (latencies != NULL)
+    {
+        qsort(latencies, num_of_operations, sizeof(double), compareDoubles);
+        p50 = getPercentile(latencies, num_of_operations, 50);
+        p99 = getPercentile(latencies, num_of_operations, 99);
+    }
+    double throughput = (seconds > 0) ? num_of_operations / seconds : 0;
+    int violations = validate_rtree(rtree);
+    report->num_of_violations += violations;
+    if (report->format == FORMAT_CSV)
+    {
+        if (report->num_of_records == 0)
+            fprintf(report->out, "distribution,tuples,dims,max_entries,workload,operations,seconds,ops_per_sec,p50_us,p99_us,results_per_op,peak_rss_kb,violations\n");
+        fprintf(report->out, "%s,%d,%d,%d,%s,%ld,%.6f,%.1f,%.3f,%.3f,%.2f,%ld,%d\n", distribution, num_of_tuples, rtree->numofdimensions, rtree->max_entries, workload,
+                num_of_operations, seconds, throughput, p50 * 1e6, p99 * 1e6, results_per_operation, getPeakRssKilobytes(), violations);
+    }
+    else
+    {
+        fprintf(report->out, "%s\n  {\"distribution\": \"%s\", \"tuples\": %d, \"dims\": %d, \"max_entries\": %d, \"workload\": \"%s\", \"operations\": %ld, \"seconds\": %.6f, "
+                             "\"ops_per_sec\": %.1f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"results_per_op\": %.2f, \"peak_rss_kb\": %ld, \"violations\": %d}",
+                (report->num_of_records == 0) ? "[" : ",", distribution, num_of_tuples, rtree->numofdimensions, rtree->max_entries, workload, num_of_operations, seconds,
+                throughput, p50 * 1e6, p99 * 1e6, results_per_operation, getPeakRssKilobytes(), violations);
+    }
+    report->num_of_records++;
+}
+
+struct Rtree *newTreeLike(struct Rtree *shape) // creates an empty R-tree with the shape and policies of another.
+{
+    struct Rtree *rtree = new_rtree_with_layout(shape->max_entries, shape->min_entries, shape->numofdimensions, shape->node_layout);
+    rtree->split_policy = shape->split_policy;
+    rtree->insert_policy = shape->insert_policy;
+    rtree->dimension_kernel = shape->dimension_kernel;
+    return rtree;
+}
+
+void runWorkloads(struct WorkloadReport *report, struct Rtree *shape, enum Distribution distribution, int num_of_tuples, int num_of_queries) // runs the build, insert, range query, kNN and delete workloads on one generated point set.
+{
+    int numofdimensions = shape->numofdimensions;
+    const char *name = distribution_names[distribution];
+    int *coordinates = generateTuples(distribution, num_of_tuples, numofdimensions, 42 + distribution);
+    long int num_of_latencies = max(num_of_tuples, num_of_queries);
+    double *latencies = malloc(sizeof(double) * num_of_latencies);
+
+    struct Rtree *rtree = newTreeLike(shape); // build: one STR bulk load of the whole set.
+    double start = getTimeInSeconds();
+    bulk_load(rtree, coordinates, num_of_tuples, BULK_STR);
+    writeWorkloadRecord(report, rtree, name, num_of_tuples, "build_str", num_of_tuples, getTimeInSeconds() - start, NULL, 0);
+    free_rtree(rtree);
+
+    rtree = newTreeLike(shape); // insert: the whole set one tuple at a time, keeping the tree for the workloads below.
+    double total = 0;
+    for (int t = 0; t < num_of_tuples; t++)
+    {
+        start = getTimeInSeconds();
+        insert(rtree, coordinates + (size_t)t * numofdimensions);
+        latencies[t] = getTimeInSeconds() - start;
+        total += latencies[t];
+    }
+    writeWorkloadRecord(report, rtree, name, num_of_tuples, "insert", num_of_tuples, total, latencies, 0);
+
+    double selectivities[3] = {0.0001, 0.001, 0.01}; // fraction of the extent covered by a window.
+    const char *range_names[3] = {"range_0.01pct", "range_0.1pct", "range_1pct"};
+    unsigned long long state = 7;
+    for (int s = 0; s < 3; s++)
+    {
+        double side = pow(selectivities[s], 1.0 / numofdimensions) * WORKLOAD_EXTENT;
+        long int found = 0;
+        total = 0;
+        for (int q = 0; q < num_of_queries; q++)
+        {
+            struct BoundDefiner window[numofdimensions];
+            int *centre = coordinates + (size_t)(nextRandom(&state) * num_of_tuples) * numofdimensions; // windows are centred on tuples, so that skewed sets are queried where their data is.
+            for (int i = 0; i < numofdimensions; i++)
+            {
+                window[i].dmin = centre[i] - (int)(side / 2);
+                window[i].dmax = window[i].dmin + (int)side;
+            }
+            start = getTimeInSeconds();
+            found += countTuplesInBounds(rtree, window);
+            latencies[q] = getTimeInSeconds() - start;
+            total += latencies[q];
+        }
+        writeWorkloadRecord(report, rtree, name, num_of_tuples, range_names[s], num_of_queries, total, latencies, (double)found / num_of_queries);
+    }
+
+    int *list_of_tuples[10];
+    unsigned long long distances[10];
+    total = 0;
+    for (int q = 0; q < num_of_queries; q++)
+    {
+        int *point = coordinates + (size_t)(nextRandom(&state) * num_of_tuples) * numofdimensions;
+        start = getTimeInSeconds();
+        nearestNeighbours(rtree, point, 10, DISTANCE_EUCLIDEAN_SQUARED, list_of_tuples, distances);
+        latencies[q] = getTimeInSeconds() - start;
+        total += latencies[q];
+    }
+    writeWorkloadRecord(report, rtree, name, num_of_tuples, "knn_10", num_of_queries, total, latencies, 10);
+
+    int num_of_deletes = num_of_tuples / 10; // delete: every tenth tuple, spread over the whole set.
+    long int deleted = 0;
+    total = 0;
+    for (int d = 0; d < num_of_deletes; d++)
+    {
+        start = getTimeInSeconds();
+        deleted += delete_tuple(rtree, coordinates + (size_t)d * 10 * numofdimensions);
+        latencies[d] = getTimeInSeconds() - start;
+        total += latencies[d];
+    }
+    writeWorkloadRecord(report, rtree, name, num_of_tuples, "delete", num_of_deletes, total, latencies, num_of_deletes > 0 ? (double)deleted / num_of_deletes : 0);
+
+    free_rtree(rtree);
+    free(latencies);
+    free(coordinates);
+}
+
+int benchmarkWorkloads(struct Rtree *shape, int num_of_tuples, int distribution, enum BenchFormat format, const char *out_filename, int num_of_queries) // runs the workload suite on every distribution, or only on the given one, with trees shaped like shape. Results go to out_filename, or stdout when it is NULL. Returns 1 if the file cannot be written or a tree broke an invariant.
+{
+    struct WorkloadReport report = {stdout, format, 0, 0};
+    if (out_filename != NULL && (report.out = fopen(out_filename, "w")) == NULL)
+    {
+        printf("Error opening %s: %s\n", out_filename, strerror(errno));
+        return 1;
+    }
+    for (int d = 0; d < NUM_OF_DISTRIBUTIONS; d++)
+        if (distribution < 0 || distribution == d)
+            runWorkloads(&report, shape, d, num_of_tuples, num_of_queries);
+    if (format == FORMAT_JSON)
+        fprintf(report.out, report.num_of_records > 0 ? "\n]\n" : "[]\n");
+    if (report.out != stdout)
+        fclose(report.out);
+    return (report.num_of_violations > 0);
+}
+
+// Extent entries
+// set_extent_entries makes the leaves of an empty tree hold rectangles instead of points. Each leaf tuple then points to an extent
+// record in the tuple pool: one BoundDefiner per dimension, the MBR itself, followed by an int payload identifying the object.
+// Insertion chooses the leaf by the least enlargement for the whole MBR, splits run on the MBRs of the records, and searches test
+// them with a SpatialPredicate. Extent trees use the pointer layout and are not concurrent. Records go in with insert_extent, and
+// insert, insert_batch, delete_tuple, update_tuple, the bulk loaders and tree files stay point-only, refusing extent trees.
+
+const char *predicate_names[3] = {"intersects", "contains", "within"};
+
+bool set_extent_entries(struct Rtree *rtree) // makes an empty R-tree hold extents instead of points. Returns false if the tree is not empty, or its layout or mode only handles points.
+{
+    if (rtree->root != NULL || rtree->node_layout != LAYOUT_POINTERS || rtree->concurrent)
+        return false;
+    rtree->extent_entries = true;
+    return true;
+}
+
+int *insert_extent(struct Rtree *rtree, Bounds bounddefiners, int payload) // inserts an extent, whose lower bounds must not exceed its upper bounds, with its payload. The record is copied into the tuple pool of the tree and returned.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int *record = reserveTuples(&rtree->tuple_pool, 1, 2 * numofdimensions + 1);
+    memcpy(record, bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+    record[2 * numofdimensions] = payload;
+    if (rtree->query_cache != NULL)
+        invalidateQueryCache(rtree, bounddefiners);
+    insertStoredTuple(rtree, record);
+    return record;
+}
+
+int read_extents_and_insert(struct Rtree *rtree, const char *filename) // reads extents from a file, one per line as its lower corner followed by its upper corner, and inserts them with their line number among the extents as payload.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_extents;
+    int *corners = read_tuples(filename, 2 * numofdimensions, &num_of_extents);
+    if (corners == NULL)
+        return 1;
+    for (int e = 0; e < num_of_extents; e++)
+    {
+        int *corner = corners + (size_t)e * 2 * numofdimensions;
+        struct BoundDefiner extent[numofdimensions];
+        for (int i = 0; i < numofdimensions; i++) // the corners may be given in any order.
+        {
+            extent[i].dmin = min(corner[i], corner[numofdimensions + i]);
+            extent[i].dmax = max(corner[i], corner[numofdimensions + i]);
+        }
+        insert_extent(rtree, extent, e);
+    }
+    free(corners);
+    return 0;
+}
+
+int *generateExtents(enum Distribution distribution, int num_of_extents, int numofdimensions, unsigned long long seed) // returns num_of_extents extent records centred on generated tuples, with sides of up to 1% of the extent biased towards small ones, stored back to back with their index as payload.
+{
+    int *centres = generateTuples(distribution, num_of_extents, numofdimensions, seed);
+    int *records = malloc(sizeof(int) * (2 * numofdimensions + 1) * (size_t)num_of_extents);
+    unsigned long long state = seed + 1;
+    for (int e = 0; e < num_of_extents; e++)
+    {
+        int *record = records + (size_t)e * (2 * numofdimensions + 1);
+        for (int i = 0; i < numofdimensions; i++)
+        {
+            int half_side = (int)(pow(nextRandom(&state), 3) * WORKLOAD_EXTENT / 200);
+            getExtentBounds(record)[i].dmin = clampCoordinate((double)centres[(size_t)e * numofdimensions + i] - half_side);
+            getExtentBounds(record)[i].dmax = clampCoordinate((double)centres[(size_t)e * numofdimensions + i] + half_side);
+        }
+        record[2 * numofdimensions] = e;
+    }
+    free(centres);
+    return records;
+}
+
+int benchmarkExtents(struct Rtree *shape, int num_of_extents, int distribution, int num_of_queries) // builds an extent tree shaped like shape from generated rectangles, then times intersects, contains and within queries at three window sizes against a scan of every rectangle, checking that both find the same records. Returns 1 if a tree broke an invariant or a query found different records.
+{
+    int numofdimensions = shape->numofdimensions;
+    int record_size = 2 * numofdimensions + 1;
+    int status = 0;
+    for (int d = 0; d < NUM_OF_DISTRIBUTIONS; d++)
+    {
+        if (distribution >= 0 && distribution != d)
+            continue;
+        int *records = generateExtents(d, num_of_extents, numofdimensions, 42 + d);
+        struct Rtree *rtree = new_rtree(shape->max_entries, shape->min_entries, numofdimensions); // extents always use the pointer layout.
+        rtree->split_policy = shape->split_policy;
+        rtree->insert_policy = shape->insert_policy;
+        set_extent_entries(rtree);
+        double start = getTimeInSeconds();
+        for (int e = 0; e < num_of_extents; e++)
+            insert_extent(rtree, getExtentBounds(records + (size_t)e * record_size), e);
+        double build_time = getTimeInSeconds() - start;
+        int violations = validate_rtree(rtree);
+        printf("extents %s: %d rectangles, %.0f inserts/s, %ld nodes, %d invariant violations\n", distribution_names[d], num_of_extents, num_of_extents / build_time,
+               countNodes(rtree->root), violations);
+        if (violations > 0)
+            status = 1;
+
+        double selectivities[3] = {0.0001, 0.001, 0.01}; // fraction of the extent covered by a window.
+        for (int p = PREDICATE_INTERSECTS; p <= PREDICATE_WITHIN; p++)
+        {
+            for (int s = 0; s < 3; s++)
+            {
+                double side = pow(selectivities[s], 1.0 / numofdimensions) * WORKLOAD_EXTENT;
+                if (p == PREDICATE_CONTAINS) // a rectangle only contains windows smaller than itself.
+                    side /= 100;
+                unsigned long long state = 7;
+                double tree_time = 0, scan_time = 0;
+                long int found = 0;
+                int mismatches = 0;
+                for (int q = 0; q < num_of_queries; q++)
+                {
+                    struct BoundDefiner window[numofdimensions];
+                    Bounds centre = getExtentBounds(records + (size_t)(nextRandom(&state) * num_of_extents) * record_size); // windows are centred on rectangles, so that skewed sets are queried where their data is.
+                    for (int i = 0; i < numofdimensions; i++)
+                    {
+                        window[i].dmin = (int)(((long long)centre[i].dmin + centre[i].dmax) / 2 - side / 2);
+                        window[i].dmax = window[i].dmin + (int)side;
+                    }
+                    struct TupleChecksum checksum = {record_size, 0}, scan_checksum = {record_size, 0};
+                    start = getTimeInSeconds();
+                    long int numofresults = searchRtreeWithPredicate(rtree, window, p, addToTupleChecksum, &checksum);
+                    tree_time += getTimeInSeconds() - start;
+                    start = getTimeInSeconds();
+                    long int scan_numofresults = 0;
+                    for (int e = 0; e < num_of_extents; e++)
+                    {
+                        int *record = records + (size_t)e * record_size;
+                        if (matchesPredicate(numofdimensions, window, getExtentBounds(record), p))
+                        {
+                            scan_numofresults++;
+                            addToTupleChecksum(record, &scan_checksum);
+                        }
+                    }
+                    scan_time += getTimeInSeconds() - start;
+                    found += numofresults;
+                    if (numofresults != scan_numofresults || checksum.total != scan_checksum.total)
+                        mismatches++;
+                }
+                printf("  %-10s %8.2g%% window: %.3f us/query, %.3f us/query scanning, speedup %.1fx, %.1f results/query, %d mismatching queries\n", predicate_names[p],
+                       100 * pow(side / WORKLOAD_EXTENT, numofdimensions), tree_time * 1e6 / num_of_queries, scan_time * 1e6 / num_of_queries,
+                       tree_time > 0 ? scan_time / tree_time : 0, (double)found / num_of_queries, mismatches);
+                if (mismatches > 0)
+                    status = 1;
+            }
+        }
+        free_rtree(rtree);
+        free(records);
+    }
+    return status;
+}
+
+// Spatial join
+// spatialJoin finds every pair of a tuple of one tree and a tuple of another whose MBRs lie within a distance of each other along
+// every axis, 0 meaning that they overlap. Both trees are descended together from their roots, a pair of nodes only being opened
+// when their MBRs are within the distance. Inside a pair of nodes, the entries outside the MBR of the other node are dropped, and
+// the rest are paired by a plane sweep along the first axis instead of testing every combination. When one side reaches its leaves
+// first, it stays on its leaf while the other side goes on descending. parallelSpatialJoin first expands the pairs of nodes level by
+// level until there are enough of them to keep every worker busy, then lets the workers claim them one at a time.
+
+typedef bool (*JoinVisitor)(int *tuple, int *tuple2, void *context); // receives each pair found by a spatial join, a tuple of the first tree and one of the second. Returning false stops the join early.
+
+struct NodePair // a node of the first tree and a node of the second whose MBRs are within the join distance.
+{
+    struct Node *node;
+    struct Node *node2;
+};
+
+struct SpatialJoin // state of a spatial join, shared by the workers of a parallel join.
+{
+    int numofdimensions;       // number of dimensions of both trees.
+    int distance;              // largest gap along any axis between the MBRs of a pair.
+    JoinVisitor visitor;       // receives each pair found, may be NULL to only count them.
+    void **contexts;           // context handed to the visitor by each worker.
+    long int *num_of_pairs;    // number of pairs found by each worker.
+    atomic_bool stopped;       // set once a visitor asked to stop.
+    bool collect;              // while the frontier is built: pairs of nodes are appended to the frontier instead of being joined.
+    struct NodePair *frontier; // parallel join: the pairs of nodes shared out among the workers.
+    long int frontier_size;    // number of pairs in the frontier.
+    long int frontier_capacity; // number of pairs the frontier can hold.
+    atomic_long next_pair;     // parallel join: index of the next pair of the frontier not yet claimed by a worker.
+};
+
+struct SweepEntry // an entry of a node taking part in a plane sweep.
+{
+    long long key;   // lower bound of the entry along the first axis, lowered by the join distance on the first tree.
+    int index;       // index of the entry in its node, -1 for a leaf standing for itself.
+    Bounds bounds;   // MBR of the entry.
+};
+
+int compareSweepEntries(const void *a, const void *b) // qsort comparator ordering sweep entries by their key.
+{
+    long long x = ((const struct SweepEntry *)a)->key, y = ((const struct SweepEntry *)b)->key;
+    return (x > y) - (x < y);
+}
+
+bool withinDistance(int numofdimensions, Bounds bounddefiners, Bounds bounddefiners2, int distance) // checks whether two MBRs are no farther apart than the distance along any axis.
+{
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        if ((long long)bounddefiners[i].dmin - distance > bounddefiners2[i].dmax || (long long)bounddefiners[i].dmax + distance < bounddefiners2[i].dmin)
+            return false;
+    }
+    return true;
+}
+
+int gatherSweepEntries(struct Node *node, bool whole, Bounds other_bounds, int distance, bool first, int numofdimensions, Bounds storage, struct SweepEntry *entries) // fills entries with those of the node within the distance of the MBR of the other node, or with the node itself when whole is set, sorted by key. Tuples get their MBR in storage. Returns their number.
+{
+    int count = 0;
+    for (int j = whole ? -1 : 0; j < (whole ? 0 : node->num_of_children_or_tuples); j++)
+    {
+        Bounds bounds = storage + count * numofdimensions;
+        if (j < 0)
+            bounds = node->bounddefiners;
+        else if (!is_leaf(node))
+            bounds = node->child_nodes[j]->bounddefiners;
+        else if (node->extent_entries)
+            bounds = getExtentBounds(node->list_of_tuples[j]);
+        else
+        {
+            for (int i = 0; i < numofdimensions; i++)
+                bounds[i].dmin = bounds[i].dmax = node->list_of_tuples[j][i];
+        }
+        if (!withinDistance(numofdimensions, bounds, other_bounds, distance)) // search space restriction: the entry cannot pair with anything in the other node.
+            continue;
+        entries[count].key = first ? (long long)bounds[0].dmin - distance : bounds[0].dmin;
+        entries[count].index = j;
+        entries[count].bounds = bounds;
+        count++;
+    }
+    qsort(entries, count, sizeof(struct SweepEntry), compareSweepEntries);
+    return count;
+}
+
+void joinNodes(struct SpatialJoin *join, struct Node *node, struct Node *node2, int worker); // joins the subtrees of a pair of nodes whose MBRs are within the join distance.
+
+void joinEntries(struct SpatialJoin *join, struct Node *node, int index, struct Node *node2, int index2, int worker) // handles a pair of entries found by the plane sweep: reports two tuples, or joins two subtrees.
+{
+    if (index >= 0 && index2 >= 0 && is_leaf(node) && is_leaf(node2))
+    {
+        join->num_of_pairs[worker]++;
+        if (join->visitor != NULL && !join->visitor(node->list_of_tuples[index], node2->list_of_tuples[index2], join->contexts[worker]))
+            atomic_store(&join->stopped, true);
+        return;
+    }
+    struct NodePair pair = {(index < 0) ? node : node->child_nodes[index], (index2 < 0) ? node2 : node2->child_nodes[index2]};
+    if (!join->collect)
+    {
+        joinNodes(join, pair.node, pair.node2, worker);
+        return;
+    }
+    if (join->frontier_size == join->frontier_capacity)
+    {
+        join->frontier_capacity = (join->frontier_capacity == 0) ? 64 : join->frontier_capacity * 2;
+        join->frontier = realloc(join->frontier, sizeof(struct NodePair) * join->frontier_capacity);
+    }
+    join->frontier[join->frontier_size++] = pair;
+}
+
+void joinNodes(struct SpatialJoin *join, struct Node *node, struct Node *node2, int worker) // joins the subtrees of a pair of nodes whose MBRs are within the join distance.
+{
+    int numofdimensions = join->numofdimensions;
+    bool whole = is_leaf(node) && !is_leaf(node2), whole2 = is_leaf(node2) && !is_leaf(node); // a leaf facing an internal node waits for the other side to reach its leaves.
+    int count = whole ? 1 : node->num_of_children_or_tuples, count2 = whole2 ? 1 : node2->num_of_children_or_tuples;
+    struct BoundDefiner storage[count * numofdimensions], storage2[count2 * numofdimensions];
+    struct SweepEntry entries[count], entries2[count2];
+    count = gatherSweepEntries(node, whole, node2->bounddefiners, join->distance, true, numofdimensions, storage, entries);
+    count2 = gatherSweepEntries(node2, whole2, node->bounddefiners, join->distance, false, numofdimensions, storage2, entries2);
+
+    int i = 0, i2 = 0;
+    while (i < count && i2 < count2 && !atomic_load(&join->stopped)) // the entry with the lowest key is paired with every entry of the other side starting before it ends along the first axis.
+    {
+        if (entries[i].key <= entries2[i2].key)
+        {
+            long long end = (long long)entries[i].bounds[0].dmax + join->distance;
+            for (int j = i2; j < count2 && entries2[j].key <= end && !atomic_load(&join->stopped); j++)
+            {
+                if (withinDistance(numofdimensions, entries[i].bounds, entries2[j].bounds, join->distance))
+                    joinEntries(join, node, entries[i].index, node2, entries2[j].index, worker);
+            }
+            i++;
+        }
+        else
+        {
+            long long end = entries2[i2].bounds[0].dmax;
+            for (int j = i; j < count && entries[j].key <= end && !atomic_load(&join->stopped); j++)
+            {
+                if (withinDistance(numofdimensions, entries[j].bounds, entries2[i2].bounds, join->distance))
+                    joinEntries(join, node, entries[j].index, node2, entries2[i2].index, worker);
+            }
+            i2++;
+        }
+    }
+}
+
+bool startSpatialJoin(struct SpatialJoin *join, struct Rtree *rtree, struct Rtree *rtree2, int distance, JoinVisitor visitor, void **contexts, int num_of_workers) // prepares a join of the two trees. Returns false when it cannot find any pair.
+{
+    *join = (struct SpatialJoin){rtree->numofdimensions, distance, visitor, contexts, calloc(num_of_workers, sizeof(long int)), false, false, NULL, 0, 0, 0};
+    flush_buffers(rtree); // the join only looks in the leaves.
+    flush_buffers(rtree2);
+    return rtree->root != NULL && rtree2->root != NULL && rtree->numofdimensions == rtree2->numofdimensions && distance >= 0 &&
+           withinDistance(rtree->numofdimensions, rtree->root->bounddefiners, rtree2->root->bounddefiners, distance);
+}
+
+long int finishSpatialJoin(struct SpatialJoin *join, int num_of_workers) // releases the state of a join. Returns the number of pairs it found.
+{
+    long int num_of_pairs = 0;
+    for (int w = 0; w < num_of_workers; w++)
+        num_of_pairs += join->num_of_pairs[w];
+    free(join->num_of_pairs);
+    free(join->frontier);
+    return num_of_pairs;
+}
+
+long int spatialJoin(struct Rtree *rtree, struct Rtree *rtree2, int distance, JoinVisitor visitor, void *context) // streams to the visitor every pair of a tuple of rtree and a tuple of rtree2, points or extents, no farther apart than distance along any axis. Returns the number of pairs found.
+{
+    struct SpatialJoin join;
+    if (startSpatialJoin(&join, rtree, rtree2, distance, visitor, &context, 1))
+        joinNodes(&join, rtree->root, rtree2->root, 0);
+    return finishSpatialJoin(&join, 1);
+}
+
+void runSpatialJoinJob(void *context, int worker) // worker pool job claiming the pairs of nodes of the frontier one at a time.
+{
+    struct SpatialJoin *join = context;
+    for (long int p = atomic_fetch_add(&join->next_pair, 1); p < join->frontier_size && !atomic_load(&join->stopped); p = atomic_fetch_add(&join->next_pair, 1))
+        joinNodes(join, join->frontier[p].node, join->frontier[p].node2, worker);
+}
+
+long int parallelSpatialJoin(struct WorkerPool *pool, struct Rtree *rtree, struct Rtree *rtree2, int distance, JoinVisitor visitor, void **contexts) // spatialJoin spread over the workers of the pool. The visitor runs on every worker at once, given contexts[w] on worker w. Returns the number of pairs found.
+{
+    int num_of_workers = pool->num_of_threads;
+    struct SpatialJoin join;
+    if (!startSpatialJoin(&join, rtree, rtree2, distance, visitor, contexts, num_of_workers))
+        return finishSpatialJoin(&join, num_of_workers);
+
+    join.collect = true; // expands the frontier a level at a time until every worker gets several pairs, or only pairs of leaves remain.
+    joinEntries(&join, rtree->root, -1, rtree2->root, -1, 0);
+    bool expandable = true;
+    while (expandable && join.frontier_size < 8 * num_of_workers)
+    {
+        struct NodePair *pairs = join.frontier;
+        long int num_of_pairs = join.frontier_size;
+        join.frontier = NULL;
+        join.frontier_size = join.frontier_capacity = 0;
+        expandable = false;
+        for (long int p = 0; p < num_of_pairs; p++)
+        {
+            if (is_leaf(pairs[p].node) && is_leaf(pairs[p].node2))
+            {
+                joinEntries(&join, pairs[p].node, -1, pairs[p].node2, -1, 0);
+                continue;
+            }
+            joinNodes(&join, pairs[p].node, pairs[p].node2, 0);
+            expandable = true;
+        }
+        free(pairs);
+    }
+    join.collect = false;
+    runOnWorkerPool(pool, runSpatialJoinJob, &join);
+    return finishSpatialJoin(&join, num_of_workers);
+}
+
+bool addToJoinChecksum(int *tuple, int *tuple2, void *context) // JoinVisitor adding the hash of a pair to a checksum of the tuples of both trees.
+{
+    struct TupleChecksum *checksum = context, first = {checksum->numofdimensions, 0}, second = {checksum->numofdimensions, 0};
+    addToTupleChecksum(tuple, &first);
+    addToTupleChecksum(tuple2, &second);
+    checksum->total += first.total * 1099511628211ULL + second.total;
+    return true;
+}
+
+struct NestedLoopProbe // visitor context of the index nested loop join of benchmarkSpatialJoin.
+{
+    int *tuple;                      // tuple of the first tree being probed.
+    struct TupleChecksum *checksum;  // checksum of the pairs found.
+};
+
+bool addProbeToJoinChecksum(int *tuple2, void *context) // SearchVisitor adding each pair of the probing tuple with a tuple found to the checksum.
+{
+    struct NestedLoopProbe *probe = context;
+    return addToJoinChecksum(probe->tuple, tuple2, probe->checksum);
+}
+
+int benchmarkSpatialJoin(struct Rtree *shape, int num_of_extents, int distribution, int max_threads) // joins two trees of generated rectangles shaped like shape at three distances, with an index nested loop probing the second tree once per rectangle of the first, with spatialJoin, and with parallelSpatialJoin on 1 to max_threads threads, checking that all of them find the same pairs. Returns 1 if a join found different pairs.
+{
+    int numofdimensions = shape->numofdimensions;
+    int record_size = 2 * numofdimensions + 1;
+    int distances[3] = {0, WORKLOAD_EXTENT / 1000, WORKLOAD_EXTENT / 100};
+    int status = 0;
+    for (int d = 0; d < NUM_OF_DISTRIBUTIONS; d++)
+    {
+        if (distribution >= 0 && distribution != d)
+            continue;
+        struct Rtree *trees[2];
+        int *records[2];
+        for (int t = 0; t < 2; t++)
+        {
+            records[t] = generateExtents(d, num_of_extents, numofdimensions, 42 + d + 100 * t);
+            trees[t] = new_rtree(shape->max_entries, shape->min_entries, numofdimensions);
+            trees[t]->split_policy = shape->split_policy;
+            trees[t]->insert_policy = shape->insert_policy;
+            set_extent_entries(trees[t]);
+            for (int e = 0; e < num_of_extents; e++)
+                insert_extent(trees[t], getExtentBounds(records[t] + (size_t)e * record_size), e);
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            struct TupleChecksum reference_checksum = {record_size, 0};
+            double start = getTimeInSeconds();
+            long int reference_pairs = 0;
+            for (int e = 0; e < num_of_extents; e++) // index nested loop: one window query per rectangle of the first tree.
+            {
+                int *record = records[0] + (size_t)e * record_size;
+                struct BoundDefiner window[numofdimensions];
+                for (int i = 0; i < numofdimensions; i++)
+                {
+                    window[i].dmin = getExtentBounds(record)[i].dmin - distances[k];
+                    window[i].dmax = getExtentBounds(record)[i].dmax + distances[k];
+                }
+                struct NestedLoopProbe probe = {record, &reference_checksum};
+                reference_pairs += searchRtreeWithPredicate(trees[1], window, PREDICATE_INTERSECTS, addProbeToJoinChecksum, &probe);
+            }
+            double nested_time = getTimeInSeconds() - start;
+
+            struct TupleChecksum checksum = {record_size, 0};
+            start = getTimeInSeconds();
+            long int num_of_pairs = spatialJoin(trees[0], trees[1], distances[k], addToJoinChecksum, &checksum);
+            double join_time = getTimeInSeconds() - start;
+            bool same = (num_of_pairs == reference_pairs && checksum.total == reference_checksum.total);
+            printf("join %s, %d x %d rectangles, distance %d: %ld pairs, nested loop %.3f ms, synchronised traversal %.3f ms, speedup %.2fx, %s pairs\n", distribution_names[d],
+                   num_of_extents, num_of_extents, distances[k], num_of_pairs, nested_time * 1e3, join_time * 1e3, nested_time / join_time, same ? "same" : "DIFFERENT");
+            if (!same)
+                status = 1;
+
+            for (int num_of_threads = 1; num_of_threads <= max_threads; num_of_threads *= 2)
+            {
+                struct WorkerPool *pool = newWorkerPool(num_of_threads);
+                struct TupleChecksum checksums[num_of_threads];
+                void *contexts[num_of_threads];
+                for (int w = 0; w < num_of_threads; w++)
+                {
+                    checksums[w] = (struct TupleChecksum){record_size, 0};
+                    contexts[w] = &checksums[w];
+                }
+                start = getTimeInSeconds();
+                long int parallel_pairs = parallelSpatialJoin(pool, trees[0], trees[1], distances[k], addToJoinChecksum, contexts);
+                double parallel_time = getTimeInSeconds() - start;
+                unsigned long long total = 0;
+                for (int w = 0; w < num_of_threads; w++)
+                    total += checksums[w].total;
+                same = (parallel_pairs == reference_pairs && total == reference_checksum.total);
+                printf("  %2d threads: %.3f ms, speedup %.2fx over one sequential join, %s pairs\n", num_of_threads, parallel_time * 1e3, join_time / parallel_time,
+                       same ? "same" : "DIFFERENT");
+                if (!same)
+                    status = 1;
+                freeWorkerPool(pool);
+            }
+        }
+        for (int t = 0; t < 2; t++)
+        {
+            free_rtree(trees[t]);
+            free(records[t]);
+        }
+    }
+    return status;
+}
+
+// Compact trees
+// compactRtree freezes a point tree into a read-only copy whose nodes hold no pointers and no full MBRs. The nodes are stored in
+// breadth-first order, so the children of a node, and the tuples of a leaf, are consecutive and found from one index. The MBR of
+// every node but the root is quantised to 8 or 16 bits per bound against the MBR of its parent, as the parent's search sees it:
+// lower bounds are rounded down and upper bounds up, so a quantised MBR always contains the exact one. A search may then open a
+// few nodes the exact MBRs would have pruned, but it never misses a tuple, since the tuples themselves keep full coordinates.
+
+struct CompactNode // a node of a compact tree.
+{
+    int first; // index of the first child in the nodes of the compact tree, or of the first tuple of a leaf in its tuples.
+    int count; // number of children, or of tuples.
+};
+
+struct CompactRtree // read-only copy of a point tree with quantised MBRs.
+{
+    int numofdimensions;        // number of dimensions of the tuples.
+    int bits;                   // width of a quantised bound, 8 or 16.
+    int height;                 // number of levels, the nodes of the last one being leaves.
+    long int num_of_nodes;      // number of nodes.
+    long int num_of_tuples;     // number of tuples.
+    struct BoundDefiner *root_bounds; // exact MBR of the root.
+    struct CompactNode *nodes;  // the nodes in breadth-first order.
+    void *quantised_bounds;     // for each node, 2 * numofdimensions bounds of bits bits each: the lower and upper bound of each dimension. Those of the root are unused.
+    int *tuples;                // coordinates of the tuples, leaf after leaf.
+};
+
+ALWAYS_INLINE void dequantiseBoundsBody(const void *quantised_bounds, int bits, int numofdimensions, Bounds parent_bounds, Bounds bounddefiners) // loop body of dequantiseBounds, with the width of the bounds known at compile time in each caller, so that the divisions become multiplications.
+{
+    long long cells = (1LL << bits) - 1;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        long long width = (long long)parent_bounds[i].dmax - parent_bounds[i].dmin;
+        long long lower = (bits == 8) ? ((const uint8_t *)quantised_bounds)[2 * i] : ((const uint16_t *)quantised_bounds)[2 * i];
+        long long upper = (bits == 8) ? ((const uint8_t *)quantised_bounds)[2 * i + 1] : ((const uint16_t *)quantised_bounds)[2 * i + 1];
+        bounddefiners[i].dmin = (int)(parent_bounds[i].dmin + lower * width / cells);
+        bounddefiners[i].dmax = (int)(parent_bounds[i].dmin + (upper * width + cells - 1) / cells);
+    }
+}
+
+void dequantiseBounds(struct CompactRtree *compact, long int index, Bounds parent_bounds, Bounds bounddefiners) // rebuilds the MBR of a node, as wide or wider than its exact MBR, from its quantised bounds and the MBR rebuilt for its parent.
+{
+    int numofdimensions = compact->numofdimensions;
+    if (compact->bits == 8)
+        dequantiseBoundsBody((uint8_t *)compact->quantised_bounds + index * 2 * numofdimensions, 8, numofdimensions, parent_bounds, bounddefiners);
+    else
+        dequantiseBoundsBody((uint16_t *)compact->quantised_bounds + index * 2 * numofdimensions, 16, numofdimensions, parent_bounds, bounddefiners);
+}
+
+void quantiseBounds(struct CompactRtree *compact, long int index, Bounds parent_bounds, Bounds bounddefiners) // stores the MBR of a node quantised against the MBR rebuilt for its parent, rounding outwards.
+{
+    long long cells = (1LL << compact->bits) - 1;
+    for (int i = 0; i < compact->numofdimensions; i++)
+    {
+        long long width = (long long)parent_bounds[i].dmax - parent_bounds[i].dmin;
+        unsigned int lower = 0, upper = 0;
+        if (width > 0)
+        {
+            lower = (unsigned int)(((long long)bounddefiners[i].dmin - parent_bounds[i].dmin) * cells / width);
+            upper = (unsigned int)((((long long)bounddefiners[i].dmax - parent_bounds[i].dmin) * cells + width - 1) / width);
+        }
+        long int offset = index * 2 * compact->numofdimensions + 2 * i;
+        if (compact->bits == 8)
+        {
+            ((uint8_t *)compact->quantised_bounds)[offset] = lower;
+            ((uint8_t *)compact->quantised_bounds)[offset + 1] = upper;
+        }
+        else
+        {
+            ((uint16_t *)compact->quantised_bounds)[offset] = lower;
+            ((uint16_t *)compact->quantised_bounds)[offset + 1] = upper;
+        }
+    }
+}
+
+struct CompactRtree *compactRtree(struct Rtree *rtree, int bits) // builds a compact copy of a point tree with bounds of 8 or 16 bits. Returns NULL for an extent tree or another width.
+{
+    if (rtree->extent_entries || (bits != 8 && bits != 16))
+        return NULL;
+    flush_buffers(rtree); // the copy only holds tuples in its leaves.
+    int numofdimensions = rtree->numofdimensions;
+    struct CompactRtree *compact = malloc(sizeof(struct CompactRtree));
+    *compact = (struct CompactRtree){numofdimensions, bits, 0, 0, 0, malloc(sizeof(struct BoundDefiner) * numofdimensions), NULL, NULL, NULL};
+    if (rtree->root == NULL)
+        return compact;
+
+    long int capacity = 1024;
+    struct Node **order = malloc(sizeof(struct Node *) * capacity); // the nodes in breadth-first order, as in a tree file.
+    order[compact->num_of_nodes++] = rtree->root;
+    for (long int i = 0; i < compact->num_of_nodes; i++)
+    {
+        struct Node *node = order[i];
+        if (is_leaf(node))
+        {
+            compact->num_of_tuples += node->num_of_children_or_tuples;
+            continue;
+        }
+        if (compact->num_of_nodes + node->num_of_children_or_tuples > capacity)
+        {
+            capacity = 2 * (compact->num_of_nodes + node->num_of_children_or_tuples);
+            order = realloc(order, sizeof(struct Node *) * capacity);
+        }
+        for (int j = 0; j < node->num_of_children_or_tuples; j++)
+            order[compact->num_of_nodes++] = node->child_nodes[j];
+    }
+
+    compact->height = getTreeHeight(rtree->root);
+    memcpy(compact->root_bounds, rtree->root->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+    compact->nodes = malloc(sizeof(struct CompactNode) * compact->num_of_nodes);
+    compact->quantised_bounds = calloc(compact->num_of_nodes * 2 * numofdimensions, bits / 8);
+    compact->tuples = malloc(sizeof(int) * numofdimensions * (size_t)compact->num_of_tuples);
+    Bounds rebuilt = malloc(sizeof(struct BoundDefiner) * numofdimensions * compact->num_of_nodes); // the MBR each node gets back in a search, against which its children are quantised.
+    memcpy(rebuilt, compact->root_bounds, sizeof(struct BoundDefiner) * numofdimensions);
+    long int next_child = 1, next_tuple = 0;
+    for (long int i = 0; i < compact->num_of_nodes; i++)
+    {
+        struct Node *node = order[i];
+        compact->nodes[i].count = node->num_of_children_or_tuples;
+        if (is_leaf(node))
+        {
+            compact->nodes[i].first = next_tuple;
+            for (int j = 0; j < node->num_of_children_or_tuples; j++)
+                memcpy(compact->tuples + (size_t)next_tuple++ * numofdimensions, node->list_of_tuples[j], sizeof(int) * numofdimensions);
+            continue;
+        }
+        compact->nodes[i].first = next_child;
+        for (int j = 0; j < node->num_of_children_or_tuples; j++, next_child++)
+        {
+            quantiseBounds(compact, next_child, rebuilt + i * numofdimensions, node->child_nodes[j]->bounddefiners);
+            dequantiseBounds(compact, next_child, rebuilt + i * numofdimensions, rebuilt + next_child * numofdimensions);
+        }
+    }
+    free(rebuilt);
+    free(order);
+    return compact;
+}
+
+void freeCompactRtree(struct CompactRtree *compact) // releases a compact tree.
+{
+    free(compact->root_bounds);
+    free(compact->nodes);
+    free(compact->quantised_bounds);
+    free(compact->tuples);
+    free(compact);
+}
+
+size_t getCompactRtreeBytes(struct CompactRtree *compact) // returns the memory held by a compact tree, tuples included.
+{
+    return sizeof(struct CompactRtree) + sizeof(struct BoundDefiner) * compact->numofdimensions + compact->num_of_nodes * (sizeof(struct CompactNode) + 2 * compact->numofdimensions * compact->bits / 8) +
+           sizeof(int) * compact->numofdimensions * (size_t)compact->num_of_tuples;
+}
+
+bool searchCompactNode(struct CompactRtree *compact, long int index, Bounds bounds, int level, Bounds bounddefiners, SearchVisitor visitor, void *context, long int *numofresults, long int *nodes_visited) // searches the subtree of a node whose rebuilt MBR overlaps the window. Returns false once the visitor asked to stop.
+{
+    int numofdimensions = compact->numofdimensions;
+    struct CompactNode *node = &compact->nodes[index];
+    (*nodes_visited)++;
+    if (level == compact->height - 1)
+    {
+        for (int j = 0; j < node->count; j++)
+        {
+            int *tuple = compact->tuples + (size_t)(node->first + j) * numofdimensions;
+            if (checkIfTupleInBounds(bounddefiners, tuple, numofdimensions))
+            {
+                (*numofresults)++;
+                if (visitor != NULL && !visitor(tuple, context))
+                    return false;
+            }
+        }
+        return true;
+    }
+    struct BoundDefiner child_bounds[numofdimensions];
+    for (int j = 0; j < node->count; j++)
+    {
+        dequantiseBounds(compact, node->first + j, bounds, child_bounds);
+        if (overlaps(numofdimensions, bounddefiners, child_bounds) &&
+            !searchCompactNode(compact, node->first + j, child_bounds, level + 1, bounddefiners, visitor, context, numofresults, nodes_visited))
+            return false;
+    }
+    return true;
+}
+
+long int searchCompactRtree(struct CompactRtree *compact, Bounds bounddefiners, SearchVisitor visitor, void *context, long int *nodes_visited) // streams every tuple of the compact tree in the given bounds to the visitor, adding the nodes opened to nodes_visited, which may be NULL. Returns the number of tuples found.
+{
+    long int numofresults = 0, visited = 0;
+    if (compact->num_of_nodes > 0 && overlaps(compact->numofdimensions, bounddefiners, compact->root_bounds))
+        searchCompactNode(compact, 0, compact->root_bounds, 0, bounddefiners, visitor, context, &numofresults, &visited);
+    if (nodes_visited != NULL)
+        *nodes_visited += visited;
+    return numofresults;
+}
+
+int benchmarkCompactRtree(struct Rtree *rtree, int num_of_queries) // compares the memory per point, query latency and nodes visited of the tree with those of its compact copies at 16 and 8 bits, checking that every window finds the same tuples. Returns 1 if a window found different tuples.
+{
+    int numofdimensions = rtree->numofdimensions;
+    struct CompactRtree *compacts[2] = {compactRtree(rtree, 16), compactRtree(rtree, 8)};
+    if (compacts[0] == NULL || compacts[0]->num_of_tuples == 0)
+    {
+        printf("Compact trees need a tree of points\n");
+        for (int c = 0; c < 2; c++)
+            if (compacts[c] != NULL)
+                freeCompactRtree(compacts[c]);
+        return 0;
+    }
+    long int num_of_tuples = compacts[0]->num_of_tuples;
+    Bounds windows = makeQueryWindows(compacts[0]->tuples, num_of_tuples, numofdimensions, num_of_queries);
+    long int num_of_nodes = countNodes(rtree->root);
+    size_t tuple_bytes = sizeof(int) * numofdimensions * (size_t)num_of_tuples;
+    size_t tree_bytes = num_of_nodes * rtree->node_arena.block_size + tuple_bytes;
+    double start = getTimeInSeconds();
+    long int nodes_visited = 0;
+    for (int q = 0; q < num_of_queries; q++)
+    {
+        countTuplesInBounds(rtree, windows + q * numofdimensions);
+    }
+    double tree_time = getTimeInSeconds() - start;
+    for (int q = 0; q < num_of_queries; q++)
+        nodes_visited += countNodesVisited(numofdimensions, windows + q * numofdimensions, rtree->root);
+    printf("pointer nodes:   %.1f bytes/point, %.1f of them for the nodes, %.3f us/query, %.1f nodes visited/query\n", (double)tree_bytes / num_of_tuples,
+           (double)(tree_bytes - tuple_bytes) / num_of_tuples, tree_time * 1e6 / num_of_queries, (double)nodes_visited / num_of_queries);
+
+    int status = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        struct CompactRtree *compact = compacts[c];
+        int mismatches = 0;
+        long int compact_nodes_visited = 0;
+        for (int q = 0; q < num_of_queries; q++) // compares the count and an order-independent checksum of the tuples found.
+        {
+            struct TupleChecksum expected = {numofdimensions, 0}, found = {numofdimensions, 0};
+            long int num_expected = searchRtreeWithVisitor(rtree, windows + q * numofdimensions, addToTupleChecksum, &expected);
+            long int num_found = searchCompactRtree(compact, windows + q * numofdimensions, addToTupleChecksum, &found, &compact_nodes_visited);
+            mismatches += (num_found != num_expected || found.total != expected.total);
+        }
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            searchCompactRtree(compact, windows + q * numofdimensions, NULL, NULL, NULL);
+        double compact_time = getTimeInSeconds() - start;
+        size_t compact_bytes = getCompactRtreeBytes(compact);
+        printf("compact %2d-bit:  %.1f bytes/point, %.1f of them for the nodes, %.3f us/query, %.1f nodes visited/query (%+.1f%%), %d mismatching queries\n", compact->bits,
+               (double)compact_bytes / num_of_tuples, (double)(compact_bytes - tuple_bytes) / num_of_tuples, compact_time * 1e6 / num_of_queries,
+               (double)compact_nodes_visited / num_of_queries, 100.0 * (compact_nodes_visited - nodes_visited) / (nodes_visited > 0 ? nodes_visited : 1), mismatches);
+        if (mismatches > 0)
+            status = 1;
+        freeCompactRtree(compact);
+    }
+    free(windows);
+    return status;
+}
+
+// Aggregate trees
+// With set_aggregates, every node keeps the aggregate of its subtree: the number of tuples below it and, if a value is chosen,
+// the sum, minimum and maximum of that value, one int of each stored tuple (a coordinate of a point, or the payload of an
+// extent). insert(), adjust_tree() and the splits recompute the aggregate of every node whose entries changed, from the
+// aggregates of its entries, on the way back up, and deletes, updates, reinsertions and bulk loads do the same for the nodes
+// they touch. aggregateInBounds then answers COUNT, SUM, MIN and MAX over a window without listing a tuple: a child whose MBR
+// lies inside the window contributes its aggregate whole, so only the nodes cut by the border of the window are descended, and
+// the cost no longer grows with the number of tuples in the window. Buffered insertion is bypassed while aggregates are kept.
+
+bool set_aggregates(struct Rtree *rtree, int value_index) // makes every node keep the aggregate of its subtree, of the int at value_index in each stored tuple, or only the count if value_index is -1. Returns false for a concurrent tree or an index outside the tuples.
+{
+    int tuple_width = rtree->extent_entries ? 2 * rtree->numofdimensions + 1 : rtree->numofdimensions;
+    if (rtree->concurrent || value_index < -1 || value_index >= tuple_width) // the latches do not cover the aggregates of the nodes.
+        return false;
+    flush_buffers(rtree); // the tuples waiting in a buffer are not in the aggregate of any leaf.
+    rtree->aggregates = true;
+    rtree->aggregate_value = value_index;
+    refreshAggregates(rtree, rtree->root);
+    return true;
+}
+
+void aggregateNode(struct Rtree *rtree, Bounds bounddefiners, struct Node *node, struct Aggregate *aggregate, long int *nodes_visited) // adds the tuples of the subtree of a node overlapping the window to the aggregate, taking whole the aggregates of the children inside it.
+{
+    int numofdimensions = rtree->numofdimensions;
+    (*nodes_visited)++;
+    for (int i = 0; i < node->num_of_children_or_tuples; i++)
+    {
+        if (is_leaf(node))
+        {
+            if (entryMatchesPredicate(node, node->list_of_tuples[i], numofdimensions, bounddefiners, PREDICATE_INTERSECTS))
+                addTupleToAggregate(rtree, aggregate, node->list_of_tuples[i]);
+        }
+        else if (matchesPredicate(numofdimensions, bounddefiners, node->child_nodes[i]->bounddefiners, PREDICATE_WITHIN)) // every tuple of the child intersects the window.
+            addToAggregate(aggregate, &node->child_nodes[i]->aggregate);
+        else if (overlaps(numofdimensions, bounddefiners, node->child_nodes[i]->bounddefiners))
+            aggregateNode(rtree, bounddefiners, node->child_nodes[i], aggregate, nodes_visited);
+    }
+}
+
+struct Aggregate aggregateInBounds(struct Rtree *rtree, Bounds bounddefiners, long int *nodes_visited) // aggregate trees: returns the aggregate of the tuples in the given bounds, or of the extents intersecting them, adding the nodes read to nodes_visited, which may be NULL.
+{
+    struct Aggregate aggregate = {0, 0, INT_MAX, INT_MIN};
+    long int visited = 0;
+    if (rtree->root == NULL || !rtree->aggregates)
+        return aggregate;
+    if (matchesPredicate(rtree->numofdimensions, bounddefiners, rtree->root->bounddefiners, PREDICATE_WITHIN))
+        aggregate = rtree->root->aggregate;
+    else if (overlaps(rtree->numofdimensions, bounddefiners, rtree->root->bounddefiners))
+        aggregateNode(rtree, bounddefiners, rtree->root, &aggregate, &visited);
+    if (nodes_visited != NULL)
+        *nodes_visited += visited;
+    return aggregate;
+}
+
+void printAggregate(struct Rtree *rtree, struct Aggregate *aggregate) // prints an aggregate, with its value statistics if the tree keeps a value.
+{
+    printf("count %ld", aggregate->count);
+    if (rtree->aggregate_value >= 0 && aggregate->count > 0)
+        printf(", sum %lld, min %d, max %d", aggregate->sum, aggregate->min, aggregate->max);
+    printf("\n");
+}
+
+struct AggregateProbe // context of addToAggregateVisitor.
+{
+    struct Rtree *rtree;        // tree whose aggregated value is read.
+    struct Aggregate aggregate; // aggregate of the tuples visited so far.
+};
+
+bool addToAggregateVisitor(int *tuple, void *context) // SearchVisitor adding a tuple to an aggregate.
+{
+    struct AggregateProbe *probe = context;
+    addTupleToAggregate(probe->rtree, &probe->aggregate, tuple);
+    return true;
+}
+
+int benchmarkAggregates(struct Rtree *rtree, int num_of_queries) // times COUNT and SUM over windows of three sizes with the node aggregates against counting and listing the tuples, checking that both agree, and reports what keeping the aggregates costs inserts. Returns 1 if a tree broke an invariant or an aggregate disagreed with the tuples.
+{
+    int numofdimensions = rtree->numofdimensions;
+    if (rtree->root == NULL || rtree->extent_entries)
+    {
+        printf("The aggregate benchmark needs a tree of points\n");
+        return 0;
+    }
+    bool kept = rtree->aggregates; // whether the aggregates were kept since the tree was loaded.
+    double start = getTimeInSeconds();
+    if (!kept && !set_aggregates(rtree, 0)) // without a value chosen, the first coordinate is summed.
+    {
+        printf("Aggregates cannot be kept by a concurrent tree\n");
+        return 0;
+    }
+    double refresh_time = getTimeInSeconds() - start;
+    struct BoundDefiner everything[numofdimensions];
+    fillWholeSpace(everything, numofdimensions);
+    long int num_of_tuples = rtree->root->aggregate.count;
+    int **found = malloc(sizeof(int *) * num_of_tuples);
+    searchRtreeIntoBuffer(rtree, everything, found, num_of_tuples);
+    int *coordinates = malloc(sizeof(int) * numofdimensions * (size_t)num_of_tuples);
+    for (long int t = 0; t < num_of_tuples; t++)
+        memcpy(coordinates + t * numofdimensions, found[t], sizeof(int) * numofdimensions);
+    free(found);
+    int violations = validate_rtree(rtree);
+    if (kept)
+        printf("aggregates over %ld tuples: kept while loading, %d invariant violations\n", num_of_tuples, violations);
+    else
+        printf("aggregates over %ld tuples: computed in %.3f ms, %d invariant violations\n", num_of_tuples, refresh_time * 1e3, violations);
+    int status = (violations > 0);
+
+    for (int keep = 0; keep < 2; keep++) // the cost of keeping the aggregates while inserting one tuple at a time.
+    {
+        struct Rtree *copy = new_rtree(rtree->max_entries, rtree->min_entries, numofdimensions);
+        copy->split_policy = rtree->split_policy;
+        copy->insert_policy = rtree->insert_policy;
+        if (keep)
+            set_aggregates(copy, rtree->aggregate_value);
+        start = getTimeInSeconds();
+        for (long int t = 0; t < num_of_tuples; t++)
+            insert(copy, coordinates + t * numofdimensions);
+        double insert_time = getTimeInSeconds() - start;
+        violations = validate_rtree(copy);
+        printf("inserts %-15s %.0f inserts/s, %d invariant violations\n", keep ? "with aggregates:" : "without:", num_of_tuples / insert_time, violations);
+        if (violations > 0)
+            status = 1;
+        free_rtree(copy);
+    }
+
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+    Bounds scaled = malloc(sizeof(struct BoundDefiner) * numofdimensions * num_of_queries);
+    int scales[3] = {1, 5, 25}; // side of a window, in percent of the data extent.
+    for (int s = 0; s < 3; s++)
+    {
+        for (int q = 0; q < num_of_queries * numofdimensions; q++) // grows each 1% window around its centre.
+        {
+            long long centre = ((long long)windows[q].dmin + windows[q].dmax) / 2, half = ((long long)windows[q].dmax - windows[q].dmin) * scales[s] / 2;
+            scaled[q].dmin = (centre - half < INT_MIN) ? INT_MIN : (int)(centre - half);
+            scaled[q].dmax = (centre + half > INT_MAX) ? INT_MAX : (int)(centre + half);
+        }
+        int mismatches = 0;
+        long int num_found = 0, nodes_visited = 0, search_nodes_visited = 0;
+        for (int q = 0; q < num_of_queries; q++) // compares the aggregates with those of the tuples listed by a search.
+        {
+            struct AggregateProbe probe = {rtree, {0, 0, INT_MAX, INT_MIN}};
+            searchRtreeWithVisitor(rtree, scaled + q * numofdimensions, addToAggregateVisitor, &probe);
+            struct Aggregate aggregate = aggregateInBounds(rtree, scaled + q * numofdimensions, &nodes_visited);
+            mismatches += memcmp(&aggregate, &probe.aggregate, sizeof(struct Aggregate)) != 0;
+            num_found += aggregate.count;
+            search_nodes_visited += countNodesVisited(numofdimensions, scaled + q * numofdimensions, rtree->root);
+        }
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            aggregateInBounds(rtree, scaled + q * numofdimensions, NULL);
+        double aggregate_time = getTimeInSeconds() - start;
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            countTuplesInBounds(rtree, scaled + q * numofdimensions);
+        double count_time = getTimeInSeconds() - start;
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+        {
+            searchResult result = searchTuplesInGivenBounds(numofdimensions, scaled + q * numofdimensions, rtree->root);
+            if (result != NULL)
+            {
+                free(result->list_of_tuples);
+                free(result);
+            }
+        }
+        double search_time = getTimeInSeconds() - start;
+        printf("windows of %2d%%: %.1f tuples/query, aggregates %.3f us/query and %.1f nodes visited/query, counting %.3f us/query, listing %.3f us/query and %.1f nodes visited/query, %d mismatching queries\n",
+               scales[s], (double)num_found / num_of_queries, aggregate_time * 1e6 / num_of_queries, (double)nodes_visited / num_of_queries, count_time * 1e6 / num_of_queries,
+               search_time * 1e6 / num_of_queries, (double)search_nodes_visited / num_of_queries, mismatches);
+        if (mismatches > 0)
+            status = 1;
+    }
+    free(scaled);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+// Query cache
+// set_query_cache gives a tree a bounded cache of range query results, looked up by searchRtreeCached with the exact window as
+// key. Entries live in a hash table over the windows and are kept in recency order, the least recently used being evicted once
+// the windows and result lists held go over the byte cap. An update only invalidates the cached windows it changes: the windows
+// are also kept as extents in a small R-tree of their own, which insert(), insert_extent, delete_tuple, update_tuple and
+// insert_batch search with the tuple, or the extent, they touch. Dropped entries leave their record in that R-tree, which is
+// harmless since every record is checked against the entry it names, and the R-tree is rebuilt once stale records outnumber
+// the entries. Packing an empty tree clears the cache. The cache is not shared between threads, and concurrent trees have none.
+
+struct CachedQuery // a cached window with the tuples found in it.
+{
+    Bounds bounddefiners;       // the window, owned by the entry.
+    int **list_of_tuples;       // the tuples in the window, or the extents intersecting it.
+    long int num_of_tuples;     // number of tuples in list_of_tuples.
+    size_t bytes;               // memory charged to the entry against the cap.
+    unsigned long long hash;    // hash of the window.
+    int next;                   // next entry of the same bucket, or next free entry.
+    int newer, older;           // neighbours in recency order, -1 at either end.
+    bool used;                  // whether the entry holds a window.
+};
+
+struct QueryCacheStats // what the query cache did so far.
+{
+    unsigned long long hits;          // searches answered from the cache.
+    unsigned long long misses;        // searches that walked the tree.
+    unsigned long long invalidations; // entries dropped because an update reached their window.
+    unsigned long long evictions;     // entries dropped to stay under the byte cap.
+    unsigned long long uncacheable;   // results too large for the cap on their own, which were not kept.
+};
+
+struct QueryCache // bounded cache of range query results, see above.
+{
+    int numofdimensions;          // number of dimensions of the windows.
+    size_t max_bytes;             // cap on the memory held by the entries.
+    size_t bytes;                 // memory held by the entries.
+    struct CachedQuery *entries;  // entries, used or free.
+    int capacity;                 // number of entries allocated.
+    int num_of_entries;           // number of used entries.
+    int first_free;               // first free entry, -1 when all are used.
+    int *buckets;                 // first entry of each bucket of the hash table, -1 when empty.
+    int num_of_buckets;           // number of buckets, a power of two.
+    int newest, oldest;           // ends of the recency order, -1 when the cache is empty.
+    struct Rtree *window_index;   // extent R-tree over the windows, the payload of each record naming its entry.
+    long int num_of_indexed;      // number of records in window_index, stale ones included.
+    struct QueryCacheStats stats; // hits, misses, invalidations and evictions so far.
+};
+
+struct Rtree *newWindowIndex(struct Rtree *rtree) // creates the R-tree holding the cached windows, shaped like the tree.
+{
+    struct Rtree *window_index = new_rtree(rtree->max_entries, rtree->min_entries, rtree->numofdimensions);
+    set_extent_entries(window_index);
+    return window_index;
+}
+
+void resizeQueryCache(struct QueryCache *cache, int capacity) // allocates room for capacity entries and rehashes the used ones into twice as many buckets.
+{
+    cache->entries = realloc(cache->entries, sizeof(struct CachedQuery) * capacity);
+    for (int e = capacity - 1; e >= cache->capacity; e--) // the new entries join the free list.
+    {
+        cache->entries[e].used = false;
+        cache->entries[e].next = cache->first_free;
+        cache->first_free = e;
+    }
+    cache->capacity = capacity;
+    cache->num_of_buckets = 2 * capacity;
+    free(cache->buckets);
+    cache->buckets = malloc(sizeof(int) * cache->num_of_buckets);
+    for (int b = 0; b < cache->num_of_buckets; b++)
+        cache->buckets[b] = -1;
+    for (int e = 0; e < capacity; e++)
+    {
+        if (!cache->entries[e].used)
+            continue;
+        int bucket = cache->entries[e].hash & (cache->num_of_buckets - 1);
+        cache->entries[e].next = cache->buckets[bucket];
+        cache->buckets[bucket] = e;
+    }
+}
+
+bool set_query_cache(struct Rtree *rtree, size_t max_bytes) // gives the R-tree a query cache holding up to max_bytes of windows and results, replacing any previous one. A cap of 0 removes the cache. Returns false for a concurrent tree.
+{
+    if (rtree->concurrent) // readers would update the cache while writers invalidate it.
+        return false;
+    freeQueryCache(rtree->query_cache);
+    rtree->query_cache = NULL;
+    if (max_bytes == 0)
+        return true;
+    struct QueryCache *cache = calloc(1, sizeof(struct QueryCache));
+    cache->numofdimensions = rtree->numofdimensions;
+    cache->max_bytes = max_bytes;
+    cache->first_free = -1;
+    cache->newest = cache->oldest = -1;
+    cache->window_index = newWindowIndex(rtree);
+    resizeQueryCache(cache, 64);
+    rtree->query_cache = cache;
+    return true;
+}
+
+unsigned long long hashWindow(int numofdimensions, Bounds bounddefiners) // FNV-1a hash of the bounds of a window.
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; i < numofdimensions; i++)
+    {
+        hash = (hash ^ (unsigned int)bounddefiners[i].dmin) * 1099511628211ULL;
+        hash = (hash ^ (unsigned int)bounddefiners[i].dmax) * 1099511628211ULL;
+    }
+    return hash ^ (hash >> 32);
+}
+
+int findCachedQuery(struct QueryCache *cache, Bounds bounddefiners, unsigned long long hash) // returns the entry holding the window, or -1.
+{
+    for (int e = cache->buckets[hash & (cache->num_of_buckets - 1)]; e >= 0; e = cache->entries[e].next)
+    {
+        if (cache->entries[e].hash == hash && memcmp(cache->entries[e].bounddefiners, bounddefiners, sizeof(struct BoundDefiner) * cache->numofdimensions) == 0)
+            return e;
+    }
+    return -1;
+}
+
+void unlinkCachedQuery(struct QueryCache *cache, int e) // takes an entry out of the recency order.
+{
+    struct CachedQuery *entry = &cache->entries[e];
+    if (entry->newer >= 0)
+        cache->entries[entry->newer].older = entry->older;
+    else
+        cache->newest = entry->older;
+    if (entry->older >= 0)
+        cache->entries[entry->older].newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+}
+
+void linkCachedQueryAsNewest(struct QueryCache *cache, int e) // puts an entry at the front of the recency order.
+{
+    cache->entries[e].newer = -1;
+    cache->entries[e].older = cache->newest;
+    if (cache->newest >= 0)
+        cache->entries[cache->newest].newer = e;
+    else
+        cache->oldest = e;
+    cache->newest = e;
+}
+
+void dropCachedQuery(struct QueryCache *cache, int e) // releases an entry. Its record in the window index goes stale.
+{
+    struct CachedQuery *entry = &cache->entries[e];
+    int *link = &cache->buckets[entry->hash & (cache->num_of_buckets - 1)];
+    while (*link != e)
+        link = &cache->entries[*link].next;
+    *link = entry->next;
+    unlinkCachedQuery(cache, e);
+    cache->bytes -= entry->bytes;
+    cache->num_of_entries--;
+    free(entry->bounddefiners);
+    free(entry->list_of_tuples);
+    entry->used = false;
+    entry->next = cache->first_free;
+    cache->first_free = e;
+}
+
+void rebuildWindowIndex(struct QueryCache *cache, struct Rtree *rtree) // replaces the window index by one holding only the windows of the used entries.
+{
+    free_rtree(cache->window_index);
+    cache->window_index = newWindowIndex(rtree);
+    cache->num_of_indexed = 0;
+    for (int e = cache->newest; e >= 0; e = cache->entries[e].older, cache->num_of_indexed++)
+        insert_extent(cache->window_index, cache->entries[e].bounddefiners, e);
+}
+
+bool storeCachedQuery(struct Rtree *rtree, Bounds bounddefiners, unsigned long long hash, int **list_of_tuples, long int num_of_tuples) // caches the result of a window, taking over list_of_tuples, and evicts the least recently used entries beyond the cap. Returns false, leaving list_of_tuples to the caller, if the result alone is over the cap.
+{
+    struct QueryCache *cache = rtree->query_cache;
+    size_t bytes = sizeof(struct CachedQuery) + sizeof(struct BoundDefiner) * cache->numofdimensions + sizeof(int *) * num_of_tuples;
+    if (bytes > cache->max_bytes)
+    {
+        cache->stats.uncacheable++;
+        return false;
+    }
+    while (cache->bytes + bytes > cache->max_bytes)
+    {
+        dropCachedQuery(cache, cache->oldest);
+        cache->stats.evictions++;
+    }
+    if (cache->first_free < 0)
+        resizeQueryCache(cache, 2 * cache->capacity);
+    int e = cache->first_free;
+    struct CachedQuery *entry = &cache->entries[e];
+    cache->first_free = entry->next;
+    entry->bounddefiners = malloc(sizeof(struct BoundDefiner) * cache->numofdimensions);
+    memcpy(entry->bounddefiners, bounddefiners, sizeof(struct BoundDefiner) * cache->numofdimensions);
+    entry->list_of_tuples = list_of_tuples;
+    entry->num_of_tuples = num_of_tuples;
+    entry->bytes = bytes;
+    entry->hash = hash;
+    entry->used = true;
+    int bucket = hash & (cache->num_of_buckets - 1);
+    entry->next = cache->buckets[bucket];
+    cache->buckets[bucket] = e;
+    linkCachedQueryAsNewest(cache, e);
+    cache->bytes += bytes;
+    cache->num_of_entries++;
+
+    if (cache->num_of_indexed > 2 * (long int)cache->num_of_entries + 64) // stale records outnumber the entries.
+        rebuildWindowIndex(cache, rtree);
+    else
+    {
+        insert_extent(cache->window_index, bounddefiners, e);
+        cache->num_of_indexed++;
+    }
+    return true;
+}
+
+long int searchRtreeCached(struct Rtree *rtree, Bounds bounddefiners, SearchVisitor visitor, void *context) // searchRtreeWithVisitor through the query cache of the tree, which a miss fills with the whole result. Without a cache, the same as searchRtreeWithVisitor.
+{
+    struct QueryCache *cache = rtree->query_cache;
+    if (cache == NULL)
+        return searchRtreeWithVisitor(rtree, bounddefiners, visitor, context);
+    unsigned long long hash = hashWindow(cache->numofdimensions, bounddefiners);
+    int e = findCachedQuery(cache, bounddefiners, hash);
+    int **list_of_tuples;
+    long int num_of_tuples;
+    bool kept = true; // whether list_of_tuples belongs to the cache.
+    if (e >= 0)
+    {
+        cache->stats.hits++;
+        unlinkCachedQuery(cache, e);
+        linkCachedQueryAsNewest(cache, e);
+        list_of_tuples = cache->entries[e].list_of_tuples;
+        num_of_tuples = cache->entries[e].num_of_tuples;
+    }
+    else
+    {
+        cache->stats.misses++;
+        struct GrowingResult result = {NULL, 0, 0};
+        searchRtreeWithVisitor(rtree, bounddefiners, appendToGrowingResult, &result);
+        list_of_tuples = (result.num_of_tuples > 0) ? realloc(result.list_of_tuples, sizeof(int *) * result.num_of_tuples) : result.list_of_tuples;
+        num_of_tuples = result.num_of_tuples;
+        kept = storeCachedQuery(rtree, bounddefiners, hash, list_of_tuples, num_of_tuples);
+    }
+    long int numofresults = num_of_tuples;
+    for (long int t = 0; visitor != NULL && t < num_of_tuples; t++)
+    {
+        if (!visitor(list_of_tuples[t], context))
+        {
+            numofresults = t + 1;
+            break;
+        }
+    }
+    if (!kept)
+        free(list_of_tuples);
+    return numofresults;
+}
+
+struct WindowInvalidation // context of invalidateWindowVisitor.
+{
+    struct QueryCache *cache; // cache whose entries are dropped.
+    Bounds bounddefiners;     // MBR of the update.
+};
+
+bool invalidateWindowVisitor(int *record, void *context) // SearchVisitor dropping the entry named by a record of the window index, if its window still overlaps the update.
+{
+    struct WindowInvalidation *invalidation = context;
+    struct QueryCache *cache = invalidation->cache;
+    int e = getExtentPayload(cache->numofdimensions, record);
+    if (cache->entries[e].used && overlaps(cache->numofdimensions, invalidation->bounddefiners, cache->entries[e].bounddefiners)) // a stale record may name a free entry, or one reused for another window.
+    {
+        dropCachedQuery(cache, e);
+        cache->stats.invalidations++;
+    }
+    return true;
+}
+
+void invalidateQueryCache(struct Rtree *rtree, Bounds bounddefiners) // drops the cached windows that overlap the MBR of an update.
+{
+    struct QueryCache *cache = rtree->query_cache;
+    if (cache == NULL || cache->num_of_entries == 0)
+        return;
+    struct WindowInvalidation invalidation = {cache, bounddefiners};
+    searchRtreeWithPredicate(cache->window_index, bounddefiners, PREDICATE_INTERSECTS, invalidateWindowVisitor, &invalidation);
+}
+
+void invalidateQueryCacheAtTuple(struct Rtree *rtree, int *tuple) // drops the cached windows containing a point that is inserted, deleted or moved.
+{
+    struct BoundDefiner point[rtree->numofdimensions];
+    for (int i = 0; i < rtree->numofdimensions; i++)
+        point[i].dmin = point[i].dmax = tuple[i];
+    invalidateQueryCache(rtree, point);
+}
+
+void clearQueryCache(struct Rtree *rtree) // drops every cached window, as an update may have reached any of them.
+{
+    struct QueryCache *cache = rtree->query_cache;
+    if (cache == NULL || cache->num_of_entries == 0)
+        return;
+    cache->stats.invalidations += cache->num_of_entries;
+    while (cache->newest >= 0)
+        dropCachedQuery(cache, cache->newest);
+    rebuildWindowIndex(cache, rtree);
+}
+
+void freeQueryCache(struct QueryCache *cache) // releases a query cache with its entries.
+{
+    if (cache == NULL)
+        return;
+    while (cache->newest >= 0)
+        dropCachedQuery(cache, cache->newest);
+    free_rtree(cache->window_index);
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
+
+void dumpQueryCacheStats(struct QueryCache *cache, FILE *out) // writes the state and statistics of a query cache as one line of JSON.
+{
+    struct QueryCacheStats *stats = &cache->stats;
+    fprintf(out, "{\"entries\": %d, \"bytes\": %zu, \"max_bytes\": %zu, \"hits\": %llu, \"misses\": %llu, \"invalidations\": %llu, \"evictions\": %llu, \"uncacheable\": %llu}\n",
+            cache->num_of_entries, cache->bytes, cache->max_bytes, stats->hits, stats->misses, stats->invalidations, stats->evictions, stats->uncacheable);
+}
+
+int benchmarkQueryCache(const char *filename, int max_entries, int min_entries, int numofdimensions, size_t max_bytes, int num_of_operations) // replays a stream of repeated viewport windows with an insert every 20 operations, and some updates and deletes of the inserted tuples, on a tree without a cache, on a tree with a cache of max_bytes, and on one with a quarter of what that cache ended up holding, so that it has to evict. Reports query latency, hit rate, invalidations and evictions, and checks every cached result. Returns 1 if a cached result differed.
+{
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int num_of_windows = 256; // the viewports the clients keep coming back to.
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_windows);
+    struct TupleChecksum *expected = malloc(sizeof(struct TupleChecksum) * num_of_operations); // result of each query without a cache.
+    long int *num_expected = malloc(sizeof(long int) * num_of_operations);
+    size_t caps[3] = {0, max_bytes, 0}; // the last cap is set by the run with max_bytes.
+    int status = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        if (c > 0 && caps[c] == 0)
+            continue;
+        struct Rtree *rtree = new_rtree(max_entries, min_entries, numofdimensions);
+        bulk_load(rtree, coordinates, num_of_tuples, BULK_STR);
+        struct BoundDefiner space[numofdimensions]; // new tuples are drawn from the extent of the data.
+        memcpy(space, rtree->root->bounddefiners, sizeof(struct BoundDefiner) * numofdimensions);
+        set_query_cache(rtree, caps[c]);
+        unsigned long long state = 7; // every run replays the same operations.
+        int num_of_queries = 0, mismatches = 0, num_of_inserted = 0;
+        double query_time = 0;
+        int *inserted = malloc(sizeof(int) * numofdimensions * (num_of_operations / 20 + 1)); // the inserted tuples still in the tree.
+        int tuple[numofdimensions];
+        for (int op = 0; op < num_of_operations; op++)
+        {
+            if (op % 20 == 19 || (op % 20 == 9 && num_of_inserted > 0)) // inserts a random tuple, or moves the last one inserted.
+            {
+                for (int i = 0; i < numofdimensions; i++)
+                    tuple[i] = space[i].dmin + (int)(nextRandom(&state) * ((double)space[i].dmax - space[i].dmin));
+                if (op % 20 == 19)
+                {
+                    insert(rtree, tuple);
+                    num_of_inserted++;
+                }
+                else
+                    update_tuple(rtree, inserted + (num_of_inserted - 1) * numofdimensions, tuple);
+                memcpy(inserted + (num_of_inserted - 1) * numofdimensions, tuple, sizeof(tuple));
+                continue;
+            }
+            if (op % 100 == 59 && num_of_inserted > 0) // deletes the last tuple inserted.
+            {
+                delete_tuple(rtree, inserted + --num_of_inserted * numofdimensions);
+                continue;
+            }
+            int w = (int)(nextRandom(&state) * nextRandom(&state) * num_of_windows); // a few viewports are far more popular than the rest.
+            struct TupleChecksum found = {numofdimensions, 0};
+            double start = getTimeInSeconds();
+            long int num_found = searchRtreeCached(rtree, windows + w * numofdimensions, addToTupleChecksum, &found);
+            query_time += getTimeInSeconds() - start;
+            if (c == 0)
+            {
+                expected[op] = found;
+                num_expected[op] = num_found;
+            }
+            mismatches += (num_found != num_expected[op] || found.total != expected[op].total);
+            num_of_queries++;
+        }
+        if (c == 0)
+            printf("no cache:              %.3f us/query\n", query_time * 1e6 / num_of_queries);
+        else
+        {
+            struct QueryCacheStats *stats = &rtree->query_cache->stats;
+            printf("cache of %9zu bytes: %.3f us/query, %.1f%% hits, %llu invalidations, %llu evictions, %d entries in %zu bytes, %d mismatching queries\n", caps[c],
+                   query_time * 1e6 / num_of_queries, 100.0 * stats->hits / num_of_queries, stats->invalidations, stats->evictions, rtree->query_cache->num_of_entries,
+                   rtree->query_cache->bytes, mismatches);
+            if (c == 1)
+                caps[2] = rtree->query_cache->bytes / 4;
+        }
+        if (mismatches > 0)
+            status = 1;
+        free(inserted);
+        free_rtree(rtree);
+    }
+    free(num_expected);
+    free(expected);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+void searchTreeFile(struct MappedRtree *mapped, Bounds bounddefiners) // searchRTree for a mapped tree file.
+{
+    if (mapped->header->num_of_nodes == 0)
+    {
+        printf("Tree empty\n");
+        return;
+    }
+    long int numofresults = searchMappedRtree(mapped, bounddefiners, NULL, NULL);
+    if (numofresults == 0)
+    {
+        printf("No tuples found in given bounds\n");
+    }
+    else
+    {
+        printf("%ld Tuple(s) found in given bounds :\n", numofresults);
+        searchMappedRtree(mapped, bounddefiners, printTupleVisitor, &mapped->numofdimensions);
+    }
+}
+
+int benchmarkTreeFile(struct Rtree *rtree, const char *filename, const char *tree_filename, int num_of_queries) // saves the R-tree to a tree file, times mapping it, and checks a round trip: every query window must find the same tuples in the mapped file as searchTuplesInGivenBounds finds in memory. Returns 1 if the file cannot be saved or mapped, a window finds different tuples or a flipped bit goes undetected.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0 || rtree->root == NULL)
+    {
+        free(coordinates);
+        return 0;
+    }
+    double start = getTimeInSeconds();
+    if (saveRtree(rtree, tree_filename) != 0)
+    {
+        free(coordinates);
+        return 1;
+    }
+    double save_time = getTimeInSeconds() - start;
+    start = getTimeInSeconds();
+    struct MappedRtree *mapped = mapRtreeFile(tree_filename, false);
+    double map_time = getTimeInSeconds() - start;
+    unmapRtreeFile(mapped);
+    start = getTimeInSeconds();
+    mapped = mapRtreeFile(tree_filename, true);
+    double verify_time = getTimeInSeconds() - start;
+    if (mapped == NULL)
+    {
+        free(coordinates);
+        return 1;
+    }
+    printf("saved %llu nodes, %llu tuples in %.1f MiB in %.3f s, mapped in %.3f ms, checksum verified in %.3f ms\n", (unsigned long long)mapped->header->num_of_nodes,
+           (unsigned long long)mapped->header->num_of_tuples, mapped->size / 1048576.0, save_time, map_time * 1e3, verify_time * 1e3);
+
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+    int mismatches = 0;
+    long int total_results = 0;
+    for (int q = 0; q < num_of_queries; q++) // compares the count and an order-independent checksum of the tuples found.
+    {
+        Bounds window = windows + q * numofdimensions;
+        struct TupleChecksum expected = {numofdimensions, 0}, found = {numofdimensions, 0};
+        long int num_expected = 0;
+        searchResult result = searchTuplesInGivenBounds(numofdimensions, window, rtree->root);
+        if (result != NULL)
+        {
+            num_expected = result->num_of_tuples;
+            for (int i = 0; i < result->num_of_tuples; i++)
+                addToTupleChecksum(result->list_of_tuples[i], &expected);
+            free(result->list_of_tuples);
+            free(result);
+        }
+        long int num_found = searchMappedRtree(mapped, window, addToTupleChecksum, &found);
+        mismatches += (num_found != num_expected || found.total != expected.total);
+        total_results += num_found;
+    }
+
+    double memory_time = INFINITY, file_time = INFINITY;
+    for (int round = 0; round < 3; round++) // counting only, best of 3 rounds, alternating between the tree in memory and the mapped file.
+    {
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            countTuplesInBounds(rtree, windows + q * numofdimensions);
+        memory_time = fmin(memory_time, getTimeInSeconds() - start);
+        start = getTimeInSeconds();
+        for (int q = 0; q < num_of_queries; q++)
+            searchMappedRtree(mapped, windows + q * numofdimensions, NULL, NULL);
+        file_time = fmin(file_time, getTimeInSeconds() - start);
+    }
+    printf("round trip: %d queries, %ld results, %d mismatches; in memory %.0f queries/s, mapped file %.0f queries/s\n", num_of_queries, total_results, mismatches,
+           num_of_queries / memory_time, num_of_queries / file_time);
+    unmapRtreeFile(mapped);
+
+    int status = (mismatches > 0);
+    long int flipped_offset = PAGE_SIZE_BYTES + sizeof(struct FileNode); // first byte of the MBR of the root.
+    FILE *file = fopen(tree_filename, "r+b");                               // flips one bit of the root record, which the checksum must catch, and restores it.
+    if (file != NULL && fseek(file, flipped_offset, SEEK_SET) == 0)
+    {
+        int byte = fgetc(file);
+        fseek(file, flipped_offset, SEEK_SET);
+        fputc(byte ^ 1, file);
+        fflush(file);
+        mapped = mapRtreeFile(tree_filename, true);
+        printf("flipped bit %s\n", mapped == NULL ? "detected by the checksum" : "NOT DETECTED");
+        if (mapped != NULL)
+            status = 1;
+        unmapRtreeFile(mapped);
+        fseek(file, flipped_offset, SEEK_SET);
+        fputc(byte, file);
+    }
+    if (file != NULL)
+        fclose(file);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+int benchmarkPagedRtree(struct Rtree *rtree, const char *filename, const char *tree_filename, int num_of_queries) // builds a paged R-tree from a file behind buffer pools of several sizes and both eviction policies, reporting the pool counters and checking every query against the tree in memory. The last file is reopened to check that it persisted. Returns 1 if a file cannot be opened, a query disagreed or the reopened tree lost tuples.
+{
+    int numofdimensions = rtree->numofdimensions;
+    int num_of_tuples;
+    int *coordinates = read_tuples(filename, numofdimensions, &num_of_tuples);
+    if (coordinates == NULL || num_of_tuples == 0)
+    {
+        free(coordinates);
+        return 0;
+    }
+    int status = 0;
+    Bounds windows = makeQueryWindows(coordinates, num_of_tuples, numofdimensions, num_of_queries);
+    long int *expected = malloc(sizeof(long int) * num_of_queries);
+    for (int q = 0; q < num_of_queries; q++)
+        expected[q] = countTuplesInBounds(rtree, windows + q * numofdimensions);
+    int max_entries = getPagedFanout(numofdimensions);
+    printf("paged tree: %d entries per %d-byte page\n", max_entries, PAGE_SIZE_BYTES);
+
+    const char *policy_names[] = {"LRU", "CLOCK"};
+    for (int policy = BUFFER_LRU; policy <= BUFFER_CLOCK; policy++)
+    {
+        for (int num_of_frames = 16; num_of_frames <= 4096; num_of_frames *= 4)
+        {
+            struct PagedRtree *tree = openPagedRtreeFile(tree_filename, true, numofdimensions, max_entries, getDefaultMinEntries(max_entries), num_of_frames, policy);
+            if (tree == NULL)
+            {
+                status = 1;
+                break;
+            }
+            tree->shape->split_policy = rtree->split_policy;
+            double start = getTimeInSeconds();
+            for (int i = 0; i < num_of_tuples; i++)
+                insertPaged(tree, coordinates + (size_t)i * numofdimensions);
+            double insert_time = getTimeInSeconds() - start;
+            struct BufferPoolStats insert_stats = tree->pool.stats;
+
+            tree->pool.stats = (struct BufferPoolStats){0, 0, 0, 0};
+            int mismatches = 0;
+            start = getTimeInSeconds();
+            for (int q = 0; q < num_of_queries; q++)
+                mismatches += (searchPaged(tree, windows + q * numofdimensions, NULL, NULL) != expected[q]);
+            double query_time = getTimeInSeconds() - start;
+            struct BufferPoolStats query_stats = tree->pool.stats;
+            printf("%-5s %4d pages: %llu pages in file; insert %.0f tuples/s, hit rate %.1f%%, %llu evictions, %llu writes; query %.0f queries/s, hit rate %.1f%%, %llu misses, %d mismatches\n",
+                   policy_names[policy], num_of_frames, (unsigned long long)tree->header.num_of_pages, num_of_tuples / insert_time,
+                   100.0 * insert_stats.hits / (insert_stats.hits + insert_stats.misses), insert_stats.evictions, insert_stats.writes, num_of_queries / query_time,
+                   100.0 * query_stats.hits / (query_stats.hits + query_stats.misses), query_stats.misses, mismatches);
+            if (mismatches > 0)
+                status = 1;
+            closePagedRtree(tree);
+        }
+    }
+
+    struct PagedRtree *tree = openPagedRtreeFile(tree_filename, false, 0, 0, 0, 16, BUFFER_LRU);
+    if (tree != NULL)
+    {
+        struct BoundDefiner whole_space[numofdimensions];
+        fillWholeSpace(whole_space, numofdimensions);
+        long int num_found = searchPaged(tree, whole_space, NULL, NULL);
+        printf("reopened %s: %ld of %d tuples found, %llu recorded\n", tree_filename, num_found, num_of_tuples, (unsigned long long)tree->header.num_of_tuples);
+        if (num_found != num_of_tuples || tree->header.num_of_tuples != (unsigned long long)num_of_tuples)
+            status = 1;
+        closePagedRtree(tree);
+    }
+    else
+    {
+        status = 1;
+    }
+    free(expected);
+    free(windows);
+    free(coordinates);
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_entries = 4, min_entries = 0, numofdimensions = 2; // a min_entries of 0 is derived from max_entries.
+    size_t node_bytes = 0;                                     // if set, max_entries is derived from the size of a node in bytes.
+    enum NodeLayout node_layout = LAYOUT_POINTERS;
+    for (int i = 1; i < argc; i++)                             // the shape of the tree is parsed first, since the arguments of --search and --knn depend on the number of dimensions.
+    {
+        if (strcmp(argv[i], "--max-entries") == 0 && i + 1 < argc)
+            max_entries = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--min-entries") == 0 && i + 1 < argc)
+            min_entries = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--dims") == 0 && i + 1 < argc)
+            numofdimensions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--page") == 0)
+            node_bytes = PAGE_SIZE_BYTES;
+        else if (strcmp(argv[i], "--soa") == 0)
+            node_layout = LAYOUT_SOA;
+        else if (strcmp(argv[i], "--cache-lines") == 0 && i + 1 < argc)
+            node_bytes = (size_t)atoi(argv[++i]) * CACHE_LINE_BYTES;
+    }
+    if (numofdimensions >= 1 && node_bytes > 0)
+        max_entries = getFanoutForNodeBytes(node_bytes, numofdimensions);
+    if (min_entries == 0)
+        min_entries = getDefaultMinEntries(max_entries);
+    if (max_entries < 2 || min_entries < 1 || min_entries > max_entries / 2 || numofdimensions < 1)
+    {
+        printf("Invalid tree shape: M %d, m %d, %d dimensions (expected M >= 2, 1 <= m <= M / 2 and at least one dimension)\n", max_entries, min_entries, numofdimensions);
+        return 1;
+    }
+    struct Rtree *rtree = new_rtree_with_layout(max_entries, min_entries, numofdimensions, node_layout);
+
+    enum BulkLoadMethod method = BULK_NONE;
+    const char *filename = NULL;
+    char **search_args = NULL; // the 2 * numofdimensions corners of the search window, if one was given.
+    char **knn_args = NULL;    // k followed by the numofdimensions coordinates of the query point, if a nearest neighbour query was given.
+    int bench_knn_k = 0, bench_knn_queries = 0;
+    int mixed_operations = 0;
+    bool bench_split = false;
+    bool bench_fanout = false;
+    bool bench_kernels = false;
+    bool bench_layout = false;
+    int bench_threads = 0;
+    int bench_readers = 0, bench_writers = 0;
+    int ingest_threads = 0, bench_ingest_threads = 0;
+    bool bench_batch = false;
+    bool bench_buffered = false;
+    bool bench_workloads = false;
+    bool stats = false;
+    bool bench_extents = false;
+    int bench_join_threads = 0;
+    bool bench_compact = false;
+    const char *aggregate_arg = NULL; // count, payload or a dimension: what the node aggregates keep, if --aggregates was given.
+    bool bench_aggregates = false;
+    size_t query_cache_bytes = 0, bench_cache_bytes = 0; // caps of the query cache of the tree and of the caches in the cache benchmark, 0 for none.
+    enum SpatialPredicate predicate = PREDICATE_INTERSECTS; // how --search matches entries against its window.
+    int workload_size = 100000, workload_distribution = -1; // a distribution of -1 runs them all.
+    enum BenchFormat bench_format = FORMAT_JSON;
+    const char *bench_out_filename = NULL; // file receiving the workload results, stdout if not given.
+    const char *save_filename = NULL;        // tree file to write once the tree is built.
+    const char *load_filename = NULL;        // tree file to map and search instead of building a tree.
+    const char *bench_tree_filename = NULL;  // tree file used by the round-trip benchmark.
+    bool verify_checksum = false;
+    const char *bench_paged_filename = NULL; // paged tree file used by the buffer pool benchmark.
+    enum DistanceMetric metric = DISTANCE_EUCLIDEAN_SQUARED;
+    bool quiet = false; // skips printing the tree, which is useful for large files and benchmarks.
+    for (int i = 1; i < argc; i++) // parses the command line: [--quiet] [--bulk str|hilbert] [--search min... max...] [--knn k point...] [--manhattan] [--bench-knn k queries] [--mixed operations] [--split quadratic|linear|rstar] [--insert guttman|rstar] [--bench-split] [--bench-fanout] [--generic-kernel] [--bench-kernels] [--bench-layout] [--bench-threads max_threads] [--bench-concurrent readers writers] [--ingest threads] [--bench-ingest max_threads] [--bench-batch] [--buffered capacity] [--bench-buffered] [--stats] [--extents] [--predicate intersects|contains|within] [--bench-compact] [--aggregates count|payload|dimension] [--bench-aggregates] [--query-cache bytes] [--bench-cache bytes] [--save tree_file] [--bench-file tree_file] [--bench-paged paged_file] filename, or --load tree_file [--verify] [--search min... max...], or --bench-workloads [--workload-size tuples] [--distribution uniform|gaussian|skewed|line] [--bench-format json|csv] [--bench-out file], or --bench-extents and/or --bench-join max_threads [--workload-size rectangles] [--distribution ...], after the shape options above
+    {
+        if (strcmp(argv[i], "--bulk") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "str") == 0)
+                method = BULK_STR;
+            else if (strcmp(argv[i], "hilbert") == 0)
+                method = BULK_HILBERT;
+            else
+            {
+                printf("Unknown bulk load method: %s (expected str or hilbert)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--search") == 0 && i + 2 * rtree->numofdimensions < argc)
+        {
+            search_args = argv + i + 1;
+            i += 2 * rtree->numofdimensions;
+        }
+        else if (strcmp(argv[i], "--knn") == 0 && i + 1 + rtree->numofdimensions < argc)
+        {
+            knn_args = argv + i + 1;
+            i += 1 + rtree->numofdimensions;
+        }
+        else if (strcmp(argv[i], "--mixed") == 0 && i + 1 < argc)
+        {
+            mixed_operations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--split") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "quadratic") == 0)
+                rtree->split_policy = SPLIT_QUADRATIC;
+            else if (strcmp(argv[i], "linear") == 0)
+                rtree->split_policy = SPLIT_LINEAR;
+            else if (strcmp(argv[i], "rstar") == 0)
+                rtree->split_policy = SPLIT_RSTAR;
+            else
+            {
+                printf("Unknown split policy: %s (expected quadratic, linear or rstar)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--insert") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "guttman") == 0)
+                rtree->insert_policy = INSERT_GUTTMAN;
+            else if (strcmp(argv[i], "rstar") == 0)
+                rtree->insert_policy = INSERT_RSTAR;
+            else
+            {
+                printf("Unknown insert policy: %s (expected guttman or rstar)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-split") == 0)
+        {
+            bench_split = true;
+        }
+        else if (strcmp(argv[i], "--bench-fanout") == 0)
+        {
+            bench_fanout = true;
+        }
+        else if (strcmp(argv[i], "--bench-kernels") == 0)
+        {
+            bench_kernels = true;
+        }
+        else if (strcmp(argv[i], "--bench-layout") == 0)
+        {
+            bench_layout = true;
+        }
+        else if (strcmp(argv[i], "--bench-threads") == 0 && i + 1 < argc)
+        {
+            bench_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-concurrent") == 0 && i + 2 < argc)
+        {
+            bench_readers = atoi(argv[i + 1]);
+            bench_writers = atoi(argv[i + 2]);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--ingest") == 0 && i + 1 < argc)
+        {
+            ingest_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-ingest") == 0 && i + 1 < argc)
+        {
+            bench_ingest_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-batch") == 0)
+        {
+            bench_batch = true;
+        }
+        else if (strcmp(argv[i], "--buffered") == 0 && i + 1 < argc)
+        {
+            set_write_buffer(rtree, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--bench-buffered") == 0)
+        {
+            bench_buffered = true;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            stats = true;
+        }
+        else if (strcmp(argv[i], "--extents") == 0)
+        {
+            if (!set_extent_entries(rtree))
+            {
+                printf("Extent trees use the pointer layout, so --extents cannot be combined with --soa\n");
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--predicate") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (predicate = PREDICATE_WITHIN; (int)predicate >= 0; predicate--)
+                if (strcmp(argv[i], predicate_names[predicate]) == 0)
+                    break;
+            if ((int)predicate < 0)
+            {
+                printf("Unknown predicate: %s (expected intersects, contains or within)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-extents") == 0)
+        {
+            bench_extents = true;
+        }
+        else if (strcmp(argv[i], "--bench-join") == 0 && i + 1 < argc)
+        {
+            bench_join_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-compact") == 0)
+        {
+            bench_compact = true;
+        }
+        else if (strcmp(argv[i], "--aggregates") == 0 && i + 1 < argc)
+        {
+            aggregate_arg = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-aggregates") == 0)
+        {
+            bench_aggregates = true;
+        }
+        else if (strcmp(argv[i], "--query-cache") == 0 && i + 1 < argc)
+        {
+            query_cache_bytes = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-cache") == 0 && i + 1 < argc)
+        {
+            bench_cache_bytes = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-workloads") == 0)
+        {
+            bench_workloads = true;
+        }
+        else if (strcmp(argv[i], "--workload-size") == 0 && i + 1 < argc)
+        {
+            workload_size = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--distribution") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (workload_distribution = NUM_OF_DISTRIBUTIONS - 1; workload_distribution >= 0; workload_distribution--)
+                if (strcmp(argv[i], distribution_names[workload_distribution]) == 0)
+                    break;
+            if (workload_distribution < 0)
+            {
+                printf("Unknown distribution: %s (expected uniform, gaussian, skewed or line)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-format") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "json") == 0)
+                bench_format = FORMAT_JSON;
+            else if (strcmp(argv[i], "csv") == 0)
+                bench_format = FORMAT_CSV;
+            else
+            {
+                printf("Unknown benchmark format: %s (expected json or csv)\n", argv[i]);
+                free_rtree(rtree);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc)
+        {
+            bench_out_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+        {
+            save_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc)
+        {
+            load_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-file") == 0 && i + 1 < argc)
+        {
+            bench_tree_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-paged") == 0 && i + 1 < argc)
+        {
+            bench_paged_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            verify_checksum = true;
+        }
+        else if (strcmp(argv[i], "--generic-kernel") == 0)
+        {
+            rtree->dimension_kernel = KERNEL_GENERIC;
+        }
+        else if (strcmp(argv[i], "--page") == 0 || strcmp(argv[i], "--soa") == 0)
+        {
+            // already parsed with the shape of the tree.
+        }
+        else if ((strcmp(argv[i], "--max-entries") == 0 || strcmp(argv[i], "--min-entries") == 0 || strcmp(argv[i], "--dims") == 0 || strcmp(argv[i], "--cache-lines") == 0) && i + 1 < argc)
+        {
+            i++; // already parsed with the shape of the tree.
+        }
+        else if (strcmp(argv[i], "--quiet") == 0)
+        {
+            quiet = true;
+        }
+        else if (strcmp(argv[i], "--manhattan") == 0)
+        {
+            metric = DISTANCE_MANHATTAN;
+        }
+        else if (strcmp(argv[i], "--bench-knn") == 0 && i + 2 < argc)
+        {
+            bench_knn_k = atoi(argv[i + 1]);
+            bench_knn_queries = atoi(argv[i + 2]);
+            i += 2;
+        }
+        else
+        {
+            filename = argv[i];
+        }
+    }
+    if (load_filename != NULL) // a saved tree is searched in place, without building one.
+    {
+        double start = getTimeInSeconds();
+        struct MappedRtree *mapped = mapRtreeFile(load_filename, verify_checksum);
+        free_rtree(rtree);
+        if (mapped == NULL)
+            return 1;
+        if (mapped->numofdimensions != numofdimensions && search_args != NULL)
+        {
+            printf("The tree file has %d dimensions, pass --dims %d with --search\n", mapped->numofdimensions, mapped->numofdimensions);
+            unmapRtreeFile(mapped);
+            return 1;
+        }
+        printf("Mapped %s: %llu tuples, %u levels in %.3f ms\n", load_filename, (unsigned long long)mapped->header->num_of_tuples, mapped->header->height, (getTimeInSeconds() - start) * 1e3);
+        if (search_args != NULL)
+        {
+            struct BoundDefiner window[numofdimensions];
+            for (int i = 0; i < numofdimensions; i++)
+            {
+                window[i].dmin = atoi(search_args[i]);
+                window[i].dmax = atoi(search_args[numofdimensions + i]);
+            }
+            searchTreeFile(mapped, window);
+        }
+        unmapRtreeFile(mapped);
+        return 0;
+    }
+    if (bench_workloads) // the workloads generate their own tuples, so no file is read.
+    {
+        int status = benchmarkWorkloads(rtree, workload_size, workload_distribution, bench_format, bench_out_filename, 10000);
+        free_rtree(rtree);
+        return status;
+    }
+    if (bench_extents || bench_join_threads > 0) // the rectangles are generated too.
+    {
+        int status = 0;
+        if (bench_extents)
+            status |= benchmarkExtents(rtree, workload_size, workload_distribution, 1000);
+        if (bench_join_threads > 0)
+            status |= benchmarkSpatialJoin(rtree, workload_size, workload_distribution, bench_join_threads);
+        free_rtree(rtree);
+        return status;
+    }
+    if (!quiet)
+        printRtree(rtree);
+    if (filename == NULL)
+    {
+        printf("Please provide a filename\n");
+        free_rtree(rtree);
+        return 1;
+    }
+
+    if (aggregate_arg != NULL) // the aggregates are kept from the first insertion on.
+    {
+        int value_index = -2; // refused by set_aggregates.
+        if (strcmp(aggregate_arg, "count") == 0)
+            value_index = -1;
+        else if (strcmp(aggregate_arg, "payload") == 0 && rtree->extent_entries)
+            value_index = 2 * rtree->numofdimensions;
+        else if (aggregate_arg[0] >= '0' && aggregate_arg[0] <= '9' && atoi(aggregate_arg) < rtree->numofdimensions)
+            value_index = atoi(aggregate_arg);
+        if (!set_aggregates(rtree, value_index))
+        {
+            printf("Unknown aggregate value: %s (expected count, payload with --extents, or a dimension below %d)\n", aggregate_arg, rtree->numofdimensions);
+            free_rtree(rtree);
+            return 1;
+        }
+    }
+    if (query_cache_bytes > 0)
+        set_query_cache(rtree, query_cache_bytes);
+    if (rtree->extent_entries) // extents are inserted one by one, whatever the bulk load or ingest options.
+        read_extents_and_insert(rtree, filename);
+    else if (ingest_threads > 0) // the pipeline always packs, with STR unless Hilbert packing was asked for.
+    {
+        struct IngestTimings timings;
+        if (parallelIngest(rtree, filename, (method == BULK_NONE) ? BULK_STR : method, ingest_threads, &timings) == 0)
+        {
+            printf("ingest with %d threads: ", ingest_threads);
+            printIngestTimings(&timings);
+            printf("\n");
+        }
+    }
+    else if (method == BULK_NONE)
+        read_tuples_and_insert(rtree, filename);
+    else
+        read_tuples_and_bulk_load(rtree, filename, method);
+    if (!quiet)
+        printRtree(rtree);
+    if (save_filename != NULL && saveRtree(rtree, save_filename) == 0)
+        printf("Saved the tree to %s\n", save_filename);
+    if (search_args != NULL) // searches the window given by its lower corner followed by its upper corner.
+    {
+        struct BoundDefiner window[rtree->numofdimensions];
+        for (int i = 0; i < rtree->numofdimensions; i++)
+        {
+            window[i].dmin = atoi(search_args[i]);
+            window[i].dmax = atoi(search_args[rtree->numofdimensions + i]);
+        }
+        searchRTreeWithPredicate(window, rtree, predicate);
+        if (rtree->aggregates) // the aggregate of the window, read from the node aggregates. It always counts the entries intersecting the window.
+        {
+            long int nodes_visited = 0;
+            struct Aggregate aggregate = aggregateInBounds(rtree, window, &nodes_visited);
+            printf("Aggregate of the window (%ld nodes visited): ", nodes_visited);
+            printAggregate(rtree, &aggregate);
+        }
+        if (stats) // the same window through the counting search.
+        {
+            struct QueryCounters counters = {0, 0, 0, 0};
+            searchResult result = (rtree->root != NULL) ? searchEntriesWithPredicate(rtree->numofdimensions, window, predicate, rtree->root, &counters) : NULL;
+            if (result != NULL)
+            {
+                free(result->list_of_tuples);
+                free(result);
+            }
+            dumpQueryCounters(&counters, stdout);
+        }
+    }
+    if (stats)
+        dumpTreeStatistics(rtree, stdout);
+    if (stats && rtree->query_cache != NULL)
+        dumpQueryCacheStats(rtree->query_cache, stdout);
+    if (knn_args != NULL) // finds the k tuples nearest to the given point.
+    {
+        int point[rtree->numofdimensions];
+        for (int i = 0; i < rtree->numofdimensions; i++)
+            point[i] = atoi(knn_args[1 + i]);
+        printNearestNeighbours(rtree, point, atoi(knn_args[0]), metric);
+    }
+    int status = 0; // 1 once a run that checks its results finds a wrong one.
+    if (bench_knn_k > 0)
+        status |= benchmarkNearestNeighbours(rtree, bench_knn_k, bench_knn_queries);
+    if (mixed_operations > 0)
+        status |= runMixedWorkload(rtree, mixed_operations);
+    if (bench_split)
+        status |= benchmarkSplitPolicies(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, 1000);
+    if (bench_fanout)
+        status |= benchmarkFanouts(filename, rtree->numofdimensions, rtree->split_policy, rtree->insert_policy, 1000);
+    if (bench_kernels)
+        benchmarkDimensionKernels(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, 100000);
+    if (bench_layout)
+        status |= benchmarkNodeLayouts(filename, rtree->numofdimensions, rtree->split_policy, rtree->insert_policy, 100000);
+    if (bench_threads > 0)
+        status |= benchmarkThreads(rtree, filename, bench_threads);
+    if (bench_writers > 0)
+        status |= benchmarkConcurrentAccess(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, bench_readers, bench_writers);
+    if (bench_tree_filename != NULL)
+        status |= benchmarkTreeFile(rtree, filename, bench_tree_filename, 100000);
+    if (bench_paged_filename != NULL)
+        status |= benchmarkPagedRtree(rtree, filename, bench_paged_filename, 10000);
+    if (bench_ingest_threads > 0)
+        status |= benchmarkIngest(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, rtree->node_layout, (method == BULK_NONE) ? BULK_STR : method, bench_ingest_threads);
+    if (bench_batch)
+        status |= benchmarkBatchInsert(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, rtree->node_layout, rtree->split_policy, 10000);
+    if (bench_buffered)
+        status |= benchmarkBufferedInsert(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, rtree->node_layout, rtree->split_policy, 10000);
+    if (bench_compact)
+        status |= benchmarkCompactRtree(rtree, 10000);
+    if (bench_aggregates)
+        status |= benchmarkAggregates(rtree, 10000);
+    if (bench_cache_bytes > 0)
+        status |= benchmarkQueryCache(filename, rtree->max_entries, rtree->min_entries, rtree->numofdimensions, bench_cache_bytes, 100000);
+    free_rtree(rtree);
+
+    // run the script file
+
+    return status;
+}